@@ -0,0 +1,19 @@
+mov R0 #0
+mov R1 #1
+mov R2 #50000
+mov R5 #3
+mov R6 #0
+mov R7 #5
+add R0 R0 R1
+mod R3 R0 R5
+cmp R3 R6
+jne 11
+add R4 R4 R1
+mod R8 R0 R7
+cmp R8 R6
+je 15
+add R9 R9 R1
+cmp R0 R2
+jlt 6
+mov M1 R4
+mov M2 R9
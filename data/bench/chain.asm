@@ -0,0 +1,17 @@
+mov R0 #0
+mov R1 #1
+mov R2 #20000
+mov R3 #7
+mov R4 #2
+add R3 R3 R1
+mul R3 R3 R4
+sub R3 R3 R1
+div R3 R3 R4
+add R3 R3 R1
+mul R3 R3 R1
+sub R3 R3 R1
+mod R3 R3 R2
+add R0 R0 R1
+cmp R0 R2
+jlt 5
+mov M1 R3
@@ -0,0 +1,19 @@
+mov R0 #0
+mov R1 #1
+mov R2 #20000
+mov R3 #2
+add R8 R8 R1
+add R9 R9 R1
+add R10 R10 R1
+sub R11 R11 R1
+mul R12 R3 R3
+add R13 R13 R1
+sub R14 R14 R1
+mul R15 R1 R3
+add R16 R16 R1
+add R17 R17 R1
+add R0 R0 R1
+cmp R0 R2
+jlt 4
+mov M1 R8
+mov M2 R16
@@ -0,0 +1,7 @@
+mov R0 #0
+mov R1 #1
+mov R2 #200000
+add R0 R0 R1
+cmp R0 R2
+jlt 3
+mov M1 R0
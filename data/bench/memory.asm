@@ -0,0 +1,19 @@
+mov R0 #0
+mov R1 #1
+mov R2 #20000
+mov M1 R1
+mov M2 R1
+mov R3 M1
+mov R4 M2
+add R5 R3 R4
+mov M3 R5
+mov R6 M3
+mov M1000 R6
+mov R7 M1000
+mov M2000 R7
+mov M100000 R0
+mov R8 M100000
+add R0 R0 R1
+cmp R0 R2
+jlt 3
+mov M4 R8
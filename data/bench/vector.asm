@@ -0,0 +1,29 @@
+mov R0 #0
+mov R1 #1
+mov R2 #20000
+mov R3 #3
+mov M1 R1
+mov M2 R3
+mov M3 R1
+mov M4 R3
+mov M11 R3
+mov M12 R1
+mov M13 R3
+mov M14 R1
+vld V0 M1
+vld V1 M11
+vadd V2 V0 V1
+vmul V3 V2 V1
+vst M21 V3
+vld V4 M21
+vadd V5 V4 V0
+vst M31 V5
+mov M12 R0
+vld V6 M10
+vmul V7 V6 V6
+vst M41 V7
+add R0 R0 R1
+cmp R0 R2
+jlt 12
+mov R4 M33
+mov M50 R4
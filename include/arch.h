@@ -5,6 +5,8 @@
 #include <generic.h>
 #include <tokens.h>
 #include <stdbool.h>
+#include <cache.h>
+#include <ram.h>
 
 /*
     Description of architecture emulated in tomasulo
@@ -15,32 +17,209 @@
     LICENCE: GPL 3.0
 */
 
+/*
+    Parameters in #ifndef can be overridden at compile time
+    (make ARCH="-DRS_ADD_SUB_SIZE=4"), scripts/sweep.sh builds one simulator per config
+*/
+
 /* CYCLES */
+#ifndef CYCLES_MOV_REG
 #define CYCLES_MOV_REG 1
+#endif
+#ifndef CYCLES_MOV_MEM
 #define CYCLES_MOV_MEM 5
+#endif
+#ifndef CYCLES_ADD
 #define CYCLES_ADD 5
+#endif
+#ifndef CYCLES_SUB
 #define CYCLES_SUB 5
+#endif
+#ifndef CYCLES_MUL
 #define CYCLES_MUL 10
+#endif
+#ifndef CYCLES_DIV
 #define CYCLES_DIV 10
+#endif
+#ifndef CYCLES_MOD
 #define CYCLES_MOD 10
+#endif
+#ifndef CYCLES_CMP
 #define CYCLES_CMP 2
+#endif
+#ifndef CYCLES_VADD
+#define CYCLES_VADD 6
+#endif
+#ifndef CYCLES_VMUL
+#define CYCLES_VMUL 12
+#endif
+
+/*
+    Data caches between IO buffers and RAM, sizes in bytes.
+    Memory access costs hit / miss latency of caches,
+    miss in the last level cache costs also CYCLES_MOV_MEM
+*/
+#ifndef L1_ENABLED
+#define L1_ENABLED 1
+#endif
+#ifndef L1_SIZE
+#define L1_SIZE 512
+#endif
+#ifndef L1_ASSOC
+#define L1_ASSOC 2
+#endif
+#ifndef L1_LINE_SIZE
+#define L1_LINE_SIZE 32
+#endif
+#ifndef L1_HIT_CYCLES
+#define L1_HIT_CYCLES 1
+#endif
+#ifndef L1_MISS_CYCLES
+#define L1_MISS_CYCLES 1
+#endif
+#define L1_REPLACEMENT CACHE_REPLACEMENT_LRU
+
+#ifndef L2_ENABLED
+#define L2_ENABLED 0
+#endif
+#ifndef L2_SIZE
+#define L2_SIZE 4096
+#endif
+#ifndef L2_ASSOC
+#define L2_ASSOC 4
+#endif
+#ifndef L2_LINE_SIZE
+#define L2_LINE_SIZE 64
+#endif
+#ifndef L2_HIT_CYCLES
+#define L2_HIT_CYCLES 3
+#endif
+#ifndef L2_MISS_CYCLES
+#define L2_MISS_CYCLES 2
+#endif
+#define L2_REPLACEMENT CACHE_REPLACEMENT_LRU
+
+/*
+    Front end fetches up to FETCH_WIDTH instructions per cycle into fetch queue,
+    issue takes them from queue in the next cycle. Fetch follows static prediction
+    of jumps (backward taken, forward not taken) and predicted taken jump ends fetch in cycle
+*/
+#ifndef FETCH_QUEUE_SIZE
+#define FETCH_QUEUE_SIZE 8
+#endif
+#ifndef FETCH_WIDTH
+#define FETCH_WIDTH 2
+#endif
+
+/*
+    Loop buffer holds decoded body of small loop (backward jump taken twice in a row),
+    fetch streams loop from buffer without decoding and across loop closing jump
+*/
+#ifndef LOOP_BUFFER_SIZE
+#define LOOP_BUFFER_SIZE 16
+#endif
 
 /* registers R0 - R31 */
 #define REGISTERS_NUM 32
 
+/*
+    Vector registers V0 - V7 of VECTOR_LENGTH words each,
+    vld / vst move contiguous range of VECTOR_LENGTH words through load / write buffers
+    (one cache access per touched line)
+*/
+#define VREGISTERS_NUM 8
+#ifndef VECTOR_LENGTH
+#define VECTOR_LENGTH 4
+#endif
+#if VECTOR_LENGTH < 1 || (VECTOR_LENGTH & (VECTOR_LENGTH - 1)) != 0
+#error "VECTOR_LENGTH must be power of 2"
+#endif
+
 /* buffers to load from mem to reg */
+#ifndef LOAD_BUFFER_SIZE
 #define LOAD_BUFFER_SIZE 3
+#endif
 
 /* buffers to write reg to memory */
+#ifndef WRITE_BUFFER_SIZE
 #define WRITE_BUFFER_SIZE 3
+#endif
 
 /* reservation station for add / sub and mul / div / mod */
+#ifndef RS_ADD_SUB_SIZE
 #define RS_ADD_SUB_SIZE 3
+#endif
+#ifndef RS_MUL_DIV_MOD_SIZE
 #define RS_MUL_DIV_MOD_SIZE 2
+#endif
+
+/* reservation station for vadd / vmul */
+#ifndef RS_VECTOR_SIZE
+#define RS_VECTOR_SIZE 2
+#endif
+
+/*
+    functional units for add / sub, mul / div / mod and cmp
+    Latency of op is set by CYCLES_*, initiation interval (II) is number of cycles
+    between 2 ops accepted by one unit, so unit with II = 1 is fully pipelined
+    and unit with II = latency is not pipelined at all.
+    RSC is released when op is dispatched to unit
+*/
+#ifndef FU_ADD_SUB_NUM
+#define FU_ADD_SUB_NUM 1
+#endif
+#ifndef FU_MUL_DIV_MOD_NUM
+#define FU_MUL_DIV_MOD_NUM 1
+#endif
+#ifndef FU_CMP_NUM
+#define FU_CMP_NUM 1
+#endif
+#ifndef FU_VECTOR_NUM
+#define FU_VECTOR_NUM 1
+#endif
+
+#ifndef II_ADD_SUB
+#define II_ADD_SUB 1
+#endif
+#ifndef II_MUL_DIV_MOD
+#define II_MUL_DIV_MOD 1
+#endif
+#ifndef II_CMP
+#define II_CMP 1
+#endif
+#ifndef II_VECTOR
+#define II_VECTOR 1
+#endif
+
+/*
+    max ops in flight in one unit, op holds slot of pipeline for its latency + 1 cycles
+    (dispatch cycle included), so fully pipelined unit (II = 1) needs FU_LATENCY_MAX + 1 slots
+*/
+#define __ARCH_MAX(a, b) ((a) > (b) ? (a) : (b))
+#define FU_LATENCY_MAX \
+    __ARCH_MAX(__ARCH_MAX(__ARCH_MAX(CYCLES_ADD, CYCLES_SUB), __ARCH_MAX(CYCLES_MUL, CYCLES_DIV)), \
+               __ARCH_MAX(__ARCH_MAX(CYCLES_MOD, CYCLES_CMP), __ARCH_MAX(CYCLES_VADD, CYCLES_VMUL)))
 
-#define RAM_SIZE 64
+#ifndef FU_PIPELINE_DEPTH
+#define FU_PIPELINE_DEPTH (FU_LATENCY_MAX + 1)
+#endif
+#if FU_PIPELINE_DEPTH < FU_LATENCY_MAX + 1
+#error "FU_PIPELINE_DEPTH is smaller than the longest latency of unit + 1"
+#endif
+
+/* simultaneous multithreading, threads share everything but architectural state */
+#define SMT_THREADS_MAX 4
+
+/* load / store queue tracks every memory access in program order */
+#define LOAD_STORE_QUEUE_SIZE (LOAD_BUFFER_SIZE + WRITE_BUFFER_SIZE)
 
 typedef DWORD reg_t;
+
+/*
+    Value of vector register, host SIMD by GCC vector extension
+    (alignment of word, so it can live in any struct or malloced memory)
+*/
+typedef reg_t vreg_t __attribute__((vector_size(sizeof(reg_t) * VECTOR_LENGTH), aligned(sizeof(reg_t))));
 typedef DWORD program_counter_t;
 typedef int compare_flag_t;
 
@@ -59,16 +238,10 @@ typedef enum
     JOB_STORE,
     JOB_CMP,
     JOB_JUMP,
-    JOB_ARYTHMETIC
+    JOB_ARYTHMETIC,
+    JOB_VECTOR
 } job_t;
 
-typedef enum
-{
-    DEPENDENCY_NONE,
-    DEPENDENCY_IO,
-    DEPENDENCY_OP
-} dependency_t;
-
 typedef enum
 {
     DEPENDENCY_FROM_DST  = 0,
@@ -79,25 +252,18 @@ typedef enum
 #define DEPENDENCY_NR_OF_SLOT_IO  2
 #define DEPENDENCY_NR_OF_SLOT_RSC 3
 
-typedef enum
-{
-    WORKER_NONE,
-    WORKER_IO,
-    WORKER_OP
-} worker_t;
+/* tag of instruction in flight (issue order + 1), travels with instruction from RSC to unit,
+   64 bits so it never wraps to TAG_NONE */
+typedef uint64_t tag_t;
 
-typedef struct Dependency
-{
-    dependency_t type;
-    dependency_slot_t slot;
-    __extension__ union
-    {
-        struct IO_info *io;
-        struct Reservation_station_chunk *rsc;
-    };
-} Dependency;
+#define TAG_NONE 0
 
-typedef Dependency Worker;
+/* value of source operand, captured at issue or from broadcast of its producer */
+typedef union Operand_value
+{
+    reg_t val;
+    vreg_t vval;
+} Operand_value;
 
 /* Register information (job, state, value) */
 typedef struct Register_info
@@ -108,29 +274,51 @@ typedef struct Register_info
     state_t state;
     job_t job;
     arythemtic_t aryth_type;
-
-    Worker worker;
-    dependency_slot_t worker_slot;
 } Register_info;
 
+/* Vector register information (job, state, value) */
+typedef struct Vector_register_info
+{
+    uint32_t nr;
+    vreg_t val;
+
+    state_t state;
+    job_t job;
+} Vector_register_info;
+
+/* register alias table entry: the last instruction in flight which writes register */
+typedef struct Rat_entry
+{
+    tag_t writer; /* TAG_NONE iff value is in register */
+} Rat_entry;
+
+typedef struct Register_alias_table
+{
+    Rat_entry entry[REGISTERS_NUM];
+    Rat_entry ventry[VREGISTERS_NUM];
+} Register_alias_table;
 
 typedef struct Registers
 {
     Register_info regs[REGISTERS_NUM];
+    Vector_register_info vregs[VREGISTERS_NUM];
 } Registers;
 
-typedef struct RAM
-{
-    DWORD memory[RAM_SIZE];
-} RAM;
-
 /* info about instructions */
 typedef struct Instructions_status
 {
+    uint64_t id; /* position in issue order */
+    uint32_t thread; /* hardware thread */
     uint32_t issue_cycle; /* read fetch decode (as 1 time) */
     uint32_t exec_cycle; /* execute time */
+    uint32_t start_cycle; /* all operands ready, job started */
+    bool started;
+    int32_t latency; /* time of job set at issue */
 
-    Token *token;
+    struct Critical_path_node *node; /* node in dependency DAG, released at retire */
+
+    Token *token; /* NULL iff status is free */
+    struct Instructions_status *next; /* next free status */
 } Instructions_status;
 
 /* common I/O info */
@@ -144,12 +332,75 @@ typedef struct IO_info
 
     int32_t wait_time; /* time to end */
 
-    bool has_dependency[DEPENDENCY_NR_OF_SLOT_IO]; /* we depened from another op */
-    Dependency dependency[DEPENDENCY_NR_OF_SLOT_IO]; /* this depends from us */
+    tag_t tag;
+    tag_t wait_tag[DEPENDENCY_NR_OF_SLOT_IO]; /* producer of operand, TAG_NONE iff operand is ready */
+    Operand_value val[DEPENDENCY_NR_OF_SLOT_IO]; /* value of ready register operand */
 
     Instructions_status *is;
 } IO_info;
 
+/* memory ordering between IO buffers */
+typedef enum
+{
+    LSQ_ACCESS_READY,   /* no older conflicting access, use memory */
+    LSQ_ACCESS_FORWARD, /* value forwarded from older pending store */
+    LSQ_ACCESS_BLOCKED  /* real conflict with older access, replay in next cycle */
+} lsq_access_t;
+
+typedef struct Load_store_queue
+{
+    IO_info *entry[LOAD_STORE_QUEUE_SIZE]; /* entry[0] is the oldest one */
+    size_t num_entries;
+
+    /* statistics */
+    uint64_t forwarded;       /* loads served by older store */
+    uint64_t blocked;         /* replays caused by real conflicts */
+    uint64_t inflight_sum;    /* sum of memory accesses in flight per cycle */
+    uint64_t inflight_cycles; /* cycles with at least 1 access in flight */
+} Load_store_queue;
+
+/* instructions fetched on predicted path, waiting for issue */
+typedef struct Fetch_queue
+{
+    program_counter_t pc[FETCH_QUEUE_SIZE]; /* ring buffer, pc[head] is the oldest one */
+    size_t head;
+    size_t num_entries;
+    program_counter_t fetch_pc; /* next instruction to fetch */
+} Fetch_queue;
+
+/* unit of decoded instruction */
+typedef enum
+{
+    UOP_NONE,
+    UOP_JUMP,
+    UOP_CMP,
+    UOP_ADD_SUB,
+    UOP_MUL_DIV_MOD,
+    UOP_VECTOR,
+    UOP_LOAD,
+    UOP_STORE
+} uop_unit_t;
+
+/* decoded instruction, ready to issue */
+typedef struct Uop
+{
+    Token *token;
+    uop_unit_t unit;
+    job_t job;
+    arythemtic_t aryth_type;
+    int32_t latency; /* 0 for jump and memory access (latency depends on caches) */
+} Uop;
+
+/* decoded body of loop, instruction at PC start + i is in uop[i] */
+typedef struct Loop_buffer
+{
+    Uop uop[LOOP_BUFFER_SIZE];
+    program_counter_t start;
+    program_counter_t end;       /* loop closing jump */
+    program_counter_t candidate; /* last fetched backward jump */
+    bool active;
+} Loop_buffer;
+
 typedef struct Load_buffer
 {
     IO_info load[LOAD_BUFFER_SIZE];
@@ -167,8 +418,9 @@ typedef struct Reservation_station_chunk
     job_t job;
     arythemtic_t aryth_type;
 
-    bool has_dependency[DEPENDENCY_NR_OF_SLOT_RSC]; /* we depened from another op */
-    Dependency dependency[DEPENDENCY_NR_OF_SLOT_RSC]; /* this depends from us */
+    tag_t tag;
+    tag_t wait_tag[DEPENDENCY_NR_OF_SLOT_RSC]; /* producer of operand, TAG_NONE iff operand is ready */
+    Operand_value val[DEPENDENCY_NR_OF_SLOT_RSC]; /* value of ready register operand */
     
     int32_t wait_time; /* time to end */
 
@@ -185,20 +437,68 @@ typedef struct Reservation_stations
     Reservation_station_chunk add[RS_ADD_SUB_SIZE];
     Reservation_station_chunk mul[RS_MUL_DIV_MOD_SIZE];
     Reservation_station_chunk cmp;
+    Reservation_station_chunk vec[RS_VECTOR_SIZE];
 } Reservation_stations;
 
-typedef struct Board
+/* one pipelined functional unit */
+typedef struct Functional_unit
+{
+    int32_t ii_wait; /* time to accept next op */
+    Reservation_station_chunk pipeline[FU_PIPELINE_DEPTH]; /* ops in flight */
+
+    uint64_t ops;         /* dispatched ops */
+    uint64_t busy_cycles; /* cycles with at least 1 op in flight */
+} Functional_unit;
+
+typedef struct Functional_units
+{
+    Functional_unit add[FU_ADD_SUB_NUM];
+    Functional_unit mul[FU_MUL_DIV_MOD_NUM];
+    Functional_unit cmp[FU_CMP_NUM];
+    Functional_unit vec[FU_VECTOR_NUM];
+
+    /* ready op waits in RSC, because all units are busy */
+    uint64_t add_stalls;
+    uint64_t mul_stalls;
+    uint64_t cmp_stalls;
+    uint64_t vec_stalls;
+} Functional_units;
+
+/* architectural state of hardware thread */
+typedef struct Hw_thread
 {
     Registers               registers;
-    RAM                     ram;
+    Register_alias_table    rat;
+    program_counter_t       pc;
+    compare_flag_t          cf;
+} Hw_thread;
+
+typedef struct Board
+{
+    Hw_thread               thread[SMT_THREADS_MAX];
+    size_t                  num_threads;
+    Hw_thread               *ctx; /* thread of instruction being issued or executed */
+    Fetch_queue             fetch_queue[SMT_THREADS_MAX]; /* front end of each thread */
+    Loop_buffer             loop_buffer[SMT_THREADS_MAX];
+    RAM                     *ram; /* local_ram or RAM shared by many cores */
+    RAM                     local_ram;
+    Ram_store_buffer        *stores; /* NULL iff writes go straight to ram */
     Reservation_stations    rs;
+    Functional_units        fu;
     Write_buffer            write_buffer;
     Load_buffer             load_buffer;
-    program_counter_t       pc;
-    compare_flag_t          cf;
+    Load_store_queue        lsq;
+    Cache                   *l1; /* NULL iff disabled */
+    Cache                   *l2; /* NULL iff disabled */
 } Board;
 
-extern Board board;
+/* board of core simulated by current host thread */
+extern __thread Board *current_board;
+#define board (*current_board)
+
+/* registers, PC and CF are taken from this thread */
+#define board_switch_thread(T) (board.ctx = &board.thread[(T)])
+#define board_current_thread() ((uint32_t)(board.ctx - board.thread))
 
 /*
     Reset Board
@@ -211,6 +511,55 @@ extern Board board;
 */
 void reset_board(void);
 
+/*
+    Attach board to RAM shared with other cores, board does not own it
+
+    PARAMS
+    @IN ram - pointer to shared RAM
+    @IN stores - buffer for writes of board (committed by caller)
+
+    RETURN
+    This is a void function
+*/
+void board_share_ram(RAM *ram, Ram_store_buffer *stores);
+
+/*
+    Free all resources allocated by board
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    This is a void function
+*/
+void deinit_board(void);
+
+/*
+    Get latency of memory access through caches
+
+    PARAMS
+    @IN addr - address of memory
+    @IN write - true iff access is write
+
+    RETURN
+    Latency of access in cycles
+*/
+int32_t memory_access_time(uint32_t addr, bool write);
+
+/*
+    Get latency of access to contiguous range of memory through caches,
+    range costs one access per touched cache line
+
+    PARAMS
+    @IN addr - address of the first word
+    @IN len - number of words
+    @IN write - true iff access is write
+
+    RETURN
+    Latency of access in cycles
+*/
+int32_t memory_access_time_range(uint32_t addr, uint32_t len, bool write);
+
 /*
     Do Compare 2 registers
 
@@ -238,6 +587,56 @@ void do_cmp(Register_info *r1, Register_info *r2);
 void do_arythmetic(arythemtic_t type, Register_info *dst, Register_info *src1, Register_info *src2);
 
 
+/*
+    Get vector register of current thread
+
+    PARAMS
+    @IN nr - register number
+
+    RETURN
+    NULL iff there is no such register
+    Pointer to register iff success
+*/
+Vector_register_info *vector_register_get(uint32_t nr);
+
+/*
+    Do vector arythmetic operation on each word (host SIMD)
+
+    PARAMS
+    @IN type - type of OP (OP_ADD or OP_MUL)
+    @IN dst - pointer to destination vector reg
+    @IN src1 - pointer to source1 vector reg
+    @IN src2 - pointer to source2 vector reg
+
+    RETURN
+    This is a void function
+*/
+void do_vector_arythmetic(arythemtic_t type, Vector_register_info *dst, Vector_register_info *src1, Vector_register_info *src2);
+
+/*
+    Load VECTOR_LENGTH words from memory to vector register
+
+    PARAMS
+    @IN dst - pointer to vector reg
+    @IN addr - address of the first word
+
+    RETURN
+    This is a void function
+*/
+void do_vector_load(Vector_register_info *dst, uint32_t addr);
+
+/*
+    Store vector register to VECTOR_LENGTH words of memory
+
+    PARAMS
+    @IN addr - address of the first word
+    @IN src - pointer to vector reg
+
+    RETURN
+    This is a void function
+*/
+void do_vector_store(uint32_t addr, Vector_register_info *src);
+
 /*
     Go to next program instruction
 
@@ -273,6 +672,29 @@ void do_jump(jump_t type, uint32_t line);
 */
 void copy_data_to_reg(uint32_t num_reg, Variable *var);
 
+/*
+    Get value of variable, register state is not changed
+
+    PARAMS
+    @IN var - variable
+
+    RETURN
+    Value of variable
+*/
+reg_t variable_get_value(const Variable *var);
+
+/*
+    Copy value to register
+
+    PARAMS
+    @IN num_reg - register number
+    @IN val - value
+
+    RETURN
+    This is a void function
+*/
+void copy_value_to_reg(uint32_t num_reg, reg_t val);
+
 /*
     Copy data from variable to memory
 
@@ -285,6 +707,18 @@ void copy_data_to_reg(uint32_t num_reg, Variable *var);
 */
 void copy_data_to_memory(uint32_t addr, Variable *var);
 
+/*
+    Copy value to memory
+
+    PARAMS
+    @IN addr - address of memory
+    @IN val - value
+
+    RETURN
+    This is a void function
+*/
+void copy_value_to_memory(uint32_t addr, reg_t val);
+
 /*
     Print on stdout dump about whole board
 
@@ -296,5 +730,17 @@ void copy_data_to_memory(uint32_t addr, Variable *var);
 */
 void board_dump(void);
 
+/*
+    Print on stdout architectural state only: PC, CF, registers and vector registers
+    of every thread and RAM, so runs of different models can be compared
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    This is a void function
+*/
+void board_dump_arch(void);
+
 
 #endif
\ No newline at end of file
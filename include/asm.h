@@ -5,6 +5,7 @@
 /*
     Simple asm for simple architecture.
     Only mov, jumps and arthimetic to make tomasulo simpler.
+    Vector instructions work on VECTOR_LENGTH words (V registers, contiguous M range).
 
     Author: Michal Kukowski
     email: michalkukowski10@gmail.com
@@ -38,11 +39,17 @@ typedef struct Mnemonics
     const char *jgt; /* jgt src1  (if (CF == 1)  PC = src1) */
     const char *jge; /* jge src1 (if (CF != 1)  PC = src1) */
 
+    const char *vadd; /* vadd vdst vsrc1 vsrc2 (vdst[i] = vsrc1[i] + vsrc2[i]) */
+    const char *vmul; /* vmul vdst vsrc1 vsrc2 (vdst[i] = vsrc1[i] * vsrc2[i]) */
+    const char *vld;  /* vld vdst Maddr (vdst[i] = M[addr + i]) */
+    const char *vst;  /* vst Maddr vsrc (M[addr + i] = vsrc[i]) */
+
 } Mnemonics;
 
 extern const Mnemonics mnemonics;
 extern const char memory_c;
 extern const char register_c;
+extern const char vector_register_c;
 extern const char decimal_mode_c;
 extern const char octal_mode_c;
 extern const char binary_mode_c;
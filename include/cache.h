@@ -0,0 +1,114 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*
+    Parametric set-associative data cache (write-back, write-allocate)
+    Cache can be connected to next level cache, last level is connected to RAM
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+typedef enum
+{
+    CACHE_REPLACEMENT_LRU,
+    CACHE_REPLACEMENT_FIFO,
+    CACHE_REPLACEMENT_RANDOM
+} cache_replacement_t;
+
+typedef struct Cache_config
+{
+    size_t size;        /* in bytes */
+    size_t assoc;       /* lines in set */
+    size_t line_size;   /* in bytes */
+
+    int32_t hit_cycles;  /* latency of hit */
+    int32_t miss_cycles; /* latency of miss in this level (without next level) */
+
+    cache_replacement_t replacement;
+} Cache_config;
+
+typedef struct Cache_line
+{
+    uint64_t tag;
+    uint64_t stamp; /* last use for LRU, fill time for FIFO */
+    bool valid;
+    bool dirty;
+} Cache_line;
+
+typedef struct Cache
+{
+    const char *name;
+    Cache_config config;
+    size_t num_sets;
+
+    Cache_line *lines; /* num_sets * assoc lines */
+
+    struct Cache *next; /* NULL iff next level is RAM */
+    int32_t memory_cycles; /* RAM latency, used iff next == NULL */
+
+    uint64_t clock;
+    uint32_t seed;
+
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t writebacks;
+} Cache;
+
+/*
+    Create cache
+
+    PARAMS
+    @IN name - name of cache (used in dump)
+    @IN config - pointer to cache config
+    @IN next - next level cache or NULL iff next level is RAM
+    @IN memory_cycles - latency of RAM
+
+    RETURN
+    NULL iff failure
+    Pointer to new cache iff success
+*/
+Cache *cache_create(const char *name, const Cache_config *config, Cache *next, int32_t memory_cycles);
+
+/*
+    Destroy cache (without next level)
+
+    PARAMS
+    @IN cache - pointer to cache
+
+    RETURN
+    This is a void function
+*/
+void cache_destroy(Cache *cache);
+
+/*
+    Access word in cache, miss is served by next levels
+
+    PARAMS
+    @IN cache - pointer to cache
+    @IN addr - address in bytes
+    @IN write - true iff access is write
+
+    RETURN
+    Latency of access in cycles
+*/
+int32_t cache_access(Cache *cache, uint64_t addr, bool write);
+
+/*
+    Print on stdout cache config and hit / miss counters
+
+    PARAMS
+    @IN cache - pointer to cache
+
+    RETURN
+    This is a void function
+*/
+void cache_dump(const Cache *cache);
+
+#endif
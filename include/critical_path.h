@@ -0,0 +1,122 @@
+#ifndef CRITICAL_PATH_H
+#define CRITICAL_PATH_H
+
+/*
+    Online analysis of dynamic dependency DAG.
+    At issue instruction depends on the last writer of each register, vector register,
+    compare flag and memory word it reads (true dependencies only, independent of stalls,
+    renaming removes the others). Executed latency is known at issue, so the earliest
+    finish time with infinite resources is computed at once and the longest
+    latency-weighted path gives dataflow lower bound of program.
+
+    Nodes are reference counted (by last writer tables, consumers on the longest path
+    and instruction in flight), so only nodes which still can be on the critical path live,
+    released nodes are reused.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <arch.h>
+#include <stddef.h>
+
+typedef struct Critical_path_node
+{
+    struct Critical_path_node *prev; /* producer on the longest path, NULL iff none */
+    uint64_t finish; /* earliest finish time with infinite resources */
+    uint32_t refs;
+
+    uint64_t id; /* position in issue order */
+    uint32_t issue_cycle;
+    uint32_t exec_cycle; /* 0 iff instruction is in flight */
+    uint32_t latency; /* executed latency */
+    const Token *token;
+} Critical_path_node;
+
+/* last writer of memory word, open addressing */
+typedef struct Critical_path_mem
+{
+    uint32_t *addr;
+    Critical_path_node **node; /* NULL iff slot is empty */
+    size_t size; /* power of 2 */
+    size_t used;
+} Critical_path_mem;
+
+typedef struct Critical_path
+{
+    /* last writers per hardware thread */
+    Critical_path_node *reg[SMT_THREADS_MAX][REGISTERS_NUM];
+    Critical_path_node *vreg[SMT_THREADS_MAX][VREGISTERS_NUM];
+    Critical_path_node *cf[SMT_THREADS_MAX];
+
+    /* memory is shared by threads */
+    Critical_path_mem mem;
+
+    Critical_path_node *last; /* node with the latest finish */
+    uint64_t num_instructions;
+    Critical_path_node *free_nodes; /* released nodes linked by prev */
+} Critical_path;
+
+/*
+    Init empty DAG
+
+    PARAMS
+    @OUT cp - pointer to critical path
+
+    RETURN
+    This is a void function
+*/
+void critical_path_init(Critical_path *cp);
+
+/*
+    Release all nodes, instructions in flight have to be retired before
+
+    PARAMS
+    @IN cp - pointer to critical path
+
+    RETURN
+    This is a void function
+*/
+void critical_path_deinit(Critical_path *cp);
+
+/*
+    Add issued instruction to DAG: find last writers of its operands,
+    compute its finish time and make it the last writer of its destination
+
+    PARAMS
+    @IN cp - pointer to critical path
+    @IN is - issued instruction (is->node is set)
+    @IN latency - executed latency (0 for jump, which is resolved at issue)
+
+    RETURN
+    This is a void function
+*/
+void critical_path_issue(Critical_path *cp, Instructions_status *is, uint32_t latency);
+
+/*
+    Instruction has completed, its node keeps execute cycle and is released by instruction
+
+    PARAMS
+    @IN cp - pointer to critical path
+    @IN is - completed instruction (is->node is NULL after call)
+
+    RETURN
+    This is a void function
+*/
+void critical_path_retire(Critical_path *cp, Instructions_status *is);
+
+/*
+    Print on stdout simulated cycles against dataflow lower bound and instructions on the critical path
+
+    PARAMS
+    @IN cp - pointer to critical path
+    @IN cycles - simulated cycles
+
+    RETURN
+    This is a void function
+*/
+void critical_path_print(const Critical_path *cp, uint32_t cycles);
+
+#endif
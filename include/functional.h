@@ -0,0 +1,152 @@
+#ifndef FUNCTIONAL_H
+#define FUNCTIONAL_H
+
+/*
+    Functional only execution of program.
+    Instructions are applied directly on architectural state of board
+    (registers, RAM, PC, CF), without reservation stations, dependencies
+    and cycles. So it can be used to get only result of program
+    or to fast-forward before detailed tomasulo simulation.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <tokens.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <arch.h>
+
+/* pre-translated instruction kinds */
+typedef enum functional_op_t
+{
+    FOP_MOV,
+    FOP_MOV_MEM, /* mov with memory operand, can warm caches */
+    FOP_ADD,
+    FOP_SUB,
+    FOP_MUL,
+    FOP_DIV,
+    FOP_MOD,
+    FOP_CMP,
+    FOP_JEQ,
+    FOP_JNEQ,
+    FOP_JLT,
+    FOP_JLEQ,
+    FOP_JGT,
+    FOP_JGEQ,
+    FOP_VADD,
+    FOP_VMUL,
+    FOP_VLD,
+    FOP_VST,
+    FOP_NOP,
+    FOP_KINDS
+} functional_op_t;
+
+/*
+    Pre-translated instruction.
+    Register and immediate operands point directly to register value or immediate in op,
+    so execution does not check operand types. Memory operands of mov point to RAM word
+    from its first access (NULL before).
+*/
+typedef struct Functional_op
+{
+    const void *label; /* computed goto label of handler, set by first execution */
+    functional_op_t kind;
+
+    reg_t *dst;
+    const reg_t *src1;
+    const reg_t *src2;
+    reg_t imm[3]; /* immediate of dst, src1, src2 */
+
+    Vector_register_info *vdst; /* vector operands */
+    Vector_register_info *vsrc1;
+    Vector_register_info *vsrc2;
+
+    uint32_t dst_addr; /* memory addresses, resolved at first access and for cache warming */
+    uint32_t src_addr;
+    bool dst_mem;
+    bool src_mem;
+
+    program_counter_t target; /* jump target */
+} Functional_op;
+
+typedef struct Functional_program
+{
+    Functional_op *ops;
+    size_t num_ops;
+    bool threaded; /* labels are set */
+    bool warm_caches; /* labels are set for this mode */
+} Functional_program;
+
+/*
+    Execute program from board.pc on board
+
+    PARAMS
+    @IN program - set of instructions
+    @IN num_instr - number of instruction in set of instructions
+    @IN max_instr - stop after max_instr executed instructions
+    @IN warm_caches - touch caches on memory access (warm-up before detailed simulation)
+
+    RETURN
+    Number of executed instructions
+*/
+uint64_t functional_run(Token **program, size_t num_instr, uint64_t max_instr, bool warm_caches);
+
+/*
+    Execute program from board.pc on board and count executed instructions per basic block
+
+    PARAMS
+    @IN program - set of instructions
+    @IN num_instr - number of instruction in set of instructions
+    @IN max_instr - stop after max_instr executed instructions
+    @IN pc_to_block - basic block of each instruction
+    @OUT block_count - executed instructions per basic block (incremented)
+
+    RETURN
+    Number of executed instructions
+*/
+uint64_t functional_run_bbv(Token **program, size_t num_instr, uint64_t max_instr,
+                            const uint32_t *pc_to_block, uint64_t *block_count);
+
+/*
+    Translate program to threaded code on current board.
+    Operands point to board registers, so program is valid until board reset.
+
+    PARAMS
+    @IN program - set of instructions
+    @IN num_instr - number of instruction in set of instructions
+
+    RETURN
+    NULL iff failure
+    Pointer to new Functional_program iff success
+*/
+Functional_program *functional_translate(Token **program, size_t num_instr);
+
+/*
+    Destroy translated program
+
+    PARAMS
+    @IN fp - pointer to Functional_program
+
+    RETURN
+    This is a void function
+*/
+void functional_program_destroy(Functional_program *fp);
+
+/*
+    Execute translated program from board.pc on board
+
+    PARAMS
+    @IN fp - pointer to Functional_program
+    @IN max_instr - stop after max_instr executed instructions
+    @IN warm_caches - touch caches on memory access (warm-up before detailed simulation)
+
+    RETURN
+    Number of executed instructions
+*/
+uint64_t functional_exec(Functional_program *fp, uint64_t max_instr, bool warm_caches);
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef LIBTOMASULO_H
+#define LIBTOMASULO_H
+
+/*
+    Embeddable tomasulo simulator (make lib -> libtomasulo.a).
+
+    Every Tomasulo_sim has own board, so many simulations can live in one process
+    and each host thread can drive own simulations. API does not read stdin
+    and does not print anything, state is only returned by queries.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <tokens.h>
+#include <stats.h>
+#include <generic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct Tomasulo_sim Tomasulo_sim;
+
+typedef struct Tomasulo_sim_state
+{
+    uint64_t cycle;
+    uint64_t issued;
+    uint64_t retired;
+    uint64_t pc;
+    int cf;
+    bool finished; /* program is done and all jobs are completed */
+} Tomasulo_sim_state;
+
+/* run stops after cycle in which any condition is met (or when program is done) */
+typedef struct Tomasulo_sim_stop
+{
+    uint64_t cycle; /* UINT64_MAX iff not used */
+    uint64_t retired; /* UINT64_MAX iff not used */
+    uint64_t pc; /* breakpoint, UINT64_MAX iff not used */
+} Tomasulo_sim_stop;
+
+/*
+    Create simulator without program
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    NULL iff failure
+    Pointer to new simulator iff success
+*/
+Tomasulo_sim *tomasulo_sim_create(void);
+
+/*
+    Destroy simulator and program loaded from file
+
+    PARAMS
+    @IN sim - pointer to simulator
+
+    RETURN
+    This is a void function
+*/
+void tomasulo_sim_destroy(Tomasulo_sim *sim);
+
+/*
+    Parse asm file and load it, board is reset (on failure previous program stays loaded)
+
+    PARAMS
+    @IN sim - pointer to simulator
+    @IN path - path to asm file
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int tomasulo_sim_load_file(Tomasulo_sim *sim, const char *path);
+
+/*
+    Load already parsed program, board is reset.
+    Program is borrowed, it has to outlive simulation.
+    Program which fails program_is_valid (parser.h) is rejected
+
+    PARAMS
+    @IN sim - pointer to simulator
+    @IN program - set of instructions
+    @IN num_instr - number of instruction in set of instructions
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int tomasulo_sim_load_program(Tomasulo_sim *sim, Token **program, size_t num_instr);
+
+/*
+    Simulate cycles
+
+    PARAMS
+    @IN sim - pointer to simulator
+    @IN cycles - max number of cycles
+
+    RETURN
+    Number of simulated cycles (less than @cycles iff program is done)
+*/
+uint64_t tomasulo_sim_step(Tomasulo_sim *sim, uint64_t cycles);
+
+/*
+    Simulate cycles until stop condition is met or program is done
+
+    PARAMS
+    @IN sim - pointer to simulator
+    @IN stop - pointer to stop conditions
+
+    RETURN
+    Number of simulated cycles
+*/
+uint64_t tomasulo_sim_run_until(Tomasulo_sim *sim, const Tomasulo_sim_stop *stop);
+
+/*
+    Get state of simulation
+
+    PARAMS
+    @IN sim - pointer to simulator
+    @OUT state - pointer to state
+
+    RETURN
+    This is a void function
+*/
+void tomasulo_sim_get_state(const Tomasulo_sim *sim, Tomasulo_sim_state *state);
+
+/*
+    Get value of register
+
+    PARAMS
+    @IN sim - pointer to simulator
+    @IN nr - register number
+
+    RETURN
+    Value of register (0 iff register does not exist)
+*/
+DWORD tomasulo_sim_get_register(const Tomasulo_sim *sim, uint32_t nr);
+
+/*
+    Get value of memory word, committed stores only
+
+    PARAMS
+    @IN sim - pointer to simulator
+    @IN addr - address of word
+
+    RETURN
+    Value of word
+*/
+DWORD tomasulo_sim_get_memory(const Tomasulo_sim *sim, uint32_t addr);
+
+/*
+    Get statistics of simulation
+
+    PARAMS
+    @IN sim - pointer to simulator
+
+    RETURN
+    Pointer to statistics
+*/
+const Stats *tomasulo_sim_get_stats(const Tomasulo_sim *sim);
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <tokens.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 /*
     Simple parser asm to tokens
@@ -26,5 +27,35 @@
 */
 Token **parse(const char *file, size_t *size);
 
+/*
+    Parse asm text to array of Tokens*
+
+    PARAMS
+    @IN buf - asm text, terminated by '\0' after @buf_size bytes
+    @IN buf_size - length of text
+    @OUT size - size of array
+
+    RETURN
+    NULL iff failure
+    Pointer to array fo Token* iff success
+*/
+Token **parse_buffer(const char *buf, size_t buf_size, size_t *size);
+
+/*
+    Check that program can be simulated: register operands are R0 .. REGISTERS_NUM - 1
+    (arythmetic and cmp units read register file by number of every operand),
+    vector operands are valid and jumps go to line 0 .. size (size ends program).
+    Parser checks every program, so check is needed only for tokens built by hand
+
+    PARAMS
+    @IN program - array of Token*
+    @IN size - size of array
+
+    RETURN
+    true iff program is valid
+    false iff not
+*/
+bool program_is_valid(Token * const *program, size_t size);
+
 
 #endif
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/*
+    Host-side self profiling of simulator phases.
+    Every phase has accumulator of host time and number of calls,
+    report is printed at exit.
+    Accumulators are per host thread (no locking in hot path),
+    simulator threads merge them into global profile before join.
+
+    Profiling is enabled iff PROFILE is defined (make P=1),
+    otherwise all macros compile to nothing.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <stdint.h>
+
+typedef enum profile_phase_t
+{
+    PROFILE_PARSE,
+    PROFILE_FETCH,
+    PROFILE_EXECUTE_LOAD,
+    PROFILE_EXECUTE_ARYTHMETIC,
+    PROFILE_EXECUTE_WRITE,
+    PROFILE_PRINT,
+    PROFILE_PHASES
+} profile_phase_t;
+
+#ifdef PROFILE
+
+/*
+    Get host time in ns
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    Monotonic time in ns
+*/
+uint64_t profile_now(void);
+
+/*
+    Add time to phase accumulator of calling thread
+
+    PARAMS
+    @IN phase - phase
+    @IN ns - time spent in phase
+
+    RETURN
+    This is a void function
+*/
+void profile_add(profile_phase_t phase, uint64_t ns);
+
+/*
+    Merge accumulators of calling thread into global profile and clear them
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    This is a void function
+*/
+void profile_merge(void);
+
+/*
+    Print on stdout time spent in each phase (merges calling thread first)
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    This is a void function
+*/
+void profile_print(void);
+
+#define PROFILE_BEGIN(PHASE) \
+    const uint64_t __profile_start_##PHASE = profile_now()
+
+#define PROFILE_END(PHASE) \
+    profile_add(PHASE, profile_now() - __profile_start_##PHASE)
+
+#define PROFILE_MERGE() profile_merge()
+
+#define PROFILE_REPORT() profile_print()
+
+#else
+
+#define PROFILE_BEGIN(PHASE)
+#define PROFILE_END(PHASE)
+#define PROFILE_MERGE()
+#define PROFILE_REPORT()
+
+#endif
+
+#endif
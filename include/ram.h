@@ -0,0 +1,210 @@
+#ifndef RAM_H
+#define RAM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <generic.h>
+
+/*
+    Sparse paged memory of words.
+    Page is allocated (and zeroed) on first write, read from page
+    that has never been written returns 0 without allocation,
+    so memory footprint tracks only touched pages.
+
+    Address (word index) is splitted into
+    [ DIR | MID | LEAF | OFFSET in page ]
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#define RAM_PAGE_BITS 6
+#define RAM_LEAF_BITS 9
+#define RAM_MID_BITS  9
+#define RAM_DIR_BITS  (32 - RAM_PAGE_BITS - RAM_LEAF_BITS - RAM_MID_BITS)
+
+#define RAM_PAGE_SIZE ((size_t)1 << RAM_PAGE_BITS) /* in words */
+#define RAM_LEAF_SIZE ((size_t)1 << RAM_LEAF_BITS)
+#define RAM_MID_SIZE  ((size_t)1 << RAM_MID_BITS)
+#define RAM_DIR_SIZE  ((size_t)1 << RAM_DIR_BITS)
+
+typedef struct Ram_page
+{
+    DWORD word[RAM_PAGE_SIZE];
+} Ram_page;
+
+typedef struct Ram_leaf
+{
+    Ram_page *page[RAM_LEAF_SIZE];
+} Ram_leaf;
+
+typedef struct Ram_mid
+{
+    Ram_leaf *leaf[RAM_MID_SIZE];
+} Ram_mid;
+
+typedef struct RAM
+{
+    Ram_mid *mid[RAM_DIR_SIZE];
+    size_t num_pages; /* touched pages */
+} RAM;
+
+/*
+    Private writes of one core to shared RAM.
+    Core sees own writes at once, other cores see them after commit,
+    so result does not depend on order in which cores are stepped.
+    Only the last value per address is kept (open addressing).
+*/
+typedef struct Ram_store
+{
+    uint32_t addr;
+    bool used;
+    DWORD val;
+} Ram_store;
+
+typedef struct Ram_store_buffer
+{
+    Ram_store *store;
+    size_t size; /* power of 2 */
+    size_t num_stores;
+
+    uint64_t committed; /* statistics */
+} Ram_store_buffer;
+
+/*
+    Read word from memory
+
+    PARAMS
+    @IN ram - pointer to RAM
+    @IN addr - address of word
+
+    RETURN
+    Value of word (0 iff page has never been written)
+*/
+DWORD ram_read(const RAM *ram, uint32_t addr);
+
+/*
+    Write word to memory, allocate page iff needed
+
+    PARAMS
+    @IN ram - pointer to RAM
+    @IN addr - address of word
+    @IN val - value
+
+    RETURN
+    This is a void function
+*/
+void ram_write(RAM *ram, uint32_t addr, DWORD val);
+
+/*
+    Get pointer to word, allocate page iff needed
+
+    PARAMS
+    @IN ram - pointer to RAM
+    @IN addr - address of word
+
+    RETURN
+    Pointer to word
+*/
+DWORD *ram_get_word(RAM *ram, uint32_t addr);
+
+/*
+    Get pointer to word without allocation
+
+    PARAMS
+    @IN ram - pointer to RAM
+    @IN addr - address of word
+
+    RETURN
+    NULL iff page has never been written
+    Pointer to word iff page exists
+*/
+DWORD *ram_find_word(RAM *ram, uint32_t addr);
+
+/*
+    Free all pages, memory is zeroed
+
+    PARAMS
+    @IN ram - pointer to RAM
+
+    RETURN
+    This is a void function
+*/
+void ram_reset(RAM *ram);
+
+/*
+    Create empty store buffer
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    NULL iff failure
+    Pointer to new store buffer iff success
+*/
+Ram_store_buffer *ram_store_buffer_create(void);
+
+/*
+    Destroy store buffer, not committed writes are lost
+
+    PARAMS
+    @IN sb - pointer to store buffer
+
+    RETURN
+    This is a void function
+*/
+void ram_store_buffer_destroy(Ram_store_buffer *sb);
+
+/*
+    Buffer write of word
+
+    PARAMS
+    @IN sb - pointer to store buffer
+    @IN addr - address of word
+    @IN val - value
+
+    RETURN
+    This is a void function
+*/
+void ram_store_buffer_write(Ram_store_buffer *sb, uint32_t addr, DWORD val);
+
+/*
+    Read word, buffered write has priority over RAM
+
+    PARAMS
+    @IN sb - pointer to store buffer
+    @IN ram - pointer to RAM
+    @IN addr - address of word
+
+    RETURN
+    Value of word
+*/
+DWORD ram_store_buffer_read(const Ram_store_buffer *sb, const RAM *ram, uint32_t addr);
+
+/*
+    Write all buffered words to RAM and empty buffer
+
+    PARAMS
+    @IN sb - pointer to store buffer
+    @IN ram - pointer to RAM
+
+    RETURN
+    This is a void function
+*/
+void ram_store_buffer_commit(Ram_store_buffer *sb, RAM *ram);
+
+/*
+    Print on stdout all touched pages
+
+    PARAMS
+    @IN ram - pointer to RAM
+
+    RETURN
+    This is a void function
+*/
+void ram_dump(const RAM *ram);
+
+#endif
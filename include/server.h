@@ -0,0 +1,44 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/*
+    Simulation server, listens on Unix domain socket (tomasulo.out -D path [-w workers]).
+
+    Protocol is line based, one connection can send many jobs:
+        JOB <id> [cycles=<max cycles>] [retired=<max retired>]
+        <asm program, line by line>
+        END
+    Results are streamed back when jobs are done (in order of completion):
+        RESULT <id> cycles=<n> retired=<n> ipc=<x> pc=<n> finished=<0|1> cached=<0|1> host=<seconds>
+        FAIL <id> <reason>
+
+    Jobs are run by fixed pool of workers, each worker has own simulator.
+    Parsed programs are cached by hash of text, so the same program is parsed once.
+    Machine is configured at compile time (arch.h), job chooses only run limits.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <stddef.h>
+
+#define SERVER_MAX_PROGRAM      (1 << 20) /* bytes of asm per job */
+#define SERVER_CACHE_BUCKETS    256
+#define SERVER_CACHE_ENTRIES    1024 /* when cache is full, new programs are parsed per job */
+#define SERVER_BACKLOG          64
+
+/*
+    Run server, returns only iff server can't be started
+
+    PARAMS
+    @IN path - path to socket
+    @IN num_workers - number of worker threads
+
+    RETURN
+    Non-zero value iff failure
+*/
+int server_run(const char *path, size_t num_workers);
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef SIM_LOG_H
+#define SIM_LOG_H
+
+/*
+    Ring-buffered logging for hot paths of simulator.
+
+    Level is chosen at compile time (make L=<level>):
+    SIM_LOG_LEVEL_NONE  - release, TRACE() and LOG() compile to nothing
+    SIM_LOG_LEVEL_LOG   - LOG() records go to ring buffer
+    SIM_LOG_LEVEL_TRACE - also TRACE() records go to ring buffer
+
+    Record keeps only pointer to format and raw arguments, formatting is deferred
+    to dump. So %s arguments have to outlive record (string literals, names, argv).
+    Ring is dumped on demand (sim_log_dump, SIGUSR1) and at crash (SIGSEGV, SIGBUS, SIGFPE, SIGABRT).
+    Many threads can log at once, record is published by its sequence number when complete,
+    so dump skips records which are still being written instead of printing torn ones.
+
+    Include this header after all other headers,
+    it replaces TRACE() and LOG() from log.h in including file.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <log.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define SIM_LOG_LEVEL_NONE  0
+#define SIM_LOG_LEVEL_LOG   1
+#define SIM_LOG_LEVEL_TRACE 2
+
+#ifndef SIM_LOG_LEVEL
+#define SIM_LOG_LEVEL SIM_LOG_LEVEL_NONE
+#endif
+
+#define SIM_LOG_RING_SIZE   (1 << 14) /* records, power of 2 */
+#define SIM_LOG_MAX_ARGS    6
+
+#if SIM_LOG_LEVEL > SIM_LOG_LEVEL_NONE
+
+/*
+    Install signal handlers to dump ring at crash and on SIGUSR1
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    This is a void function
+*/
+void sim_log_init(void);
+
+/*
+    Put record to ring buffer, arguments are not formatted
+
+    PARAMS
+    @IN func - function name
+    @IN line - line in source file
+    @IN fmt - printf like format (NULL for TRACE record)
+    @IN ... - arguments
+
+    RETURN
+    This is a void function
+*/
+void sim_log_record(const char *func, uint32_t line, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+/*
+    Format and print all records from ring, from the oldest
+
+    PARAMS
+    @IN out - output stream
+
+    RETURN
+    This is a void function
+*/
+void sim_log_dump(FILE *out);
+
+#define SIM_LOG_INIT() sim_log_init()
+#define SIM_LOG_DUMP(OUT) sim_log_dump(OUT)
+#define SIM_LOG(...) sim_log_record(__func__, __LINE__, __VA_ARGS__)
+
+#else
+
+#define SIM_LOG_INIT()
+#define SIM_LOG_DUMP(OUT)
+#define SIM_LOG(...)
+
+#endif
+
+#if SIM_LOG_LEVEL >= SIM_LOG_LEVEL_TRACE
+#define SIM_TRACE() sim_log_record(__func__, __LINE__, NULL)
+#else
+#define SIM_TRACE()
+#endif
+
+#undef TRACE
+#define TRACE() SIM_TRACE()
+
+#undef LOG
+#define LOG(...) SIM_LOG(__VA_ARGS__)
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef SIMPOINT_H
+#define SIMPOINT_H
+
+/*
+    SimPoint like sampled simulation.
+
+    Program is split into basic blocks (leaders: first instruction, jump targets,
+    instruction after jump). Functional run profiles basic block vector (BBV)
+    of each interval of fixed number of instructions. BBVs are randomly projected
+    to few dimensions and clustered by k-means (k chosen by BIC).
+    Intervals closest to centroids are simulated in detail, CPI of program
+    is extrapolated as weighted mean with stratified sampling error.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <tokens.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define SIMPOINT_DIMS                   15
+#define SIMPOINT_MAX_CLUSTERS           32
+#define SIMPOINT_SAMPLES_PER_CLUSTER    2
+#define SIMPOINT_KMEANS_ITERATIONS      100
+#define SIMPOINT_BIC_THRESHOLD          0.9
+
+typedef struct Simpoint_interval
+{
+    uint64_t start; /* first dynamic instruction */
+    uint64_t num_instr;
+    uint32_t cluster;
+    double dist; /* distance to centroid */
+    double point[SIMPOINT_DIMS]; /* projected BBV */
+} Simpoint_interval;
+
+typedef struct Simpoint_sample
+{
+    uint64_t start; /* first dynamic instruction */
+    uint64_t num_instr;
+    uint32_t cluster;
+
+    /* filled after detailed simulation */
+    uint64_t cycles;
+    uint64_t instr;
+} Simpoint_sample;
+
+typedef struct Simpoint
+{
+    uint32_t *pc_to_block; /* basic block of each instruction */
+    size_t num_blocks;
+
+    uint64_t interval_size;
+    uint64_t total_instr; /* dynamic instructions of program */
+
+    Simpoint_interval *intervals;
+    size_t num_intervals;
+
+    uint32_t num_clusters;
+    uint64_t cluster_instr[SIMPOINT_MAX_CLUSTERS]; /* instructions in intervals of cluster */
+
+    Simpoint_sample *samples; /* sorted by start */
+    size_t num_samples;
+} Simpoint;
+
+/*
+    Profile program functionally from current board state and choose samples
+
+    PARAMS
+    @IN program - set of instructions
+    @IN num_instr - number of instruction in set of instructions
+    @IN interval_size - dynamic instructions per interval
+    @IN max_clusters - max number of clusters (phases)
+
+    RETURN
+    NULL iff failure
+    Pointer to new Simpoint iff success
+*/
+Simpoint *simpoint_create(Token **program, size_t num_instr, uint64_t interval_size, uint32_t max_clusters);
+
+/*
+    Destroy Simpoint
+
+    PARAMS
+    @IN sp - pointer to Simpoint
+
+    RETURN
+    This is a void function
+*/
+void simpoint_destroy(Simpoint *sp);
+
+/*
+    Print on stdout samples and extrapolated cycles, IPC with error estimate
+
+    PARAMS
+    @IN sp - pointer to Simpoint with simulated samples
+
+    RETURN
+    This is a void function
+*/
+void simpoint_print_estimate(const Simpoint *sp);
+
+#endif
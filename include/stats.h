@@ -0,0 +1,196 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <tokens.h>
+
+/*
+    Statistics collected by tomasulo
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+/* what happened with issue in cycle */
+typedef enum
+{
+    ISSUE_OK,
+    ISSUE_STALL_FETCH, /* fetch queue is empty, front end bound */
+    ISSUE_STALL_RS_ADD_SUB,
+    ISSUE_STALL_RS_MUL_DIV_MOD,
+    ISSUE_STALL_RS_CMP,
+    ISSUE_STALL_RS_VECTOR,
+    ISSUE_STALL_LOAD_BUFFER,
+    ISSUE_STALL_STORE_BUFFER,
+    ISSUE_STALL_BRANCH,
+    ISSUE_DRAINED,
+    ISSUE_OUTCOMES /* number of outcomes */
+} issue_outcome_t;
+
+/* instruction classes for retirement statistics */
+typedef enum
+{
+    INSTR_CLASS_MOVE_REG,
+    INSTR_CLASS_MOVE_MEM,
+    INSTR_CLASS_ADD,
+    INSTR_CLASS_SUB,
+    INSTR_CLASS_MUL,
+    INSTR_CLASS_DIV,
+    INSTR_CLASS_MOD,
+    INSTR_CLASS_CMP,
+    INSTR_CLASS_JUMP,
+    INSTR_CLASS_VECTOR_ALU,
+    INSTR_CLASS_VECTOR_MEM,
+    INSTR_CLASSES /* number of classes */
+} instr_class_t;
+
+/*
+    Latencies below STATS_HISTOGRAM_LINEAR have own bucket,
+    above that each bucket is 2 times wider than previous,
+    so histogram has constant size for any latency
+*/
+#define STATS_HISTOGRAM_LINEAR  32
+#define STATS_HISTOGRAM_BUCKETS (STATS_HISTOGRAM_LINEAR + 32)
+
+typedef struct Latency_histogram
+{
+    uint64_t bucket[STATS_HISTOGRAM_BUCKETS];
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+} Latency_histogram;
+
+typedef struct Stats
+{
+    uint64_t issue[ISSUE_OUTCOMES]; /* cycles per issue outcome */
+
+    /* issue to complete latency per class, aggregated at retirement */
+    Latency_histogram latency[INSTR_CLASSES];
+    Latency_histogram latency_all;
+
+    /* front end */
+    Latency_histogram fetch_queue; /* occupancy of fetch queue after fetch per cycle */
+    uint64_t fetched;
+    uint64_t fetched_loop_buffer; /* fetched from loop buffer without decoding */
+    uint64_t fetch_full;      /* cycles without fetch, because queue is full (issue bound) */
+    uint64_t fetch_redirects; /* fetch queue flushed, because predicted path was wrong */
+} Stats;
+
+/*
+    Count issue outcome of cycle
+
+    PARAMS
+    @IN stats - pointer to Stats
+    @IN outcome - issue outcome
+
+    RETURN
+    This is a void function
+*/
+void stats_count_issue(Stats *stats, issue_outcome_t outcome);
+
+/*
+    Print on stdout table with cycles breakdown by issue outcome
+
+    PARAMS
+    @IN stats - pointer to Stats
+
+    RETURN
+    This is a void function
+*/
+void stats_print_issue(const Stats *stats);
+
+/*
+    Count fetch of cycle
+
+    PARAMS
+    @IN stats - pointer to Stats
+    @IN fetched - number of fetched instructions
+    @IN from_loop_buffer - number of instructions fetched from loop buffer
+    @IN occupancy - number of instructions in fetch queue after fetch
+    @IN full - true iff fetch queue was full before fetch
+
+    RETURN
+    This is a void function
+*/
+void stats_count_fetch(Stats *stats, uint64_t fetched, uint64_t from_loop_buffer, uint64_t occupancy, bool full);
+
+/*
+    Count redirect of fetch (flush of fetch queue)
+
+    PARAMS
+    @IN stats - pointer to Stats
+
+    RETURN
+    This is a void function
+*/
+void stats_count_redirect(Stats *stats);
+
+/*
+    Print on stdout fetched instructions, fetch queue occupancy, loop buffer and redirects
+
+    PARAMS
+    @IN stats - pointer to Stats
+    @IN cycles - simulated cycles
+
+    RETURN
+    This is a void function
+*/
+void stats_print_fetch(const Stats *stats, uint64_t cycles);
+
+/*
+    Count retired instruction
+
+    PARAMS
+    @IN stats - pointer to Stats
+    @IN token - retired instruction
+    @IN issue_cycle - cycle of issue
+    @IN exec_cycle - cycle of completion
+
+    RETURN
+    This is a void function
+*/
+void stats_count_retire(Stats *stats, const Token *token, uint32_t issue_cycle, uint32_t exec_cycle);
+
+/*
+    Print on stdout IPC and CPI of program, count and latency per instruction class and latency histograms
+
+    PARAMS
+    @IN stats - pointer to Stats
+    @IN cycles - simulated cycles
+
+    RETURN
+    This is a void function
+*/
+void stats_print_retire(const Stats *stats, uint64_t cycles);
+
+/*
+    Print on stdout speed of simulator itself
+
+    PARAMS
+    @IN stats - pointer to Stats
+    @IN cycles - simulated cycles
+    @IN seconds - host time spent on simulation
+
+    RETURN
+    This is a void function
+*/
+void stats_print_host(const Stats *stats, uint64_t cycles, double seconds);
+
+/*
+    Write count and latency percentiles per instruction class and cycles, IPC, CPI of program to CSV file
+
+    PARAMS
+    @IN stats - pointer to Stats
+    @IN path - path to CSV file
+    @IN cycles - simulated cycles
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int stats_write_csv(const Stats *stats, const char *path, uint64_t cycles);
+
+#endif
@@ -2,6 +2,7 @@
 #define TOKENS_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 /*
     Tokens of our asm
@@ -18,7 +19,8 @@ typedef enum
     TOKEN_MOVE,
     TOKEN_CMP,
     TOKEN_JUMP,
-    TOKEN_ARYTHMETIC
+    TOKEN_ARYTHMETIC,
+    TOKEN_VECTOR
 } token_t;
 
 typedef enum
@@ -26,7 +28,8 @@ typedef enum
     VAR_NONE,
     VAR_REGISTER,
     VAR_MEMORY,
-    VAR_VALUE
+    VAR_VALUE,
+    VAR_VREGISTER
 } var_t;
 
 typedef enum
@@ -50,6 +53,15 @@ typedef enum
     OP_MOD
 } arythemtic_t;
 
+typedef enum
+{
+    VOP_NONE,
+    VOP_ADD,
+    VOP_MUL,
+    VOP_LOAD,
+    VOP_STORE
+} vector_op_t;
+
 typedef struct Variable
 {
     var_t type;
@@ -88,6 +100,15 @@ typedef struct Token_arythmetic
     Variable src2;
 } Token_arythmetic;
 
+/* vld: dst = V, src1 = M, vst: dst = M, src1 = V */
+typedef struct Token_vector
+{
+    vector_op_t type;
+    Variable dst;
+    Variable src1;
+    Variable src2;
+} Token_vector;
+
 typedef struct Token
 {
     token_t type;
@@ -97,6 +118,7 @@ typedef struct Token
         Token_cmp  token_cmp;
         Token_jump token_jump;
         Token_arythmetic token_arythmetic;
+        Token_vector token_vector;
     };
 } Token;
 
@@ -146,4 +168,17 @@ void token_dbg_print(const Token *token);
 */
 void token_print(const Token *token);
 
+/*
+    Print token to string (like snprintf)
+
+    PARAMS
+    @OUT buf - buffer for string
+    @IN size - size of buffer
+    @IN token - pointer to generic Token
+
+    RETURN
+    Number of chars which would have been written (like snprintf)
+*/
+int token_snprint(char *buf, size_t size, const Token *token);
+
 #endif
\ No newline at end of file
@@ -11,6 +11,32 @@
 */
 
 #include <tokens.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* which hardware thread fetches in SMT */
+typedef enum
+{
+    SMT_FETCH_ROUND_ROBIN, /* threads take turns */
+    SMT_FETCH_ICOUNT /* thread with the fewest instructions in flight */
+} smt_fetch_policy_t;
+
+typedef struct Tomasulo_options
+{
+    const char *stats_csv; /* path to CSV with statistics, NULL iff not needed */
+    const char *trace_json; /* path to Trace Event Format JSON, NULL iff not needed */
+    bool headless; /* do not print board and do not wait for key in each cycle */
+    bool arch_dump; /* print final architectural state (registers, RAM) at the end */
+    bool functional; /* only functional execution, no tomasulo */
+    bool functional_switch; /* functional execution interprets tokens instead of threaded code */
+    uint64_t fast_forward; /* instructions executed functionally before tomasulo */
+    uint64_t sample_interval; /* instructions per interval in sampled simulation, 0 iff disabled */
+    uint32_t sample_clusters; /* max number of phases in sampled simulation */
+    size_t threads; /* host threads in multi-core simulation, 0 iff one per core */
+    uint32_t quantum; /* cycles between synchronizations of cores, writes of core are visible to others after it */
+    smt_fetch_policy_t smt_policy; /* fetch policy in SMT */
+} Tomasulo_options;
 
 /*
     Simulate tomasulo on set of instructions
@@ -18,11 +44,46 @@
     PARAMS
     @IN program - set of instructions
     @IN num_instr - number of instruction in set of instructions
+    @IN options - pointer to options
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int tomasulo(Token **program, size_t num_instr, const Tomasulo_options *options);
+
+/*
+    Simulate many tomasulo cores sharing one RAM, cores are stepped in parallel.
+    Writes of core are buffered and committed in core order every quantum,
+    so result does not depend on number of host threads.
+
+    PARAMS
+    @IN programs - set of instructions per core
+    @IN num_instr - number of instruction in set of instructions per core
+    @IN num_cores - number of cores
+    @IN options - pointer to options (threads, quantum, headless)
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+int tomasulo_multicore(Token ***programs, const size_t *num_instr, size_t num_cores, const Tomasulo_options *options);
+
+/*
+    Simulate one tomasulo core running many programs (SMT).
+    Each program has own registers, PC and compare flag, programs compete
+    for reservation stations, units and IO buffers, one instruction is issued per cycle.
+
+    PARAMS
+    @IN programs - set of instructions per thread
+    @IN num_instr - number of instruction in set of instructions per thread
+    @IN num_threads - number of threads (at most SMT_THREADS_MAX)
+    @IN options - pointer to options (smt_policy, headless, stats_csv)
 
     RETURN
     0 iff success
     Non-zero value iff failure
 */
-int tomasulo(Token **program, size_t num_instr);
+int tomasulo_smt(Token ***programs, const size_t *num_instr, size_t num_threads, const Tomasulo_options *options);
 
 #endif
\ No newline at end of file
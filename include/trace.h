@@ -0,0 +1,92 @@
+#ifndef TRACE_EVENT_H
+#define TRACE_EVENT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+    Streaming writer of Chrome / Perfetto Trace Event Format (JSON).
+    Events are written directly to buffered file, so memory usage
+    does not depend on length of simulation. 1 cycle = 1 us on timeline.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+typedef struct Trace
+{
+    FILE *file;
+    char *buf; /* stdio buffer */
+    uint64_t events;
+    uint64_t flow_id;
+} Trace;
+
+/*
+    Create trace file
+
+    PARAMS
+    @IN path - path to JSON file
+
+    RETURN
+    NULL iff failure
+    Pointer to new trace iff success
+*/
+Trace *trace_create(const char *path);
+
+/*
+    Finish JSON and close trace file
+
+    PARAMS
+    @IN trace - pointer to trace
+
+    RETURN
+    This is a void function
+*/
+void trace_destroy(Trace *trace);
+
+/*
+    Give name to track
+
+    PARAMS
+    @IN trace - pointer to trace
+    @IN tid - track id
+    @IN name - name of track
+
+    RETURN
+    This is a void function
+*/
+void trace_track_name(Trace *trace, uint32_t tid, const char *name);
+
+/*
+    Write slice (complete event)
+
+    PARAMS
+    @IN trace - pointer to trace
+    @IN tid - track id
+    @IN name - name of slice
+    @IN cat - category of slice
+    @IN ts - start cycle
+    @IN dur - duration in cycles
+
+    RETURN
+    This is a void function
+*/
+void trace_slice(Trace *trace, uint32_t tid, const char *name, const char *cat, uint64_t ts, uint64_t dur);
+
+/*
+    Write flow (arrow) between slices on 2 tracks
+
+    PARAMS
+    @IN trace - pointer to trace
+    @IN from - track id of producer
+    @IN to - track id of consumer
+    @IN ts - cycle
+
+    RETURN
+    This is a void function
+*/
+void trace_flow(Trace *trace, uint32_t from, uint32_t to, uint64_t ts);
+
+#endif
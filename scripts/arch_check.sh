@@ -0,0 +1,60 @@
+#!/bin/bash
+#
+#   Compare final architectural state of tomasulo with functional reference
+#
+#   Tomasulo (-q), tomasulo after fast-forward of 1 instruction and of half
+#   of the program (-F n) have to leave the same PC, CF, registers, vector
+#   registers and RAM as functional execution (-f). State is printed by -A.
+#
+#   Usage: arch_check.sh simulator file.asm ...
+#
+#   Author: Michal Kukowski
+#   email: michalkukowski10@gmail.com
+#
+#   LICENCE: GPL 3.0
+
+EXEC=$1
+shift
+
+if [ -z "$EXEC" ] || [ $# -eq 0 ]; then
+    echo "Usage: $0 simulator file.asm ..."
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+# architectural state block of -A
+arch_state() {
+    "$EXEC" -q -A "$@" | sed -n '/^Architectural state$/,/^End of architectural state$/p'
+}
+
+failed=0
+for file in "$@"; do
+    arch_state -f "$file" > "$TMP/functional.txt"
+    instr=$("$EXEC" -q -f "$file" | awk '/^\tInstructions +[0-9]/ { print $2 }')
+
+    status="OK"
+    if [ ! -s "$TMP/functional.txt" ] || [ -z "$instr" ]; then
+        status="NO OUTPUT"
+        failed=1
+    else
+        for run in "" "-F 1" "-F $((instr / 2))"; do
+            arch_state $run "$file" > "$TMP/tomasulo.txt"
+            if ! cmp -s "$TMP/functional.txt" "$TMP/tomasulo.txt"; then
+                status="DIFF${run:+ ($run)}"
+                diff "$TMP/functional.txt" "$TMP/tomasulo.txt" | head -20 > "$TMP/diff.txt"
+                failed=1
+                break
+            fi
+        done
+    fi
+
+    printf "%-40s %s\n" "$(basename "$file")" "$status"
+    if [ -s "$TMP/diff.txt" ]; then
+        cat "$TMP/diff.txt"
+        rm -f "$TMP/diff.txt"
+    fi
+done
+
+exit $failed
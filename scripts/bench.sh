@@ -0,0 +1,108 @@
+#!/bin/bash
+#
+#   Benchmark speed of simulator itself
+#
+#   Every kernel from bench directory is simulated headless BENCH_RUNS times,
+#   the best run is reported as simulated cycles and retired instructions
+#   per host second. Results are written to output file and compared
+#   with baseline (baseline is created iff does not exist).
+#   Functional interpreter is reported as threaded code vs token switch dispatch.
+#
+#   Usage: bench.sh simulator bench_dir output baseline
+#
+#   Author: Michal Kukowski
+#   email: michalkukowski10@gmail.com
+#
+#   LICENCE: GPL 3.0
+
+set -e
+
+EXEC=$1
+BENCH_DIR=$2
+OUTPUT=$3
+BASELINE=$4
+
+RUNS=${BENCH_RUNS:-3}
+TOLERANCE=${BENCH_TOLERANCE:-5}
+
+if [ $# -ne 4 ]; then
+    echo "Usage: $0 simulator bench_dir output baseline"
+    exit 1
+fi
+
+# kernel cycles instructions seconds cycles_per_s instr_per_s
+run_kernel()
+{
+    local kernel=$1
+    local best=""
+    local i
+
+    for ((i = 0; i < RUNS; ++i)); do
+        local res
+        res=$("$EXEC" -q "$kernel" | awk '
+            /Host time/             { sec = $3 }
+            /^Retired/              { instr = $2; cycles = $5 }
+            END                     { printf "%s %s %s\n", cycles, instr, sec }')
+
+        if [ -z "$best" ] || awk -v a="$res" -v b="$best" \
+            'BEGIN { split(a, x); split(b, y); exit !(x[3] < y[3]) }'; then
+            best=$res
+        fi
+    done
+
+    echo "$(basename "$kernel" .asm) $best" | awk '
+        { printf "%s %s %s %s %.0f %.0f\n", $1, $2, $3, $4, ($4 > 0 ? $2 / $4 : 0), ($4 > 0 ? $3 / $4 : 0) }'
+}
+
+: > "$OUTPUT"
+for kernel in "$BENCH_DIR"/*.asm; do
+    run_kernel "$kernel" >> "$OUTPUT"
+done
+
+awk '
+    {
+        printf "%-12s %12s cycles %12s instr %10.6f s %14s cycles/s %14s instr/s\n", $1, $2, $3, $4, $5, $6
+        if ($5 > 0) { lc += log($5); li += log($6); ++n }
+    }
+    END {
+        printf "%-12s %12s %6s %12s %5s %10s %1s %14.0f cycles/s %14.0f instr/s\n", "geomean", "", "", "", "", "", "", (n ? exp(lc / n) : 0), (n ? exp(li / n) : 0)
+    }' "$OUTPUT"
+
+# functional interpreter: threaded code (-f) vs token switch (-f -r)
+echo "Functional dispatch, instr/s"
+for kernel in "$BENCH_DIR"/*.asm; do
+    threaded=$("$EXEC" -f "$kernel" | awk '/Instructions \/ s/ { print $4 }')
+    switch=$("$EXEC" -f -r "$kernel" | awk '/Instructions \/ s/ { print $4 }')
+    echo "$(basename "$kernel" .asm) $threaded $switch" | awk '
+        { printf "%-12s %14s threaded %14s switch %8.2fx\n", $1, $2, $3, ($3 > 0 ? $2 / $3 : 0) }'
+done
+
+if [ ! -f "$BASELINE" ]; then
+    cp "$OUTPUT" "$BASELINE"
+    echo "No baseline, saved current results to $BASELINE"
+    exit 0
+fi
+
+echo "Compared with $BASELINE"
+awk -v tol="$TOLERANCE" '
+    NR == FNR { base[$1] = $5; base_cycles[$1] = $2; next }
+    ($1 in base) && base[$1] > 0 && $5 > 0 {
+        ratio = $5 / base[$1]
+        printf "%-12s %8.3fx", $1, ratio
+        if ($2 != base_cycles[$1])
+            printf "  simulated cycles changed %s -> %s", base_cycles[$1], $2
+        printf "\n"
+        lr += log(ratio)
+        ++n
+    }
+    END {
+        if (n == 0)
+            exit 0
+
+        g = exp(lr / n)
+        printf "%-12s %8.3fx\n", "geomean", g
+        if (g < 1 - tol / 100) {
+            printf "REGRESSION: geomean below baseline by more than %s%%\n", tol
+            exit 1
+        }
+    }' "$BASELINE" "$OUTPUT"
@@ -0,0 +1,44 @@
+#!/bin/bash
+#
+#   Compare threaded code (-f) with token switch (-f -r) functional interpreter
+#
+#   Both interpreters have to leave the same architectural state: PC, CF,
+#   registers, vector registers and RAM (also number of touched pages,
+#   so reads must not allocate). Host timing at the end of run is not compared.
+#
+#   Usage: functional_check.sh simulator file.asm ...
+#
+#   Author: Michal Kukowski
+#   email: michalkukowski10@gmail.com
+#
+#   LICENCE: GPL 3.0
+
+EXEC=$1
+shift
+
+if [ -z "$EXEC" ] || [ $# -eq 0 ]; then
+    echo "Usage: $0 simulator file.asm ..."
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+failed=0
+for file in "$@"; do
+    "$EXEC" -q -f "$file" | sed '/^Functional run/,$d' > "$TMP/threaded.txt"
+    "$EXEC" -q -f -r "$file" | sed '/^Functional run/,$d' > "$TMP/switch.txt"
+
+    if [ ! -s "$TMP/threaded.txt" ]; then
+        printf "%-40s %s\n" "$(basename "$file")" "NO OUTPUT"
+        failed=1
+    elif cmp -s "$TMP/threaded.txt" "$TMP/switch.txt"; then
+        printf "%-40s %s\n" "$(basename "$file")" "OK"
+    else
+        printf "%-40s %s\n" "$(basename "$file")" "DIFF"
+        diff "$TMP/switch.txt" "$TMP/threaded.txt" | head -20
+        failed=1
+    fi
+done
+
+exit $failed
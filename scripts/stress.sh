@@ -0,0 +1,43 @@
+#!/bin/bash
+#
+#   Scaling test of parser and core on generated programs
+#
+#   For each size program is generated twice: straight line (parser stress)
+#   and small body in long loop (core stress). Simulator runs headless.
+#
+#   Usage: stress.sh simulator generator
+#
+#   Author: Michal Kukowski
+#   email: michalkukowski10@gmail.com
+#
+#   LICENCE: GPL 3.0
+
+set -e
+
+EXEC=$1
+GEN=$2
+
+SIZES=${STRESS_SIZES:-"1000 10000 100000 1000000"}
+SEED=${STRESS_SEED:-1}
+
+if [ $# -ne 2 ]; then
+    echo "Usage: $0 simulator generator"
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+printf "%-8s %10s %12s %12s %10s\n" "shape" "instr" "cycles" "retired" "time [s]"
+for size in $SIZES; do
+    "$GEN" -s "$SEED" -n "$size" -o "$TMP/line.asm"
+    "$GEN" -s "$SEED" -n 100 -l $((size / 100)) -o "$TMP/loop.asm"
+
+    for shape in line loop; do
+        start=$(date +%s.%N)
+        res=$("$EXEC" -q "$TMP/$shape.asm" | awk '/^Retired/ { print $5, $2 }')
+        end=$(date +%s.%N)
+
+        printf "%-8s %10s %12s %12s %10.3f\n" "$shape" "$size" $res "$(awk -v s="$start" -v e="$end" 'BEGIN { print e - s }')"
+    done
+done
@@ -0,0 +1,93 @@
+#!/bin/bash
+#
+#   Design space sweep
+#
+#   Machine is configured at compile time, so simulator is built once per point
+#   of grid (cartesian product of SWEEP_GRID) in copy of project, then every kernel
+#   is simulated headless. One row per (config, kernel) with parameters, cycles,
+#   IPC and issue stalls is packed by resdb to columnar output file.
+#
+#   Usage: sweep.sh project_dir resdb output kernel.asm...
+#
+#   Author: Michal Kukowski
+#   email: michalkukowski10@gmail.com
+#
+#   LICENCE: GPL 3.0
+
+set -e
+
+PROJECT_DIR=$1
+RESDB=$2
+OUTPUT=$3
+
+GRID=${SWEEP_GRID:-"RS_ADD_SUB_SIZE=1,2,3,4 RS_MUL_DIV_MOD_SIZE=1,2,4 LOAD_BUFFER_SIZE=1,3,6"}
+
+if [ $# -lt 4 ]; then
+    echo "Usage: $0 project_dir resdb output kernel.asm..."
+    exit 1
+fi
+
+shift 3
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+# build in copy, objects of project are not touched
+mkdir -p "$TMP/tree"
+cp -r "$PROJECT_DIR/Makefile" "$PROJECT_DIR/include" "$PROJECT_DIR/src" "$PROJECT_DIR/external" "$TMP/tree"
+
+# cartesian product of grid, one "NAME=value ..." per config
+read -r -a params <<< "$GRID"
+configs=("")
+for param in "${params[@]}"; do
+    IFS=, read -r -a values <<< "${param#*=}"
+    next=()
+    for config in "${configs[@]}"; do
+        for value in "${values[@]}"; do
+            next+=("$config ${param%%=*}=$value")
+        done
+    done
+    configs=("${next[@]}")
+done
+
+header=""
+for param in "${params[@]}"; do
+    header="$header${param%%=*}\t"
+done
+printf "${header}kernel\tcycles\tretired\tipc\tstall_fetch\tstall_rs_add_sub\tstall_rs_mul_div_mod\tstall_rs_cmp\tstall_rs_vector\tstall_load_buffer\tstall_store_buffer\tstall_branch\thost_s\n" > "$TMP/sweep.tsv"
+
+n=0
+for config in "${configs[@]}"; do
+    n=$((n + 1))
+    defs=""
+    row=""
+    for def in $config; do
+        defs="$defs -D$def"
+        row="$row${def#*=}\t"
+    done
+
+    echo "[$n/${#configs[@]}]$config"
+    make -C "$TMP/tree" -B --no-print-directory ARCH="$defs" tomasulo.out > /dev/null
+
+    for kernel in "$@"; do
+        printf "$row$(basename "$kernel" .asm)\t" >> "$TMP/sweep.tsv"
+        "$TMP/tree/tomasulo.out" -q "$kernel" | awk '
+            /Host time/                 { sec = $3 }
+            /^Retired/                  { instr = $2; cycles = $5 }
+            /Stall: fetch queue empty/  { fetch = $5 }
+            /Stall: add-sub rsc/        { rs_add_sub = $4 }
+            /Stall: mul-div-mod rsc/    { rs_mul_div_mod = $4 }
+            /Stall: cmp rsc/            { rs_cmp = $4 }
+            /Stall: vector rsc/         { rs_vector = $4 }
+            /Stall: load buffer/        { load_buffer = $4 }
+            /Stall: store buffer/       { store_buffer = $4 }
+            /Stall: branch/             { branch = $3 }
+            END {
+                printf "%s\t%s\t%.6f\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\t%s\n", cycles, instr, (cycles > 0 ? instr / cycles : 0),
+                       fetch, rs_add_sub, rs_mul_div_mod, rs_cmp, rs_vector, load_buffer, store_buffer, branch, sec
+            }' >> "$TMP/sweep.tsv"
+    done
+done
+
+"$RESDB" pack "$TMP/sweep.tsv" "$OUTPUT"
+"$RESDB" info "$OUTPUT"
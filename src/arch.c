@@ -2,9 +2,11 @@
 #include <log.h>
 #include <compiler.h>
 #include <inttypes.h>
+#include <sim_log.h>
 
-/* our board */
-Board board;
+/* our board, cores switch current_board to own one */
+static Board board_default;
+__thread Board *current_board = &board_default;
 
 /*
     Get const char* from type
@@ -23,6 +25,20 @@ static ___inline___ const char *job_get_str(job_t job);
     This is a void function
 */
 static ___inline___ void register_set_free(Register_info *reg);
+static ___inline___ void vector_register_set_free(Vector_register_info *reg);
+
+/*
+    Read / Write word of memory, through store buffer iff RAM is shared
+
+    PARAMS
+    @IN addr - address of word
+    @IN val - value
+
+    RETURN
+    Value of word (read)
+*/
+static ___inline___ DWORD memory_read(uint32_t addr);
+static ___inline___ void memory_write(uint32_t addr, DWORD val);
 
 /*
     Arythemtic operations
@@ -65,6 +81,11 @@ static ___inline___ void do_jleq(uint32_t line);
 static ___inline___  void memory_dump(void);
 static ___inline___  void register_dump(const Register_info *reg);
 static ___inline___ void registers_dump(void);
+static ___inline___ void vector_register_dump(const Vector_register_info *reg);
+static ___inline___ void vector_registers_dump(void);
+static ___inline___ void fetch_queue_dump(const Fetch_queue *fq);
+static ___inline___ void load_store_queue_dump(void);
+static ___inline___ void functional_units_dump(void);
 
 static ___inline___ const char *state_get_str(state_t state)
 {
@@ -97,6 +118,8 @@ static ___inline___ const char *job_get_str(job_t job)
             return "LOAD";
         case JOB_STORE:
             return "STORE";
+        case JOB_VECTOR:
+            return "VECTOR";
         default:
             return NULL;
     }
@@ -130,7 +153,7 @@ static const char *arythmetic_get_str_from_type(arythemtic_t type)
 void go_to_next_instruction(void)
 {
     TRACE();
-    ++board.pc;
+    ++board.ctx->pc;
 }
 
 static ___inline___ void register_set_free(Register_info *reg)
@@ -143,8 +166,17 @@ static ___inline___ void register_set_free(Register_info *reg)
     reg->state      = STATE_FREE;
     reg->job        = JOB_IDLE;
     reg->aryth_type = OP_NONE;
+}
+
+static ___inline___ void vector_register_set_free(Vector_register_info *reg)
+{
+    TRACE();
+
+    if (reg == NULL)
+        return;
 
-    (void)memset((void *)&reg->worker, 0, sizeof(Worker));
+    reg->state = STATE_FREE;
+    reg->job   = JOB_IDLE;
 }
 
 static ___inline___ void do_add(Register_info *dst, Register_info *src1, Register_info *src2)
@@ -199,7 +231,8 @@ static ___inline___ void do_div(Register_info *dst, Register_info *src1, Registe
     if (dst == NULL || src1 == NULL || src2 == NULL)
         return;
 
-    dst->val = src1->val / src2->val;
+    /* x / 0 is defined, program of one client can not kill the host */
+    dst->val = src2->val == 0 ? 0 : src1->val / src2->val;
 
     /* free registers */
     register_set_free(dst);
@@ -214,7 +247,7 @@ static ___inline___ void do_mod(Register_info *dst, Register_info *src1, Registe
     if (dst == NULL || src1 == NULL || src2 == NULL)
         return;
 
-    dst->val = src1->val % src2->val;
+    dst->val = src2->val == 0 ? 0 : src1->val % src2->val;
 
     /* free registers */
     register_set_free(dst);
@@ -226,59 +259,55 @@ static ___inline___ void do_jeq(uint32_t line)
 {
     TRACE();
 
-    if (board.cf == 0)
-        board.pc = line;
+    if (board.ctx->cf == 0)
+        board.ctx->pc = line;
 }
 
 static ___inline___ void do_jneq(uint32_t line)
 {
     TRACE();
 
-    if (board.cf != 0)
-        board.pc = line;
+    if (board.ctx->cf != 0)
+        board.ctx->pc = line;
 }
 
 static ___inline___ void do_jgt(uint32_t line)
 {
     TRACE();
 
-    if (board.cf == 1)
-        board.pc = line;
+    if (board.ctx->cf == 1)
+        board.ctx->pc = line;
 }
 
 static ___inline___ void do_jgeq(uint32_t line)
 {
     TRACE();
 
-    if (board.cf >= 0)
-        board.pc = line;
+    if (board.ctx->cf >= 0)
+        board.ctx->pc = line;
 }
 
 static ___inline___ void do_jlt(uint32_t line)
 {
     TRACE();
 
-    if (board.cf == -1)
-        board.pc = line;
+    if (board.ctx->cf == -1)
+        board.ctx->pc = line;
 }
 
 static ___inline___ void do_jleq(uint32_t line)
 {
     TRACE();
 
-    if (board.cf <= 0)
-        board.pc = line;
+    if (board.ctx->cf <= 0)
+        board.ctx->pc = line;
 }
 
 static ___inline___  void memory_dump(void)
 {
-    size_t i;
-
     TRACE();
 
-    printf("RAM %zu size\n", (size_t)RAM_SIZE);
-    for (i = 0; i < (size_t)RAM_SIZE; ++i)
-        printf("MEM[ %zu ] = %ld\n", i, board.ram.memory[i]);
+    ram_dump(board.ram);
 }
 
 
@@ -303,21 +332,118 @@ static ___inline___ void registers_dump(void)
     size_t i;
 
     for (i = 0; i < (size_t)REGISTERS_NUM; ++i)
-        register_dump(&board.registers.regs[i]);
+        register_dump(&board.ctx->registers.regs[i]);
+}
+
+static ___inline___ void vector_register_dump(const Vector_register_info *reg)
+{
+    size_t i;
+
+    TRACE();
+
+    printf("V%" PRIu32 "\n", reg->nr);
+    printf("\tState = %s\n", state_get_str(reg->state));
+    printf("\tJob   = %s\n", job_get_str(reg->job));
+    printf("\tValue =");
+    for (i = 0; i < VECTOR_LENGTH; ++i)
+        printf(" %lu", reg->val[i]);
+    printf("\n");
+}
+
+static ___inline___ void vector_registers_dump(void)
+{
+    size_t i;
+
+    for (i = 0; i < (size_t)VREGISTERS_NUM; ++i)
+        vector_register_dump(&board.ctx->registers.vregs[i]);
+}
+
+static ___inline___ void fetch_queue_dump(const Fetch_queue *fq)
+{
+    size_t i;
+
+    TRACE();
+
+    printf("Fetch queue %zu entries, fetch PC = %lu\n", fq->num_entries, fq->fetch_pc);
+    for (i = 0; i < fq->num_entries; ++i)
+        printf("FQ[ %zu ] = PC %lu\n", i, fq->pc[(fq->head + i) % FETCH_QUEUE_SIZE]);
+}
+
+static ___inline___ void load_store_queue_dump(void)
+{
+    size_t i;
+    const IO_info *io;
+
+    TRACE();
+
+    printf("LSQ %zu entries\n", board.lsq.num_entries);
+    for (i = 0; i < board.lsq.num_entries; ++i)
+    {
+        io = board.lsq.entry[i];
+        printf("LSQ[ %zu ] = %s", i, job_get_str(io->job));
+        if (io->src.type == VAR_MEMORY)
+            printf(" from M%" PRIu32, io->src.nr);
+        if (io->dst.type == VAR_MEMORY)
+            printf(" to M%" PRIu32, io->dst.nr);
+        printf("\n");
+    }
+
+    printf("\tForwarded loads = %" PRIu64 "\n", board.lsq.forwarded);
+    printf("\tConflict replays = %" PRIu64 "\n", board.lsq.blocked);
+    printf("\tMemory-level parallelism = %.2lf\n",
+           board.lsq.inflight_cycles == 0 ? 0.0 :
+           (double)board.lsq.inflight_sum / (double)board.lsq.inflight_cycles);
+}
+
+static ___inline___ void functional_units_dump(void)
+{
+    size_t i;
+
+    TRACE();
+
+    for (i = 0; i < FU_ADD_SUB_NUM; ++i)
+        printf("FU ADD-SUB[ %zu ] ops = %" PRIu64 " busy cycles = %" PRIu64 "\n",
+               i, board.fu.add[i].ops, board.fu.add[i].busy_cycles);
+
+    for (i = 0; i < FU_MUL_DIV_MOD_NUM; ++i)
+        printf("FU MUL-DIV-MOD[ %zu ] ops = %" PRIu64 " busy cycles = %" PRIu64 "\n",
+               i, board.fu.mul[i].ops, board.fu.mul[i].busy_cycles);
+
+    for (i = 0; i < FU_CMP_NUM; ++i)
+        printf("FU CMP[ %zu ] ops = %" PRIu64 " busy cycles = %" PRIu64 "\n",
+               i, board.fu.cmp[i].ops, board.fu.cmp[i].busy_cycles);
+
+    for (i = 0; i < FU_VECTOR_NUM; ++i)
+        printf("FU VECTOR[ %zu ] ops = %" PRIu64 " busy cycles = %" PRIu64 "\n",
+               i, board.fu.vec[i].ops, board.fu.vec[i].busy_cycles);
+
+    printf("\tReady ops waiting for unit: ADD-SUB = %" PRIu64 " MUL-DIV-MOD = %" PRIu64 " CMP = %" PRIu64 " VECTOR = %" PRIu64 "\n",
+           board.fu.add_stalls, board.fu.mul_stalls, board.fu.cmp_stalls, board.fu.vec_stalls);
 }
 
 void reset_board(void)
 {
     size_t i;
+    size_t t;
 
     TRACE();
 
     LOG("Reseting board\n");
 
+    deinit_board();
     (void)memset(&board, 0, sizeof(Board));
 
-    for (i = 0; i < REGISTERS_NUM; ++i)
-        board.registers.regs[i].nr = (uint32_t)i;
+    for (t = 0; t < SMT_THREADS_MAX; ++t)
+    {
+        for (i = 0; i < REGISTERS_NUM; ++i)
+            board.thread[t].registers.regs[i].nr = (uint32_t)i;
+
+        for (i = 0; i < VREGISTERS_NUM; ++i)
+            board.thread[t].registers.vregs[i].nr = (uint32_t)i;
+    }
+
+    board.num_threads = 1;
+    board_switch_thread(0);
 
     for (i = 0; i < LOAD_BUFFER_SIZE; ++i)
         board.load_buffer.load[i].state = STATE_FREE;
@@ -332,6 +458,111 @@ void reset_board(void)
         board.rs.mul[i].state = STATE_FREE;
 
     board.rs.cmp.state = STATE_FREE;
+
+    for (i = 0; i < RS_VECTOR_SIZE; ++i)
+        board.rs.vec[i].state = STATE_FREE;
+
+    board.ram = &board.local_ram;
+
+    if (L2_ENABLED)
+    {
+        const Cache_config l2 = {
+            .size = L2_SIZE,
+            .assoc = L2_ASSOC,
+            .line_size = L2_LINE_SIZE,
+            .hit_cycles = L2_HIT_CYCLES,
+            .miss_cycles = L2_MISS_CYCLES,
+            .replacement = L2_REPLACEMENT
+        };
+
+        board.l2 = cache_create("L2", &l2, NULL, CYCLES_MOV_MEM);
+        if (board.l2 == NULL)
+            FATAL("L2 create error\n");
+    }
+
+    if (L1_ENABLED)
+    {
+        const Cache_config l1 = {
+            .size = L1_SIZE,
+            .assoc = L1_ASSOC,
+            .line_size = L1_LINE_SIZE,
+            .hit_cycles = L1_HIT_CYCLES,
+            .miss_cycles = L1_MISS_CYCLES,
+            .replacement = L1_REPLACEMENT
+        };
+
+        board.l1 = cache_create("L1", &l1, board.l2, CYCLES_MOV_MEM);
+        if (board.l1 == NULL)
+            FATAL("L1 create error\n");
+    }
+}
+
+void deinit_board(void)
+{
+    TRACE();
+
+    cache_destroy(board.l1);
+    cache_destroy(board.l2);
+    if (board.stores == NULL && board.ram != NULL)
+        ram_reset(board.ram);
+
+    board.l1 = NULL;
+    board.l2 = NULL;
+}
+
+void board_share_ram(RAM *ram, Ram_store_buffer *stores)
+{
+    TRACE();
+
+    board.ram = ram;
+    board.stores = stores;
+}
+
+static ___inline___ DWORD memory_read(uint32_t addr)
+{
+    if (board.stores != NULL)
+        return ram_store_buffer_read(board.stores, board.ram, addr);
+
+    return ram_read(board.ram, addr);
+}
+
+static ___inline___ void memory_write(uint32_t addr, DWORD val)
+{
+    if (board.stores != NULL)
+        ram_store_buffer_write(board.stores, addr, val);
+    else
+        ram_write(board.ram, addr, val);
+}
+
+int32_t memory_access_time(uint32_t addr, bool write)
+{
+    TRACE();
+
+    if (board.l1 != NULL)
+        return cache_access(board.l1, (uint64_t)addr * sizeof(DWORD), write);
+
+    if (board.l2 != NULL)
+        return cache_access(board.l2, (uint64_t)addr * sizeof(DWORD), write);
+
+    return CYCLES_MOV_MEM;
+}
+
+int32_t memory_access_time_range(uint32_t addr, uint32_t len, bool write)
+{
+    const uint64_t line_size = board.l1 != NULL ? L1_LINE_SIZE : L2_LINE_SIZE;
+    int32_t time = 0;
+    uint32_t i;
+
+    TRACE();
+
+    if (board.l1 == NULL && board.l2 == NULL)
+        return CYCLES_MOV_MEM;
+
+    for (i = 0; i < len; ++i)
+        if (i == 0 || ((uint64_t)(addr + i) * sizeof(DWORD)) % line_size == 0)
+            time += memory_access_time(addr + i, write);
+
+    return time;
 }
 
 void do_cmp(Register_info *r1, Register_info *r2)
@@ -343,11 +574,11 @@ void do_cmp(Register_info *r1, Register_info *r2)
 
     /* set CF */
     if (r1->val == r2->val)
-        board.cf = 0;
+        board.ctx->cf = 0;
     else if (r1->val < r2->val)
-        board.cf = -1;
+        board.ctx->cf = -1;
     else
-        board.cf = 1;
+        board.ctx->cf = 1;
 
     /* free registers */
     register_set_free(r1);
@@ -390,6 +621,76 @@ void do_arythmetic(arythemtic_t type, Register_info *dst, Register_info *src1, R
     }
 }
 
+Vector_register_info *vector_register_get(uint32_t nr)
+{
+    if (nr >= VREGISTERS_NUM)
+        return NULL;
+
+    return &board.ctx->registers.vregs[nr];
+}
+
+void do_vector_arythmetic(arythemtic_t type, Vector_register_info *dst, Vector_register_info *src1, Vector_register_info *src2)
+{
+    TRACE();
+
+    if (dst == NULL || src1 == NULL || src2 == NULL)
+        return;
+
+    switch (type)
+    {
+        case OP_ADD:
+        {
+            dst->val = src1->val + src2->val;
+            break;
+        }
+        case OP_MUL:
+        {
+            dst->val = src1->val * src2->val;
+            break;
+        }
+        default:
+            LOG("Unsupported vector op type\n");
+    }
+
+    /* free registers */
+    vector_register_set_free(dst);
+    vector_register_set_free(src1);
+    vector_register_set_free(src2);
+}
+
+void do_vector_load(Vector_register_info *dst, uint32_t addr)
+{
+    vreg_t val;
+    uint32_t i;
+
+    TRACE();
+
+    if (dst == NULL)
+        return;
+
+    /* RAM is sparse and paged, so words are gathered one by one */
+    for (i = 0; i < VECTOR_LENGTH; ++i)
+        val[i] = memory_read(addr + i);
+
+    dst->val = val;
+    vector_register_set_free(dst);
+}
+
+void do_vector_store(uint32_t addr, Vector_register_info *src)
+{
+    uint32_t i;
+
+    TRACE();
+
+    if (src == NULL)
+        return;
+
+    for (i = 0; i < VECTOR_LENGTH; ++i)
+        memory_write(addr + i, src->val[i]);
+
+    vector_register_set_free(src);
+}
+
 void do_jump(jump_t type, uint32_t line)
 {
     TRACE();
@@ -438,28 +739,25 @@ void copy_data_to_reg(uint32_t reg_num, Variable *var)
     Register_info *reg;
     TRACE();
 
-    if (reg_num > REGISTERS_NUM)
+    if (reg_num >= REGISTERS_NUM)
         return;
 
-    reg = &board.registers.regs[reg_num];
+    reg = &board.ctx->registers.regs[reg_num];
 
     switch (var->type)
     {
         case VAR_MEMORY:
         {
-            if (var->nr > RAM_SIZE)
-                return;
-
-            reg->val = board.ram.memory[var->nr];
+            reg->val = memory_read(var->nr);
             break;
         }
         case VAR_REGISTER:
         {
-            if (var->nr > REGISTERS_NUM)
+            if (var->nr >= REGISTERS_NUM)
                 return;
 
-            reg->val = board.registers.regs[var->nr].val;
-            register_set_free(&board.registers.regs[var->nr]);
+            reg->val = board.ctx->registers.regs[var->nr].val;
+            register_set_free(&board.ctx->registers.regs[var->nr]);
             break;
         }
         case VAR_VALUE:
@@ -474,35 +772,74 @@ void copy_data_to_reg(uint32_t reg_num, Variable *var)
     register_set_free(reg);
 }
 
-void copy_data_to_memory(uint32_t addr, Variable *var)
+reg_t variable_get_value(const Variable *var)
+{
+    TRACE();
+
+    switch (var->type)
+    {
+        case VAR_MEMORY:
+            return memory_read(var->nr);
+        case VAR_REGISTER:
+        {
+            if (var->nr >= REGISTERS_NUM)
+                return 0;
+
+            return board.ctx->registers.regs[var->nr].val;
+        }
+        case VAR_VALUE:
+            return var->val;
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+void copy_value_to_reg(uint32_t reg_num, reg_t val)
 {
+    Register_info *reg;
     TRACE();
 
-    if (addr > RAM_SIZE)
+    if (reg_num >= REGISTERS_NUM)
         return;
 
+    reg = &board.ctx->registers.regs[reg_num];
+    reg->val = val;
+
+    register_set_free(reg);
+}
+
+void copy_value_to_memory(uint32_t addr, reg_t val)
+{
+    TRACE();
+
+    memory_write(addr, val);
+}
+
+void copy_data_to_memory(uint32_t addr, Variable *var)
+{
+    TRACE();
+
     switch (var->type)
     {
         case VAR_MEMORY:
         {
-            if (var->nr > RAM_SIZE)
-                return;
-
-            board.ram.memory[addr] = board.ram.memory[var->nr];
+            memory_write(addr, memory_read(var->nr));
             break;
         }
         case VAR_REGISTER:
         {
-            if (var->nr > REGISTERS_NUM)
+            if (var->nr >= REGISTERS_NUM)
                 return;
 
-            board.ram.memory[addr] = board.registers.regs[var->nr].val;
-            register_set_free(&board.registers.regs[var->nr]);
+            memory_write(addr, board.ctx->registers.regs[var->nr].val);
+            register_set_free(&board.ctx->registers.regs[var->nr]);
             break;
         }
         case VAR_VALUE:
         {
-            board.ram.memory[addr] = var->val;
+            memory_write(addr, var->val);
             break;
         }
         default:
@@ -512,13 +849,68 @@ void copy_data_to_memory(uint32_t addr, Variable *var)
 
 void board_dump(void)
 {
+    Hw_thread *ctx = board.ctx;
+    size_t t;
+
     TRACE();
     
     printf("ARCH %zu bits\n", sizeof(DWORD) << 3);
-    printf("PC = %lu\n", board.pc);
-    printf("CF = %d\n", board.cf);
-    printf("\n");
-    registers_dump();
+    for (t = 0; t < board.num_threads; ++t)
+    {
+        board_switch_thread(t);
+        if (board.num_threads > 1)
+            printf("Thread %zu\n", t);
+
+        printf("PC = %lu\n", board.ctx->pc);
+        printf("CF = %d\n", board.ctx->cf);
+        fetch_queue_dump(&board.fetch_queue[t]);
+        if (board.loop_buffer[t].active)
+            printf("Loop buffer PC %lu - %lu\n", board.loop_buffer[t].start, board.loop_buffer[t].end);
+        printf("\n");
+        registers_dump();
+        vector_registers_dump();
+    }
+    board.ctx = ctx;
+
     memory_dump();
+    load_store_queue_dump();
+    functional_units_dump();
+    cache_dump(board.l1);
+    cache_dump(board.l2);
     printf("\n");
+}
+
+void board_dump_arch(void)
+{
+    Hw_thread *ctx = board.ctx;
+    size_t t;
+    size_t i;
+    size_t j;
+
+    TRACE();
+
+    printf("Architectural state\n");
+    for (t = 0; t < board.num_threads; ++t)
+    {
+        board_switch_thread(t);
+        if (board.num_threads > 1)
+            printf("Thread %zu\n", t);
+
+        printf("PC = %lu\n", board.ctx->pc);
+        printf("CF = %d\n", board.ctx->cf);
+        for (i = 0; i < (size_t)REGISTERS_NUM; ++i)
+            printf("R%zu = %lu\n", i, board.ctx->registers.regs[i].val);
+
+        for (i = 0; i < (size_t)VREGISTERS_NUM; ++i)
+        {
+            printf("V%zu =", i);
+            for (j = 0; j < VECTOR_LENGTH; ++j)
+                printf(" %lu", board.ctx->registers.vregs[i].val[j]);
+            printf("\n");
+        }
+    }
+    board.ctx = ctx;
+
+    memory_dump();
+    printf("End of architectural state\n");
 }
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include <cache.h>
+#include <log.h>
+#include <compiler.h>
+#include <common.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <sim_log.h>
+
+/*
+    Get const char* from replacement policy
+*/
+static ___inline___ const char *replacement_get_str(cache_replacement_t replacement);
+
+/*
+    Choose line to evict from set
+
+    PARAMS
+    @IN cache - pointer to cache
+    @IN set - pointer to first line in set
+
+    RETURN
+    Pointer to victim line
+*/
+static ___inline___ Cache_line *cache_get_victim(Cache *cache, Cache_line *set);
+
+static ___inline___ const char *replacement_get_str(cache_replacement_t replacement)
+{
+    switch (replacement)
+    {
+        case CACHE_REPLACEMENT_LRU:
+            return "LRU";
+        case CACHE_REPLACEMENT_FIFO:
+            return "FIFO";
+        case CACHE_REPLACEMENT_RANDOM:
+            return "RANDOM";
+        default:
+            return NULL;
+    }
+
+    return NULL;
+}
+
+static ___inline___ Cache_line *cache_get_victim(Cache *cache, Cache_line *set)
+{
+    size_t i;
+    Cache_line *victim;
+
+    TRACE();
+
+    /* invalid line is the best victim */
+    for (i = 0; i < cache->config.assoc; ++i)
+        if (!set[i].valid)
+            return &set[i];
+
+    if (cache->config.replacement == CACHE_REPLACEMENT_RANDOM)
+    {
+        /* xorshift32 */
+        cache->seed ^= cache->seed << 13;
+        cache->seed ^= cache->seed >> 17;
+        cache->seed ^= cache->seed << 5;
+
+        return &set[cache->seed % cache->config.assoc];
+    }
+
+    /* LRU and FIFO differ only in stamp update */
+    victim = &set[0];
+    for (i = 1; i < cache->config.assoc; ++i)
+        if (set[i].stamp < victim->stamp)
+            victim = &set[i];
+
+    return victim;
+}
+
+Cache *cache_create(const char *name, const Cache_config *config, Cache *next, int32_t memory_cycles)
+{
+    Cache *cache;
+
+    TRACE();
+
+    if (config == NULL)
+        ERROR("config == NULL\n", NULL);
+
+    if (config->assoc == 0 || config->line_size == 0 || config->size < config->assoc * config->line_size)
+        ERROR("Incorrect cache geometry\n", NULL);
+
+    cache = (Cache *)malloc(sizeof(Cache));
+    if (cache == NULL)
+        ERROR("malloc error\n", NULL);
+
+    (void)memset(cache, 0, sizeof(Cache));
+
+    cache->name = name;
+    cache->config = *config;
+    cache->num_sets = config->size / (config->assoc * config->line_size);
+    cache->next = next;
+    cache->memory_cycles = memory_cycles;
+    cache->seed = 0x9E3779B9U;
+
+    cache->lines = (Cache_line *)calloc(cache->num_sets * config->assoc, sizeof(Cache_line));
+    if (cache->lines == NULL)
+    {
+        FREE(cache);
+        ERROR("calloc error\n", NULL);
+    }
+
+    return cache;
+}
+
+void cache_destroy(Cache *cache)
+{
+    TRACE();
+
+    if (cache == NULL)
+        return;
+
+    FREE(cache->lines);
+    FREE(cache);
+}
+
+int32_t cache_access(Cache *cache, uint64_t addr, bool write)
+{
+    uint64_t line_nr;
+    uint64_t tag;
+    Cache_line *set;
+    Cache_line *line;
+    size_t i;
+    int32_t time;
+
+    TRACE();
+
+    line_nr = addr / cache->config.line_size;
+    tag = line_nr / cache->num_sets;
+    set = &cache->lines[(line_nr % cache->num_sets) * cache->config.assoc];
+
+    ++cache->clock;
+    for (i = 0; i < cache->config.assoc; ++i)
+        if (set[i].valid && set[i].tag == tag)
+        {
+            LOG("%s hit 0x%" PRIx64 "\n", cache->name, addr);
+            ++cache->hits;
+
+            if (cache->config.replacement == CACHE_REPLACEMENT_LRU)
+                set[i].stamp = cache->clock;
+
+            set[i].dirty |= write;
+            return cache->config.hit_cycles;
+        }
+
+    LOG("%s miss 0x%" PRIx64 "\n", cache->name, addr);
+    ++cache->misses;
+
+    /* fill line from next level */
+    if (cache->next != NULL)
+        time = cache->config.miss_cycles + cache_access(cache->next, addr, false);
+    else
+        time = cache->config.miss_cycles + cache->memory_cycles;
+
+    line = cache_get_victim(cache, set);
+
+    /* write back is buffered, so it does not extend latency */
+    if (line->valid && line->dirty)
+    {
+        ++cache->writebacks;
+        if (cache->next != NULL)
+            (void)cache_access(cache->next, (line->tag * cache->num_sets + (line_nr % cache->num_sets)) * cache->config.line_size, true);
+    }
+
+    line->valid = true;
+    line->dirty = write;
+    line->tag = tag;
+    line->stamp = cache->clock;
+
+    return time;
+}
+
+void cache_dump(const Cache *cache)
+{
+    uint64_t accesses;
+
+    TRACE();
+
+    if (cache == NULL)
+        return;
+
+    accesses = cache->hits + cache->misses;
+
+    printf("%s %zuB %zu-way %zuB line %s, hit = %" PRId32 " miss = %" PRId32 "\n",
+           cache->name, cache->config.size, cache->config.assoc, cache->config.line_size,
+           replacement_get_str(cache->config.replacement), cache->config.hit_cycles, cache->config.miss_cycles);
+    printf("\tHits = %" PRIu64 " Misses = %" PRIu64 " Writebacks = %" PRIu64 " Hit rate = %.2lf%%\n",
+           cache->hits, cache->misses, cache->writebacks,
+           accesses == 0 ? 0.0 : 100.0 * (double)cache->hits / (double)accesses);
+}
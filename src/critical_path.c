@@ -0,0 +1,476 @@
+#include <critical_path.h>
+#include <log.h>
+#include <compiler.h>
+#include <common.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+/* first size of memory table, grows twice when half full */
+#define CRITICAL_PATH_MEM_INIT_SIZE 1024
+
+/*
+    Get node from free list or allocate new one
+
+    PARAMS
+    @IN cp - pointer to critical path
+
+    RETURN
+    Pointer to node
+*/
+static ___inline___ Critical_path_node *critical_path_node_alloc(Critical_path *cp);
+
+/*
+    Take / release reference to node, node without references goes to free list
+    together with its producers which are not referenced elsewhere
+
+    PARAMS
+    @IN cp - pointer to critical path
+    @IN node - pointer to node (can be NULL)
+
+    RETURN
+    Node / This is a void function
+*/
+static ___inline___ Critical_path_node *critical_path_node_get(Critical_path_node *node);
+static void critical_path_node_put(Critical_path *cp, Critical_path_node *node);
+
+/*
+    Replace last writer in slot of table
+
+    PARAMS
+    @IN cp - pointer to critical path
+    @IN slot - pointer to slot
+    @IN node - new last writer
+
+    RETURN
+    This is a void function
+*/
+static ___inline___ void critical_path_slot_set(Critical_path *cp, Critical_path_node **slot, Critical_path_node *node);
+
+/*
+    Find slot of memory word in table
+
+    PARAMS
+    @IN mem - pointer to memory table
+    @IN addr - address of word
+
+    RETURN
+    Index of slot with address or of empty slot where address belongs
+*/
+static ___inline___ size_t critical_path_mem_find(const Critical_path_mem *mem, uint32_t addr);
+
+/*
+    Double size of memory table (or create it)
+
+    PARAMS
+    @IN mem - pointer to memory table
+
+    RETURN
+    This is a void function
+*/
+static void critical_path_mem_grow(Critical_path_mem *mem);
+
+/*
+    Get slot of last writer of operand
+
+    PARAMS
+    @IN cp - pointer to critical path
+    @IN thread - hardware thread of instruction
+    @IN var - register, vector register or memory operand
+    @IN offset - word offset in memory range (vector load / store)
+    @IN write - true iff slot is needed for write (memory slot is created)
+
+    RETURN
+    NULL iff operand has no writer (value, or memory never written)
+    Pointer to slot iff success
+*/
+static Critical_path_node **critical_path_slot(Critical_path *cp, uint32_t thread, const Variable *var,
+                                               uint32_t offset, bool write);
+
+/*
+    Producer of operand is candidate for the longest path to instruction
+
+    PARAMS
+    @IN cp - pointer to critical path
+    @IN thread - hardware thread of instruction
+    @IN var - operand
+    @IN len - number of memory words read by operand
+    @IN best - pointer to the latest finishing producer so far
+
+    RETURN
+    This is a void function
+*/
+static void critical_path_read(Critical_path *cp, uint32_t thread, const Variable *var, uint32_t len,
+                               Critical_path_node **best);
+
+/*
+    Instruction becomes the last writer of operand
+
+    PARAMS
+    @IN cp - pointer to critical path
+    @IN thread - hardware thread of instruction
+    @IN var - operand
+    @IN len - number of memory words written by operand
+    @IN node - node of instruction
+
+    RETURN
+    This is a void function
+*/
+static void critical_path_write(Critical_path *cp, uint32_t thread, const Variable *var, uint32_t len,
+                                Critical_path_node *node);
+
+/*
+    Arythmetic and cmp read register file by number of every operand
+
+    PARAMS
+    @IN var - operand
+
+    RETURN
+    Register operand
+*/
+static ___inline___ Variable critical_path_register_operand(const Variable *var);
+
+static ___inline___ Critical_path_node *critical_path_node_alloc(Critical_path *cp)
+{
+    Critical_path_node *node;
+
+    if (cp->free_nodes == NULL)
+    {
+        node = (Critical_path_node *)malloc(sizeof(Critical_path_node));
+        if (node == NULL)
+            FATAL("Malloc error\n");
+
+        return node;
+    }
+
+    node = cp->free_nodes;
+    cp->free_nodes = node->prev;
+
+    return node;
+}
+
+static ___inline___ Critical_path_node *critical_path_node_get(Critical_path_node *node)
+{
+    if (node != NULL)
+        ++node->refs;
+
+    return node;
+}
+
+static void critical_path_node_put(Critical_path *cp, Critical_path_node *node)
+{
+    Critical_path_node *prev;
+
+    /* iterative, because path can be as long as program */
+    while (node != NULL && --node->refs == 0)
+    {
+        prev = node->prev;
+        node->prev = cp->free_nodes;
+        cp->free_nodes = node;
+        node = prev;
+    }
+}
+
+static ___inline___ void critical_path_slot_set(Critical_path *cp, Critical_path_node **slot, Critical_path_node *node)
+{
+    (void)critical_path_node_get(node);
+    critical_path_node_put(cp, *slot);
+    *slot = node;
+}
+
+static ___inline___ size_t critical_path_mem_find(const Critical_path_mem *mem, uint32_t addr)
+{
+    size_t i = (size_t)(addr * 2654435761U) & (mem->size - 1);
+
+    while (mem->node[i] != NULL && mem->addr[i] != addr)
+        i = (i + 1) & (mem->size - 1);
+
+    return i;
+}
+
+static void critical_path_mem_grow(Critical_path_mem *mem)
+{
+    Critical_path_mem old = *mem;
+    size_t i;
+    size_t j;
+
+    TRACE();
+
+    mem->size = old.size == 0 ? CRITICAL_PATH_MEM_INIT_SIZE : old.size << 1;
+    mem->addr = (uint32_t *)malloc(sizeof(uint32_t) * mem->size);
+    mem->node = (Critical_path_node **)calloc(mem->size, sizeof(Critical_path_node *));
+    if (mem->addr == NULL || mem->node == NULL)
+        FATAL("Malloc error\n");
+
+    for (i = 0; i < old.size; ++i)
+        if (old.node[i] != NULL)
+        {
+            j = critical_path_mem_find(mem, old.addr[i]);
+            mem->addr[j] = old.addr[i];
+            mem->node[j] = old.node[i];
+        }
+
+    FREE(old.addr);
+    FREE(old.node);
+}
+
+static Critical_path_node **critical_path_slot(Critical_path *cp, uint32_t thread, const Variable *var,
+                                               uint32_t offset, bool write)
+{
+    Critical_path_mem *mem = &cp->mem;
+    uint32_t addr;
+    size_t i;
+
+    switch (var->type)
+    {
+        case VAR_REGISTER:
+            return var->nr < REGISTERS_NUM ? &cp->reg[thread][var->nr] : NULL;
+        case VAR_VREGISTER:
+            return var->nr < VREGISTERS_NUM ? &cp->vreg[thread][var->nr] : NULL;
+        case VAR_MEMORY:
+            break;
+        default:
+            return NULL;
+    }
+
+    addr = var->nr + offset;
+    if (mem->size == 0)
+    {
+        if (!write)
+            return NULL;
+
+        critical_path_mem_grow(mem);
+    }
+
+    i = critical_path_mem_find(mem, addr);
+    if (mem->node[i] != NULL)
+        return &mem->node[i];
+
+    if (!write)
+        return NULL;
+
+    if ((mem->used + 1) * 2 > mem->size)
+    {
+        critical_path_mem_grow(mem);
+        i = critical_path_mem_find(mem, addr);
+    }
+
+    /* slot is taken by caller at once */
+    ++mem->used;
+    mem->addr[i] = addr;
+
+    return &mem->node[i];
+}
+
+static void critical_path_read(Critical_path *cp, uint32_t thread, const Variable *var, uint32_t len,
+                               Critical_path_node **best)
+{
+    Critical_path_node **slot;
+    uint32_t i;
+
+    for (i = 0; i < len; ++i)
+        if ((slot = critical_path_slot(cp, thread, var, i, false)) != NULL && *slot != NULL &&
+            (*best == NULL || (*slot)->finish > (*best)->finish))
+            *best = *slot;
+}
+
+static void critical_path_write(Critical_path *cp, uint32_t thread, const Variable *var, uint32_t len,
+                                Critical_path_node *node)
+{
+    Critical_path_node **slot;
+    uint32_t i;
+
+    for (i = 0; i < len; ++i)
+        if ((slot = critical_path_slot(cp, thread, var, i, true)) != NULL)
+            critical_path_slot_set(cp, slot, node);
+}
+
+static ___inline___ Variable critical_path_register_operand(const Variable *var)
+{
+    Variable reg = *var;
+
+    reg.type = VAR_REGISTER;
+
+    return reg;
+}
+
+void critical_path_init(Critical_path *cp)
+{
+    TRACE();
+
+    (void)memset(cp, 0, sizeof(*cp));
+}
+
+void critical_path_deinit(Critical_path *cp)
+{
+    Critical_path_node *node;
+    size_t t;
+    size_t i;
+
+    TRACE();
+
+    for (t = 0; t < SMT_THREADS_MAX; ++t)
+    {
+        for (i = 0; i < REGISTERS_NUM; ++i)
+            critical_path_node_put(cp, cp->reg[t][i]);
+
+        for (i = 0; i < VREGISTERS_NUM; ++i)
+            critical_path_node_put(cp, cp->vreg[t][i]);
+
+        critical_path_node_put(cp, cp->cf[t]);
+    }
+
+    for (i = 0; i < cp->mem.size; ++i)
+        critical_path_node_put(cp, cp->mem.node[i]);
+
+    critical_path_node_put(cp, cp->last);
+
+    while ((node = cp->free_nodes) != NULL)
+    {
+        cp->free_nodes = node->prev;
+        FREE(node);
+    }
+
+    FREE(cp->mem.addr);
+    FREE(cp->mem.node);
+    (void)memset(cp, 0, sizeof(*cp));
+}
+
+void critical_path_issue(Critical_path *cp, Instructions_status *is, uint32_t latency)
+{
+    Critical_path_node *node;
+    Critical_path_node *best = NULL;
+    const Token *token = is->token;
+    const uint32_t t = is->thread;
+    Variable var[3];
+    const Variable *dst = NULL; /* NULL iff instruction writes only CF or nothing */
+    uint32_t dst_len = 1;
+
+    TRACE();
+
+    node = critical_path_node_alloc(cp);
+    node->refs = 1; /* instruction in flight */
+    node->id = is->id;
+    node->issue_cycle = is->issue_cycle;
+    node->exec_cycle = 0;
+    node->latency = latency;
+    node->token = token;
+
+    /* producers first, instruction can read what it writes (write releases old writer) */
+    switch (token->type)
+    {
+        case TOKEN_ARYTHMETIC:
+        {
+            var[0] = critical_path_register_operand(&token->token_arythmetic.dst);
+            var[1] = critical_path_register_operand(&token->token_arythmetic.src1);
+            var[2] = critical_path_register_operand(&token->token_arythmetic.src2);
+            critical_path_read(cp, t, &var[1], 1, &best);
+            critical_path_read(cp, t, &var[2], 1, &best);
+            dst = &var[0];
+            break;
+        }
+        case TOKEN_CMP:
+        {
+            var[1] = critical_path_register_operand(&token->token_cmp.src1);
+            var[2] = critical_path_register_operand(&token->token_cmp.src2);
+            critical_path_read(cp, t, &var[1], 1, &best);
+            critical_path_read(cp, t, &var[2], 1, &best);
+            break;
+        }
+        case TOKEN_JUMP:
+        {
+            best = cp->cf[t];
+            break;
+        }
+        case TOKEN_MOVE:
+        {
+            critical_path_read(cp, t, &token->token_move.src, 1, &best);
+            dst = &token->token_move.dst;
+            break;
+        }
+        case TOKEN_VECTOR:
+        {
+            /* vld / vst touch VECTOR_LENGTH words, vector registers are one operand */
+            critical_path_read(cp, t, &token->token_vector.src1,
+                               token->token_vector.src1.type == VAR_MEMORY ? VECTOR_LENGTH : 1, &best);
+            critical_path_read(cp, t, &token->token_vector.src2, 1, &best);
+            dst = &token->token_vector.dst;
+            dst_len = dst->type == VAR_MEMORY ? VECTOR_LENGTH : 1;
+            break;
+        }
+        default:
+            break;
+    }
+
+    node->prev = critical_path_node_get(best);
+    node->finish = (best == NULL ? 0 : best->finish) + (uint64_t)latency;
+
+    if (dst != NULL)
+        critical_path_write(cp, t, dst, dst_len, node);
+    else if (token->type == TOKEN_CMP)
+        critical_path_slot_set(cp, &cp->cf[t], node);
+
+    if (cp->last == NULL || node->finish > cp->last->finish)
+        critical_path_slot_set(cp, &cp->last, node);
+
+    ++cp->num_instructions;
+    is->node = node;
+}
+
+void critical_path_retire(Critical_path *cp, Instructions_status *is)
+{
+    TRACE();
+
+    if (is->node == NULL)
+        return;
+
+    is->node->exec_cycle = is->exec_cycle;
+    critical_path_node_put(cp, is->node);
+    is->node = NULL;
+}
+
+void critical_path_print(const Critical_path *cp, uint32_t cycles)
+{
+    const Critical_path_node *node;
+    const Critical_path_node **path;
+    const uint64_t bound = cp->last == NULL ? 0 : cp->last->finish;
+    size_t path_len = 0;
+
+    TRACE();
+
+    if (cp->num_instructions == 0)
+        return;
+
+    printf("Critical path analysis\n");
+    printf("\tSimulated cycles   = %" PRIu32 "\n", cycles);
+    printf("\tDataflow bound     = %" PRIu64 "\n", bound);
+    printf("\tIssue bound        = %" PRIu64 "\n", cp->num_instructions);
+    printf("\tCycles / dataflow  = %.2lf\n", bound == 0 ? 0.0 : (double)cycles / (double)bound);
+    printf("\tProgram is %s bound\n", bound >= cp->num_instructions ? "latency" : "issue");
+
+    for (node = cp->last; node != NULL; node = node->prev)
+        ++path_len;
+
+    path = (const Critical_path_node **)malloc(sizeof(Critical_path_node *) * path_len);
+    if (path == NULL)
+    {
+        fprintf(stderr, "Cannot print critical path: malloc error\n");
+        return;
+    }
+
+    /* walk back from last instruction on path */
+    path_len = 0;
+    for (node = cp->last; node != NULL; node = node->prev)
+        path[path_len++] = node;
+
+    printf("Critical path (%zu instructions)\n", path_len);
+    while (path_len > 0)
+    {
+        node = path[--path_len];
+        printf("\t[ %" PRIu64 " ] issue = %" PRIu32 " exec = %" PRIu32 " latency = %" PRIu32 "\t",
+               node->id, node->issue_cycle, node->exec_cycle, node->latency);
+        token_print(node->token);
+    }
+
+    FREE(path);
+}
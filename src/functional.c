@@ -0,0 +1,542 @@
+#include <functional.h>
+#include <arch.h>
+#include <log.h>
+#include <compiler.h>
+#include <common.h>
+#include <stdlib.h>
+
+/*
+    Get register for operand of arythmetic or cmp. Units read register file by number
+    of every operand (also M and #), like tomasulo does. Out of range operand
+    (parser rejects it) reads temporary register
+
+    PARAMS
+    @IN var - pointer to variable
+    @OUT tmp - temporary register
+
+    RETURN
+    Pointer to register
+*/
+static ___inline___ Register_info *functional_get_reg(const Variable *var, Register_info *tmp);
+
+/*
+    Execute one instruction on board
+
+    PARAMS
+    @IN token - instruction
+    @IN warm_caches - touch caches on memory access
+
+    RETURN
+    This is a void function
+*/
+static ___inline___ void functional_step(Token *token, bool warm_caches);
+
+static ___inline___ Register_info *functional_get_reg(const Variable *var, Register_info *tmp)
+{
+    if (var->nr < REGISTERS_NUM)
+        return &board.ctx->registers.regs[var->nr];
+
+    tmp->val = 0;
+    return tmp;
+}
+
+static ___inline___ void functional_step(Token *token, bool warm_caches)
+{
+    Register_info tmp0;
+    Register_info tmp1;
+    Register_info tmp2;
+    Token_move *tmove;
+    Token_arythmetic *taryth;
+    Token_vector *tvec;
+
+    switch (token->type)
+    {
+        case TOKEN_VECTOR:
+        {
+            tvec = &token->token_vector;
+            switch (tvec->type)
+            {
+                case VOP_ADD:
+                case VOP_MUL:
+                {
+                    do_vector_arythmetic(tvec->type == VOP_ADD ? OP_ADD : OP_MUL,
+                                         vector_register_get(tvec->dst.nr),
+                                         vector_register_get(tvec->src1.nr),
+                                         vector_register_get(tvec->src2.nr));
+                    break;
+                }
+                case VOP_LOAD:
+                {
+                    if (warm_caches)
+                        (void)memory_access_time_range(tvec->src1.nr, VECTOR_LENGTH, false);
+
+                    do_vector_load(vector_register_get(tvec->dst.nr), tvec->src1.nr);
+                    break;
+                }
+                case VOP_STORE:
+                {
+                    if (warm_caches)
+                        (void)memory_access_time_range(tvec->dst.nr, VECTOR_LENGTH, true);
+
+                    do_vector_store(tvec->dst.nr, vector_register_get(tvec->src1.nr));
+                    break;
+                }
+                default:
+                    break;
+            }
+
+            go_to_next_instruction();
+            break;
+        }
+        case TOKEN_ARYTHMETIC:
+        {
+            taryth = &token->token_arythmetic;
+            do_arythmetic(taryth->type,
+                          functional_get_reg(&taryth->dst, &tmp0),
+                          functional_get_reg(&taryth->src1, &tmp1),
+                          functional_get_reg(&taryth->src2, &tmp2));
+            go_to_next_instruction();
+            break;
+        }
+        case TOKEN_CMP:
+        {
+            do_cmp(functional_get_reg(&token->token_cmp.src1, &tmp1),
+                   functional_get_reg(&token->token_cmp.src2, &tmp2));
+            go_to_next_instruction();
+            break;
+        }
+        case TOKEN_JUMP:
+        {
+            do_jump(token->token_jump.type, token->token_jump.line);
+            break;
+        }
+        case TOKEN_MOVE:
+        {
+            tmove = &token->token_move;
+            if (warm_caches)
+            {
+                if (tmove->src.type == VAR_MEMORY)
+                    (void)memory_access_time(tmove->src.nr, false);
+                if (tmove->dst.type == VAR_MEMORY)
+                    (void)memory_access_time(tmove->dst.nr, true);
+            }
+
+            if (tmove->dst.type == VAR_MEMORY)
+                copy_data_to_memory(tmove->dst.nr, &tmove->src);
+            else
+                copy_data_to_reg(tmove->dst.nr, &tmove->src);
+
+            go_to_next_instruction();
+            break;
+        }
+        default:
+        {
+            LOG("Unsupported token type\n");
+            go_to_next_instruction();
+            break;
+        }
+    }
+}
+
+uint64_t functional_run(Token **program, size_t num_instr, uint64_t max_instr, bool warm_caches)
+{
+    uint64_t executed = 0;
+
+    TRACE();
+
+    while (board.ctx->pc < num_instr && executed < max_instr)
+    {
+        functional_step(program[board.ctx->pc], warm_caches);
+        ++executed;
+    }
+
+    return executed;
+}
+
+uint64_t functional_run_bbv(Token **program, size_t num_instr, uint64_t max_instr,
+                            const uint32_t *pc_to_block, uint64_t *block_count)
+{
+    uint64_t executed = 0;
+
+    TRACE();
+
+    while (board.ctx->pc < num_instr && executed < max_instr)
+    {
+        ++block_count[pc_to_block[board.ctx->pc]];
+        functional_step(program[board.ctx->pc], false);
+        ++executed;
+    }
+
+    return executed;
+}
+
+/*
+    Resolve operand of mov to pointer on register value or immediate.
+    Memory operand is resolved at execution, so translation does not allocate RAM pages
+
+    PARAMS
+    @IN var - pointer to variable
+    @IN imm - place for immediate value of this operand
+
+    RETURN
+    Pointer to operand value
+*/
+static reg_t *functional_resolve(const Variable *var, reg_t *imm);
+
+/*
+    Resolve operand of arythmetic or cmp to pointer on register value, see functional_get_reg
+
+    PARAMS
+    @IN var - pointer to variable
+    @IN imm - place for value of out of range operand
+
+    RETURN
+    Pointer to operand value
+*/
+static reg_t *functional_resolve_reg(const Variable *var, reg_t *imm);
+
+static reg_t *functional_resolve(const Variable *var, reg_t *imm)
+{
+    switch (var->type)
+    {
+        case VAR_REGISTER:
+        {
+            if (var->nr < REGISTERS_NUM)
+                return &board.ctx->registers.regs[var->nr].val;
+            break;
+        }
+        case VAR_VALUE:
+        {
+            *imm = var->val;
+            return imm;
+        }
+        default:
+            break;
+    }
+
+    *imm = 0;
+    return imm;
+}
+
+static reg_t *functional_resolve_reg(const Variable *var, reg_t *imm)
+{
+    if (var->nr < REGISTERS_NUM)
+        return &board.ctx->registers.regs[var->nr].val;
+
+    *imm = 0;
+    return imm;
+}
+
+Functional_program *functional_translate(Token **program, size_t num_instr)
+{
+    Functional_program *fp;
+    Functional_op *op;
+    const Token *token;
+    size_t i;
+
+    static const functional_op_t aryth_kind[] = {
+        [OP_ADD] = FOP_ADD,
+        [OP_SUB] = FOP_SUB,
+        [OP_MUL] = FOP_MUL,
+        [OP_DIV] = FOP_DIV,
+        [OP_MOD] = FOP_MOD
+    };
+
+    static const functional_op_t jump_kind[] = {
+        [JUMP_EQ] = FOP_JEQ,
+        [JUMP_NEQ] = FOP_JNEQ,
+        [JUMP_LT] = FOP_JLT,
+        [JUMP_LEQ] = FOP_JLEQ,
+        [JUMP_GT] = FOP_JGT,
+        [JUMP_GEQ] = FOP_JGEQ
+    };
+
+    TRACE();
+
+    fp = (Functional_program *)calloc(1, sizeof(Functional_program));
+    if (fp == NULL)
+        ERROR("malloc error\n", NULL);
+
+    fp->ops = (Functional_op *)calloc(num_instr + 1, sizeof(Functional_op));
+    if (fp->ops == NULL)
+    {
+        FREE(fp);
+        ERROR("malloc error\n", NULL);
+    }
+
+    for (i = 0; i < num_instr; ++i)
+    {
+        token = program[i];
+        op = &fp->ops[i];
+        op->kind = FOP_NOP;
+
+        switch (token->type)
+        {
+            case TOKEN_ARYTHMETIC:
+            {
+                if (token->token_arythmetic.type == OP_NONE || token->token_arythmetic.type > OP_MOD)
+                    break;
+
+                op->kind = aryth_kind[token->token_arythmetic.type];
+                op->dst = functional_resolve_reg(&token->token_arythmetic.dst, &op->imm[0]);
+                op->src1 = functional_resolve_reg(&token->token_arythmetic.src1, &op->imm[1]);
+                op->src2 = functional_resolve_reg(&token->token_arythmetic.src2, &op->imm[2]);
+                break;
+            }
+            case TOKEN_CMP:
+            {
+                op->kind = FOP_CMP;
+                op->src1 = functional_resolve_reg(&token->token_cmp.src1, &op->imm[1]);
+                op->src2 = functional_resolve_reg(&token->token_cmp.src2, &op->imm[2]);
+                break;
+            }
+            case TOKEN_JUMP:
+            {
+                if (token->token_jump.type == JUMP_NONE || token->token_jump.type > JUMP_GEQ)
+                    break;
+
+                op->kind = jump_kind[token->token_jump.type];
+                op->target = token->token_jump.line;
+                break;
+            }
+            case TOKEN_VECTOR:
+            {
+                op->vdst = vector_register_get(token->token_vector.dst.nr);
+                op->vsrc1 = vector_register_get(token->token_vector.src1.nr);
+                op->vsrc2 = vector_register_get(token->token_vector.src2.nr);
+                op->dst_addr = token->token_vector.dst.nr;
+                op->src_addr = token->token_vector.src1.nr;
+
+                /* parser checked operand types, register numbers are checked here */
+                if (token->token_vector.type == VOP_ADD && op->vdst != NULL && op->vsrc1 != NULL && op->vsrc2 != NULL)
+                    op->kind = FOP_VADD;
+                else if (token->token_vector.type == VOP_MUL && op->vdst != NULL && op->vsrc1 != NULL && op->vsrc2 != NULL)
+                    op->kind = FOP_VMUL;
+                else if (token->token_vector.type == VOP_LOAD && op->vdst != NULL)
+                    op->kind = FOP_VLD;
+                else if (token->token_vector.type == VOP_STORE && op->vsrc1 != NULL)
+                    op->kind = FOP_VST;
+                break;
+            }
+            case TOKEN_MOVE:
+            {
+                op->dst_mem = token->token_move.dst.type == VAR_MEMORY;
+                op->src_mem = token->token_move.src.type == VAR_MEMORY;
+                op->dst = op->dst_mem ? NULL : functional_resolve(&token->token_move.dst, &op->imm[0]);
+                op->src1 = op->src_mem ? NULL : functional_resolve(&token->token_move.src, &op->imm[1]);
+                op->dst_addr = token->token_move.dst.nr;
+                op->src_addr = token->token_move.src.nr;
+                op->kind = op->dst_mem || op->src_mem ? FOP_MOV_MEM : FOP_MOV;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    fp->num_ops = num_instr;
+    return fp;
+}
+
+void functional_program_destroy(Functional_program *fp)
+{
+    TRACE();
+
+    if (fp == NULL)
+        return;
+
+    FREE(fp->ops);
+    FREE(fp);
+}
+
+/* computed goto is GNU C */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+#define FUNCTIONAL_DISPATCH() \
+    do { \
+        if (pc >= num_ops || executed >= max_instr) \
+            goto end; \
+        ++executed; \
+        op = &ops[pc]; \
+        goto *op->label; \
+    } while (0)
+
+#define FUNCTIONAL_ARYTHMETIC(OPERATOR) \
+    do { \
+        *op->dst = *op->src1 OPERATOR *op->src2; \
+        ++pc; \
+        FUNCTIONAL_DISPATCH(); \
+    } while (0)
+
+/* x / 0 and x % 0 give 0 like in tomasulo */
+#define FUNCTIONAL_DIVIDE(OPERATOR) \
+    do { \
+        *op->dst = *op->src2 == 0 ? 0 : *op->src1 OPERATOR *op->src2; \
+        ++pc; \
+        FUNCTIONAL_DISPATCH(); \
+    } while (0)
+
+/* whole vector at once, host SIMD */
+#define FUNCTIONAL_VECTOR(OPERATOR) \
+    do { \
+        op->vdst->val = op->vsrc1->val OPERATOR op->vsrc2->val; \
+        ++pc; \
+        FUNCTIONAL_DISPATCH(); \
+    } while (0)
+
+#define FUNCTIONAL_JUMP(COND) \
+    do { \
+        pc = (COND) ? op->target : pc + 1; \
+        FUNCTIONAL_DISPATCH(); \
+    } while (0)
+
+uint64_t functional_exec(Functional_program *fp, uint64_t max_instr, bool warm_caches)
+{
+    static const void *const labels[FOP_KINDS] = {
+        [FOP_MOV] = &&do_mov,
+        [FOP_MOV_MEM] = &&do_mov_mem,
+        [FOP_ADD] = &&do_add,
+        [FOP_SUB] = &&do_sub,
+        [FOP_MUL] = &&do_mul,
+        [FOP_DIV] = &&do_div,
+        [FOP_MOD] = &&do_mod,
+        [FOP_CMP] = &&do_cmp,
+        [FOP_JEQ] = &&do_jeq,
+        [FOP_JNEQ] = &&do_jneq,
+        [FOP_JLT] = &&do_jlt,
+        [FOP_JLEQ] = &&do_jleq,
+        [FOP_JGT] = &&do_jgt,
+        [FOP_JGEQ] = &&do_jgeq,
+        [FOP_VADD] = &&do_vadd,
+        [FOP_VMUL] = &&do_vmul,
+        [FOP_VLD] = &&do_vld,
+        [FOP_VST] = &&do_vst,
+        [FOP_NOP] = &&do_nop
+    };
+
+    Functional_op *const ops = fp->ops;
+    const program_counter_t num_ops = fp->num_ops;
+    program_counter_t pc = board.ctx->pc;
+    compare_flag_t cf = board.ctx->cf;
+    uint64_t executed = 0;
+    Functional_op *op;
+    size_t i;
+
+    TRACE();
+
+    /* resolved memory movs skip cache warming, so labels depend on it */
+    if (!fp->threaded || fp->warm_caches != warm_caches)
+    {
+        for (i = 0; i < fp->num_ops; ++i)
+            ops[i].label = labels[ops[i].kind];
+
+        fp->threaded = true;
+        fp->warm_caches = warm_caches;
+    }
+
+    FUNCTIONAL_DISPATCH();
+
+do_mov_mem:
+    if (warm_caches)
+    {
+        if (op->src_mem)
+            (void)memory_access_time(op->src_addr, false);
+        if (op->dst_mem)
+            (void)memory_access_time(op->dst_addr, true);
+    }
+
+    /*
+        functional run is single core, RAM has no store buffer.
+        RAM word is resolved at first access, read of never written page does not allocate it
+    */
+    if (op->src_mem && op->src1 == NULL)
+        op->src1 = ram_find_word(board.ram, op->src_addr);
+    if (op->dst_mem && op->dst == NULL)
+        op->dst = ram_get_word(board.ram, op->dst_addr);
+
+    if (op->src1 == NULL)
+    {
+        *op->dst = 0;
+        ++pc;
+        FUNCTIONAL_DISPATCH();
+    }
+
+    /* both words are resolved, without cache warming it is plain mov from now */
+    if (!warm_caches)
+        op->label = &&do_mov;
+
+    goto do_mov;
+
+do_mov:
+    *op->dst = *op->src1;
+    ++pc;
+    FUNCTIONAL_DISPATCH();
+
+do_add:
+    FUNCTIONAL_ARYTHMETIC(+);
+do_sub:
+    FUNCTIONAL_ARYTHMETIC(-);
+do_mul:
+    FUNCTIONAL_ARYTHMETIC(*);
+do_div:
+    FUNCTIONAL_DIVIDE(/);
+do_mod:
+    FUNCTIONAL_DIVIDE(%);
+
+do_cmp:
+    cf = *op->src1 == *op->src2 ? 0 : *op->src1 < *op->src2 ? -1 : 1;
+    ++pc;
+    FUNCTIONAL_DISPATCH();
+
+do_jeq:
+    FUNCTIONAL_JUMP(cf == 0);
+do_jneq:
+    FUNCTIONAL_JUMP(cf != 0);
+do_jlt:
+    FUNCTIONAL_JUMP(cf == -1);
+do_jleq:
+    FUNCTIONAL_JUMP(cf <= 0);
+do_jgt:
+    FUNCTIONAL_JUMP(cf == 1);
+do_jgeq:
+    FUNCTIONAL_JUMP(cf >= 0);
+
+do_vadd:
+    FUNCTIONAL_VECTOR(+);
+do_vmul:
+    FUNCTIONAL_VECTOR(*);
+
+do_vld:
+    if (warm_caches)
+        (void)memory_access_time_range(op->src_addr, VECTOR_LENGTH, false);
+
+    do_vector_load(op->vdst, op->src_addr);
+    ++pc;
+    FUNCTIONAL_DISPATCH();
+
+do_vst:
+    if (warm_caches)
+        (void)memory_access_time_range(op->dst_addr, VECTOR_LENGTH, true);
+
+    do_vector_store(op->dst_addr, op->vsrc1);
+    ++pc;
+    FUNCTIONAL_DISPATCH();
+
+do_nop:
+    ++pc;
+    FUNCTIONAL_DISPATCH();
+
+end:
+    board.ctx->pc = pc;
+    board.ctx->cf = cf;
+
+    return executed;
+}
+
+#undef FUNCTIONAL_DISPATCH
+#undef FUNCTIONAL_ARYTHMETIC
+#undef FUNCTIONAL_JUMP
+#undef FUNCTIONAL_VECTOR
+
+#pragma GCC diagnostic pop
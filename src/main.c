@@ -5,14 +5,31 @@
 #include <log.h>
 #include <common.h>
 #include <stdlib.h>
+#include <string.h>
 #include <tomasulo.h>
+#include <profile.h>
+#include <unistd.h>
+#include <server.h>
+#include <sim_log.h>
 
 ___before_main___(0) void init(void);
 ___after_main___(0) void deinit(void);
 
+/*
+	Print usage of simulator on stderr
+
+	PARAMS
+	@IN name - name of executable
+
+	RETURN
+	This is a void function
+*/
+static void usage(const char *name);
+
 ___before_main___(0) void init(void)
 {
 	(void)log_init(stdout, NO_LOG_TO_FILE);
+	SIM_LOG_INIT();
 }
 
 ___after_main___(0) void deinit(void)
@@ -20,24 +37,212 @@ ___after_main___(0) void deinit(void)
 	log_deinit();
 }
 
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-f [-r]] [-F instructions] [-i interval [-k phases]] [-q] [-A] [-s stats.csv] [-t trace.json] [-j threads] [-Q quantum] [-S rr|icount] file [file ...]\n"
+			"       %s -D socket [-w workers]\n", name, name);
+}
+
 int main(int argc, char **argv)
 {
-	size_t size;
-	Token **program;
+	size_t *size;
+	Token ***program;
+	size_t num_programs;
 	size_t i;
+	size_t j;
+	int opt;
+	int ret;
+	bool smt = false;
+	const char *socket_path = NULL;
+	size_t workers = 4;
+	Tomasulo_options options = {
+		.stats_csv = NULL,
+		.trace_json = NULL,
+		.headless = false,
+		.arch_dump = false,
+		.functional = false,
+		.functional_switch = false,
+		.fast_forward = 0,
+		.sample_interval = 0,
+		.sample_clusters = 10,
+		.threads = 0,
+		.quantum = 1,
+		.smt_policy = SMT_FETCH_ROUND_ROBIN
+	};
+
+	while ((opt = getopt(argc, argv, "AD:fF:i:j:k:qQ:rs:S:t:w:")) != -1)
+	{
+		switch (opt)
+		{
+			case 'r':
+			{
+				options.functional_switch = true;
+				break;
+			}
+			case 'i':
+			{
+				options.sample_interval = strtoull(optarg, NULL, 10);
+				break;
+			}
+			case 'j':
+			{
+				options.threads = (size_t)strtoul(optarg, NULL, 10);
+				break;
+			}
+			case 'Q':
+			{
+				options.quantum = (uint32_t)strtoul(optarg, NULL, 10);
+				break;
+			}
+			case 'D':
+			{
+				socket_path = optarg;
+				break;
+			}
+			case 'w':
+			{
+				workers = (size_t)strtoul(optarg, NULL, 10);
+				break;
+			}
+			case 'S':
+			{
+				smt = true;
+				if (strcmp(optarg, "rr") == 0)
+					options.smt_policy = SMT_FETCH_ROUND_ROBIN;
+				else if (strcmp(optarg, "icount") == 0)
+					options.smt_policy = SMT_FETCH_ICOUNT;
+				else
+				{
+					fprintf(stderr, "Unknown SMT fetch policy %s\n", optarg);
+					usage(argv[0]);
+					return 1;
+				}
+				break;
+			}
+			case 'k':
+			{
+				options.sample_clusters = (uint32_t)strtoul(optarg, NULL, 10);
+				break;
+			}
+			case 'f':
+			{
+				options.functional = true;
+				break;
+			}
+			case 'F':
+			{
+				options.fast_forward = strtoull(optarg, NULL, 10);
+				break;
+			}
+			case 'q':
+			{
+				options.headless = true;
+				break;
+			}
+			case 'A':
+			{
+				options.arch_dump = true;
+				break;
+			}
+			case 's':
+			{
+				options.stats_csv = optarg;
+				break;
+			}
+			case 't':
+			{
+				options.trace_json = optarg;
+				break;
+			}
+			default:
+			{
+				usage(argv[0]);
+				return 1;
+			}
+		}
+	}
+
+	if (socket_path != NULL)
+		return server_run(socket_path, workers);
+
+	/* sampled simulation places its windows from the first instruction */
+	if (options.fast_forward > 0 && options.sample_interval > 0)
+	{
+		fprintf(stderr, "-F cannot be combined with -i\n");
+		usage(argv[0]);
+		return 1;
+	}
+
+	/* sampled simulation executes most of program functionally, it has no final state of tomasulo */
+	if (options.arch_dump && options.sample_interval > 0)
+	{
+		fprintf(stderr, "-A cannot be combined with -i\n");
+		usage(argv[0]);
+		return 1;
+	}
 
-	if (argc < 2)
+	if (optind >= argc)
 	{
 		fprintf(stderr, "Need path to file\n");
 		return 1;
 	}
 
-	program = parse(argv[1], &size);
-	(void)tomasulo(program, size);
+	/* each file is program of one core (or of one thread in SMT) */
+	num_programs = (size_t)(argc - optind);
+
+	/* modes of one program do not exist for many cores / threads, do not ignore them silently */
+	if (num_programs > 1 && (options.functional || options.fast_forward > 0 || options.sample_interval > 0))
+	{
+		fprintf(stderr, "-f, -F and -i need single program\n");
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (num_programs > 1 && !smt && (options.stats_csv != NULL || options.trace_json != NULL || options.arch_dump))
+	{
+		fprintf(stderr, "-s, -t and -A are not supported in multi-core mode\n");
+		usage(argv[0]);
+		return 1;
+	}
+	program = (Token ***)calloc(num_programs, sizeof(Token **));
+	size = (size_t *)calloc(num_programs, sizeof(size_t));
+	if (program == NULL || size == NULL)
+		FATAL("calloc error\n");
 
-	for (i = 0; i < size; ++i)
-		token_destroy(program[i]);
+	PROFILE_BEGIN(PROFILE_PARSE);
+	for (i = 0; i < num_programs; ++i)
+		program[i] = parse(argv[optind + (int)i], &size[i]);
+	PROFILE_END(PROFILE_PARSE);
+
+	/* invalid program is not simulated, it would run with wrong results */
+	ret = 0;
+	for (i = 0; i < num_programs; ++i)
+		if (program[i] == NULL)
+		{
+			fprintf(stderr, "Cannot parse %s\n", argv[optind + (int)i]);
+			ret = 1;
+		}
+
+	if (ret == 0)
+	{
+		if (num_programs == 1)
+			ret = tomasulo(program[0], size[0], &options);
+		else if (smt)
+			ret = tomasulo_smt(program, size, num_programs, &options);
+		else
+			ret = tomasulo_multicore(program, size, num_programs, &options);
+	}
+	PROFILE_REPORT();
+
+	for (i = 0; i < num_programs; ++i)
+	{
+		for (j = 0; j < size[i]; ++j)
+			token_destroy(program[i][j]);
+
+		FREE(program[i]);
+	}
 
 	FREE(program);
-	return 0;
+	FREE(size);
+	return ret;
 }
@@ -1,6 +1,7 @@
 #include <parser.h>
 #include <tokens.h>
 #include <asm.h>
+#include <arch.h>
 #include <filebuffer.h>
 #include <darray.h>
 #include <fcntl.h>
@@ -8,6 +9,7 @@
 #include <stdbool.h>
 #include <string.h>
 #include <log.h>
+#include <common.h>
 #include <inttypes.h>
 #include <stdlib.h>
 
@@ -26,6 +28,7 @@ static ___inline___ bool is_mnemonic_token_move(const char *op, size_t n);
 static ___inline___ bool is_mnemonic_token_jump(const char *op, size_t n);
 static ___inline___ bool is_mnemonic_token_cmp(const char *op, size_t n);
 static ___inline___ bool is_mnemonic_token_arythmetic(const char *op, size_t n);
+static ___inline___ bool is_mnemonic_token_vector(const char *op, size_t n);
 
 /*
     Get arythmetic token type from string
@@ -51,6 +54,44 @@ static ___inline___ arythemtic_t token_arythmetic_type_from_str(const char *str,
 */
 static ___inline___ jump_t token_jump_type_from_str(const char *str, size_t n);
 
+/*
+    Get vector token type from string
+
+    PARAMS
+    @IN str - pointer to string
+    @IN n - number of bytes to compare
+
+    RETURN
+    Type
+*/
+static ___inline___ vector_op_t token_vector_type_from_str(const char *str, size_t n);
+
+/*
+    Check operands of vector token, vector unit reads V registers (V0 .. VREGISTERS_NUM - 1)
+    and contiguous memory only (whole range M .. M + VECTOR_LENGTH - 1 is addressable)
+
+    PARAMS
+    @IN token - pointer to Token_vector
+
+    RETURN
+    true iff operands are valid
+    false iff not
+*/
+static ___inline___ bool token_vector_is_valid(const Token_vector *token);
+
+/*
+    Check operands of token, see program_is_valid
+
+    PARAMS
+    @IN token - pointer to generic Token
+    @IN size - number of instructions in program
+
+    RETURN
+    true iff token is valid
+    false iff not
+*/
+static ___inline___ bool token_is_valid(const Token *token, size_t size);
+
 /*
     Create variable from string
 
@@ -61,6 +102,55 @@ static ___inline___ jump_t token_jump_type_from_str(const char *str, size_t n);
     RETURN
     Bytes from str used to create variable
 */
+static ___inline___ bool token_is_valid(const Token *token, size_t size)
+{
+    const Token_move *tmove = &token->token_move;
+    const Token_arythmetic *taryth = &token->token_arythmetic;
+
+#define REG_OK(VAR) ((VAR).type != VAR_REGISTER || (VAR).nr < REGISTERS_NUM)
+#define REGFILE_OK(VAR) ((VAR).type != VAR_NONE && (VAR).type != VAR_VREGISTER && (VAR).nr < REGISTERS_NUM)
+
+    switch (token->type)
+    {
+        case TOKEN_MOVE:
+            return (tmove->dst.type == VAR_REGISTER || tmove->dst.type == VAR_MEMORY) &&
+                   (tmove->src.type == VAR_REGISTER || tmove->src.type == VAR_MEMORY || tmove->src.type == VAR_VALUE) &&
+                   REG_OK(tmove->dst) && REG_OK(tmove->src);
+        case TOKEN_ARYTHMETIC:
+            return REGFILE_OK(taryth->dst) && REGFILE_OK(taryth->src1) && REGFILE_OK(taryth->src2);
+        case TOKEN_CMP:
+            return REGFILE_OK(token->token_cmp.src1) && REGFILE_OK(token->token_cmp.src2);
+        case TOKEN_JUMP:
+            return token->token_jump.line <= size;
+        case TOKEN_VECTOR:
+            return token_vector_is_valid(&token->token_vector);
+        default:
+            return false;
+    }
+
+#undef REG_OK
+#undef REGFILE_OK
+}
+
+bool program_is_valid(Token * const *program, size_t size)
+{
+    size_t i;
+
+    TRACE();
+
+    if (program == NULL)
+        return false;
+
+    for (i = 0; i < size; ++i)
+        if (program[i] == NULL || !token_is_valid(program[i], size))
+        {
+            LOG("Instruction %zu is invalid\n", i);
+            return false;
+        }
+
+    return true;
+}
+
 static ___inline___ size_t variable_create_from_str(const char *str, Variable *var);
 
 /*
@@ -94,11 +184,16 @@ const Mnemonics mnemonics = {
     .jgt  = "jgt",
     .jge = "jge",
     .jlt  = "jlt",
-    .jle = "jle" 
+    .jle = "jle",
+    .vadd = "vadd",
+    .vmul = "vmul",
+    .vld = "vld",
+    .vst = "vst"
 };
 
 const char memory_c         = 'M';
 const char register_c       = 'R';
+const char vector_register_c = 'V';
 const char decimal_mode_c   = '#';
 const char octal_mode_c     = '&';
 const char binary_mode_c    = '%';
@@ -123,6 +218,11 @@ static ___inline___ bool is_mnemonic_token_arythmetic(const char *op, size_t n)
     return n > 0 && token_arythmetic_type_from_str(op, n) != OP_NONE;
 }
 
+static ___inline___ bool is_mnemonic_token_vector(const char *op, size_t n)
+{
+    return n > 0 && token_vector_type_from_str(op, n) != VOP_NONE;
+}
+
 static ___inline___ arythemtic_t token_arythmetic_type_from_str(const char *str, size_t n)
 {
     if (n == 0)
@@ -172,6 +272,48 @@ static ___inline___ jump_t token_jump_type_from_str(const char *str, size_t n)
     return JUMP_NONE;
 }
 
+static ___inline___ vector_op_t token_vector_type_from_str(const char *str, size_t n)
+{
+    if (n == 0)
+        return VOP_NONE;
+
+    if (strncmp(str, mnemonics.vadd, n) == 0)
+        return VOP_ADD;
+
+    if (strncmp(str, mnemonics.vmul, n) == 0)
+        return VOP_MUL;
+
+    if (strncmp(str, mnemonics.vld, n) == 0)
+        return VOP_LOAD;
+
+    if (strncmp(str, mnemonics.vst, n) == 0)
+        return VOP_STORE;
+
+    return VOP_NONE;
+}
+
+static ___inline___ bool token_vector_is_valid(const Token_vector *token)
+{
+#define VREG_OK(VAR) ((VAR).type == VAR_VREGISTER && (VAR).nr < VREGISTERS_NUM)
+#define VMEM_OK(VAR) ((VAR).type == VAR_MEMORY && (VAR).nr <= UINT32_MAX - (VECTOR_LENGTH - 1))
+
+    switch (token->type)
+    {
+        case VOP_ADD:
+        case VOP_MUL:
+            return VREG_OK(token->dst) && VREG_OK(token->src1) && VREG_OK(token->src2);
+        case VOP_LOAD:
+            return VREG_OK(token->dst) && VMEM_OK(token->src1);
+        case VOP_STORE:
+            return VMEM_OK(token->dst) && VREG_OK(token->src1);
+        default:
+            return false;
+    }
+
+#undef VREG_OK
+#undef VMEM_OK
+}
+
 static ___inline___ size_t variable_create_from_str(const char *str, Variable *var)
 {
     char *ptr;
@@ -189,6 +331,8 @@ static ___inline___ size_t variable_create_from_str(const char *str, Variable *v
         var->type = VAR_MEMORY;
     else if (toupper(str[i]) == register_c)
         var->type = VAR_REGISTER;
+    else if (toupper(str[i]) == vector_register_c)
+        var->type = VAR_VREGISTER;
     else
     {
         if (str[i] == decimal_mode_c)
@@ -223,19 +367,32 @@ static ___inline___ size_t variable_create_from_str(const char *str, Variable *v
 Token **parse(const char *file, size_t *size)
 {
     File_buffer *fb;
+    Token **result;
+
+    TRACE();
+
+    fb = file_buffer_create_from_path(file, PROT_READ | PROT_WRITE, O_RDWR);
+    if (fb == NULL)
+        ERROR("file_buffer create error\n", NULL);
+
+    result = parse_buffer(file_buffer_get_buff(fb), (size_t)file_buffer_get_size(fb), size);
+    file_buffer_destroy(fb);
 
+    return result;
+}
+
+Token **parse_buffer(const char *buf, size_t buf_size, size_t *size)
+{
     /* temporary tokens */
     Token_arythmetic token_arythmetic;
     Token_cmp token_cmp;
     Token_jump token_jump;
     Token_move token_move;
+    Token_vector token_vector;
 
     Darray *darray; /* darray with tokens */
     Token *token = NULL; /* generic token */
 
-    const char *buf; /* buffer from file_buffer */
-    size_t buf_size; /* size of file buffer buf */
-
     size_t i;
     size_t j;
     size_t k;
@@ -247,19 +404,9 @@ Token **parse(const char *file, size_t *size)
 
     TRACE();
 
-    fb = file_buffer_create_from_path(file, PROT_READ | PROT_WRITE, O_RDWR);
-    if (fb == NULL)
-        ERROR("file_buffer create error\n", NULL);
-
     darray = darray_create(DARRAY_UNSORTED, 0, sizeof(Token *), NULL);
     if (darray == NULL)
-    {
-        file_buffer_destroy(fb);
         ERROR("darray create error\n", NULL);
-    }
-
-    buf = file_buffer_get_buff(fb);
-    buf_size = (size_t)file_buffer_get_size(fb);
 
     LOG("Parsing asm into tokens\n");
     i = 0;
@@ -319,6 +466,19 @@ Token **parse(const char *file, size_t *size)
 
             token = token_create(TOKEN_JUMP, (void *)&token_jump);
         }
+        else if (is_mnemonic_token_vector(&buf[j], k - j))
+        {
+            LOG("Vector token\n");
+
+            (void)memset(&token_vector, 0, sizeof(token_vector));
+            token_vector.type = token_vector_type_from_str(&buf[j], k - j);
+            i += variable_create_from_str(&buf[i], &token_vector.dst);
+            i += variable_create_from_str(&buf[i], &token_vector.src1);
+            if (token_vector.type == VOP_ADD || token_vector.type == VOP_MUL)
+                i += variable_create_from_str(&buf[i], &token_vector.src2);
+
+            token = token_create(TOKEN_VECTOR, (void *)&token_vector);
+        }
         else if (is_mnemonic_token_move(&buf[j], k - j))
         {
             LOG("Move token\n");
@@ -336,8 +496,7 @@ Token **parse(const char *file, size_t *size)
             token = NULL;
         }
     }
-    file_buffer_destroy(fb);
-    
+
     tokens = (size_t)darray_get_num_entries(darray);
     LOG("Copy tokens to array\n");
     result = (Token **)malloc(sizeof(Token *) * tokens);
@@ -353,6 +512,16 @@ Token **parse(const char *file, size_t *size)
 
     darray_destroy(darray);
 
+    /* simulator indexes register files and program by operands */
+    if (!program_is_valid(result, tokens))
+    {
+        for (i = 0; i < tokens; ++i)
+            token_destroy(result[i]);
+
+        FREE(result);
+        ERROR("Invalid operands or jump target in program\n", NULL);
+    }
+
     *size = tokens;
     return result;
 }
\ No newline at end of file
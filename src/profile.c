@@ -0,0 +1,107 @@
+#include <profile.h>
+
+#ifdef PROFILE
+
+#include <log.h>
+#include <compiler.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <time.h>
+#include <pthread.h>
+
+typedef struct Profile_phase
+{
+    uint64_t ns;
+    uint64_t calls;
+} Profile_phase;
+
+static Profile_phase profile_phases[PROFILE_PHASES];
+static pthread_mutex_t profile_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* accumulators of this host thread, merged by profile_merge */
+static __thread Profile_phase profile_local[PROFILE_PHASES];
+
+/*
+    Get const char* from type
+*/
+static ___inline___ const char *profile_phase_get_str(profile_phase_t phase);
+
+static ___inline___ const char *profile_phase_get_str(profile_phase_t phase)
+{
+    switch (phase)
+    {
+        case PROFILE_PARSE:
+            return "parse";
+        case PROFILE_FETCH:
+            return "fetch";
+        case PROFILE_EXECUTE_LOAD:
+            return "execute_load";
+        case PROFILE_EXECUTE_ARYTHMETIC:
+            return "execute_arythmetic";
+        case PROFILE_EXECUTE_WRITE:
+            return "execute_write";
+        case PROFILE_PRINT:
+            return "tomasulo_print";
+        default:
+            return NULL;
+    }
+
+    return NULL;
+}
+
+uint64_t profile_now(void)
+{
+    struct timespec ts;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void profile_add(profile_phase_t phase, uint64_t ns)
+{
+    profile_local[phase].ns += ns;
+    ++profile_local[phase].calls;
+}
+
+void profile_merge(void)
+{
+    size_t i;
+
+    TRACE();
+
+    (void)pthread_mutex_lock(&profile_lock);
+    for (i = 0; i < PROFILE_PHASES; ++i)
+    {
+        profile_phases[i].ns += profile_local[i].ns;
+        profile_phases[i].calls += profile_local[i].calls;
+
+        profile_local[i].ns = 0;
+        profile_local[i].calls = 0;
+    }
+    (void)pthread_mutex_unlock(&profile_lock);
+}
+
+void profile_print(void)
+{
+    size_t i;
+    uint64_t total = 0;
+
+    TRACE();
+
+    profile_merge();
+
+    for (i = 0; i < PROFILE_PHASES; ++i)
+        total += profile_phases[i].ns;
+
+    printf("Host profile, %.6lf s in profiled phases\n", (double)total / 1e9);
+    printf("\t%-20s %12s %14s %10s %7s\n", "Phase", "Calls", "Time [ns]", "ns / call", "%");
+    for (i = 0; i < PROFILE_PHASES; ++i)
+        printf("\t%-20s %12" PRIu64 " %14" PRIu64 " %10.1lf %6.2lf%%\n",
+               profile_phase_get_str((profile_phase_t)i),
+               profile_phases[i].calls,
+               profile_phases[i].ns,
+               profile_phases[i].calls == 0 ? 0.0 : (double)profile_phases[i].ns / (double)profile_phases[i].calls,
+               total == 0 ? 0.0 : 100.0 * (double)profile_phases[i].ns / (double)total);
+}
+
+#endif
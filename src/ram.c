@@ -0,0 +1,318 @@
+#include <ram.h>
+#include <log.h>
+#include <compiler.h>
+#include <common.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <sim_log.h>
+
+#define ram_dir_index(addr)  ((size_t)((addr) >> (RAM_PAGE_BITS + RAM_LEAF_BITS + RAM_MID_BITS)))
+#define ram_mid_index(addr)  ((size_t)((addr) >> (RAM_PAGE_BITS + RAM_LEAF_BITS)) & (RAM_MID_SIZE - 1))
+#define ram_leaf_index(addr) ((size_t)((addr) >> RAM_PAGE_BITS) & (RAM_LEAF_SIZE - 1))
+#define ram_page_offset(addr) ((size_t)(addr) & (RAM_PAGE_SIZE - 1))
+
+/*
+    Get page with word, dont allocate
+
+    PARAMS
+    @IN ram - pointer to RAM
+    @IN addr - address of word
+
+    RETURN
+    NULL iff page has never been written
+    Pointer to page iff success
+*/
+static ___inline___ Ram_page *ram_get_page(const RAM *ram, uint32_t addr);
+
+/*
+    Find slot of address in store buffer
+
+    PARAMS
+    @IN sb - pointer to store buffer
+    @IN addr - address of word
+
+    RETURN
+    Pointer to slot with address or to free slot iff address is not buffered
+*/
+static ___inline___ Ram_store *ram_store_buffer_find(const Ram_store_buffer *sb, uint32_t addr);
+
+/*
+    Double size of store buffer
+
+    PARAMS
+    @IN sb - pointer to store buffer
+
+    RETURN
+    This is a void function
+*/
+static void ram_store_buffer_grow(Ram_store_buffer *sb);
+
+static ___inline___ Ram_page *ram_get_page(const RAM *ram, uint32_t addr)
+{
+    const Ram_mid *mid;
+    const Ram_leaf *leaf;
+
+    mid = ram->mid[ram_dir_index(addr)];
+    if (mid == NULL)
+        return NULL;
+
+    leaf = mid->leaf[ram_mid_index(addr)];
+    if (leaf == NULL)
+        return NULL;
+
+    return leaf->page[ram_leaf_index(addr)];
+}
+
+DWORD ram_read(const RAM *ram, uint32_t addr)
+{
+    const Ram_page *page;
+
+    page = ram_get_page(ram, addr);
+    if (page == NULL)
+        return 0;
+
+    return page->word[ram_page_offset(addr)];
+}
+
+DWORD *ram_get_word(RAM *ram, uint32_t addr)
+{
+    Ram_mid **mid;
+    Ram_leaf **leaf;
+    Ram_page **page;
+
+    mid = &ram->mid[ram_dir_index(addr)];
+    if (*mid == NULL)
+    {
+        *mid = (Ram_mid *)calloc(1, sizeof(Ram_mid));
+        if (*mid == NULL)
+            FATAL("calloc error\n");
+    }
+
+    leaf = &(*mid)->leaf[ram_mid_index(addr)];
+    if (*leaf == NULL)
+    {
+        *leaf = (Ram_leaf *)calloc(1, sizeof(Ram_leaf));
+        if (*leaf == NULL)
+            FATAL("calloc error\n");
+    }
+
+    page = &(*leaf)->page[ram_leaf_index(addr)];
+    if (*page == NULL)
+    {
+        LOG("Allocate page for M%" PRIu32 "\n", addr);
+        *page = (Ram_page *)calloc(1, sizeof(Ram_page));
+        if (*page == NULL)
+            FATAL("calloc error\n");
+
+        ++ram->num_pages;
+    }
+
+    return &(*page)->word[ram_page_offset(addr)];
+}
+
+DWORD *ram_find_word(RAM *ram, uint32_t addr)
+{
+    Ram_page *page;
+
+    page = ram_get_page(ram, addr);
+    if (page == NULL)
+        return NULL;
+
+    return &page->word[ram_page_offset(addr)];
+}
+
+void ram_write(RAM *ram, uint32_t addr, DWORD val)
+{
+    *ram_get_word(ram, addr) = val;
+}
+
+static ___inline___ Ram_store *ram_store_buffer_find(const Ram_store_buffer *sb, uint32_t addr)
+{
+    uint32_t hash;
+    size_t i;
+
+    hash = addr * 0x9E3779B1U;
+    hash ^= hash >> 16;
+
+    for (i = (size_t)hash & (sb->size - 1); sb->store[i].used && sb->store[i].addr != addr; i = (i + 1) & (sb->size - 1))
+        ;
+
+    return &sb->store[i];
+}
+
+static void ram_store_buffer_grow(Ram_store_buffer *sb)
+{
+    Ram_store *old = sb->store;
+    size_t old_size = sb->size;
+    size_t i;
+
+    TRACE();
+
+    sb->size <<= 1;
+    sb->store = (Ram_store *)calloc(sb->size, sizeof(Ram_store));
+    if (sb->store == NULL)
+        FATAL("calloc error\n");
+
+    for (i = 0; i < old_size; ++i)
+        if (old[i].used)
+            *ram_store_buffer_find(sb, old[i].addr) = old[i];
+
+    FREE(old);
+}
+
+Ram_store_buffer *ram_store_buffer_create(void)
+{
+    Ram_store_buffer *sb;
+
+    TRACE();
+
+    sb = (Ram_store_buffer *)calloc(1, sizeof(Ram_store_buffer));
+    if (sb == NULL)
+        ERROR("calloc error\n", NULL);
+
+    sb->size = RAM_PAGE_SIZE;
+    sb->store = (Ram_store *)calloc(sb->size, sizeof(Ram_store));
+    if (sb->store == NULL)
+    {
+        FREE(sb);
+        ERROR("calloc error\n", NULL);
+    }
+
+    return sb;
+}
+
+void ram_store_buffer_destroy(Ram_store_buffer *sb)
+{
+    TRACE();
+
+    if (sb == NULL)
+        return;
+
+    FREE(sb->store);
+    FREE(sb);
+}
+
+void ram_store_buffer_write(Ram_store_buffer *sb, uint32_t addr, DWORD val)
+{
+    Ram_store *store;
+
+    store = ram_store_buffer_find(sb, addr);
+    if (!store->used)
+    {
+        store->used = true;
+        store->addr = addr;
+        ++sb->num_stores;
+    }
+
+    store->val = val;
+
+    /* keep load factor <= 1/2 */
+    if (sb->num_stores << 1 > sb->size)
+        ram_store_buffer_grow(sb);
+}
+
+DWORD ram_store_buffer_read(const Ram_store_buffer *sb, const RAM *ram, uint32_t addr)
+{
+    const Ram_store *store;
+
+    if (sb->num_stores > 0)
+    {
+        store = ram_store_buffer_find(sb, addr);
+        if (store->used)
+            return store->val;
+    }
+
+    return ram_read(ram, addr);
+}
+
+void ram_store_buffer_commit(Ram_store_buffer *sb, RAM *ram)
+{
+    size_t i;
+
+    if (sb->num_stores == 0)
+        return;
+
+    for (i = 0; i < sb->size; ++i)
+        if (sb->store[i].used)
+        {
+            ram_write(ram, sb->store[i].addr, sb->store[i].val);
+            sb->store[i].used = false;
+        }
+
+    sb->committed += sb->num_stores;
+    sb->num_stores = 0;
+}
+
+void ram_reset(RAM *ram)
+{
+    size_t i;
+    size_t j;
+    size_t k;
+    Ram_mid *mid;
+    Ram_leaf *leaf;
+
+    TRACE();
+
+    for (i = 0; i < RAM_DIR_SIZE; ++i)
+    {
+        mid = ram->mid[i];
+        if (mid == NULL)
+            continue;
+
+        for (j = 0; j < RAM_MID_SIZE; ++j)
+        {
+            leaf = mid->leaf[j];
+            if (leaf == NULL)
+                continue;
+
+            for (k = 0; k < RAM_LEAF_SIZE; ++k)
+                FREE(leaf->page[k]);
+
+            FREE(mid->leaf[j]);
+        }
+
+        FREE(ram->mid[i]);
+    }
+
+    ram->num_pages = 0;
+}
+
+void ram_dump(const RAM *ram)
+{
+    size_t i;
+    size_t j;
+    size_t k;
+    size_t w;
+    const Ram_mid *mid;
+    const Ram_leaf *leaf;
+    const Ram_page *page;
+    size_t addr;
+
+    TRACE();
+
+    printf("RAM %zu pages touched, %zu words per page\n", ram->num_pages, RAM_PAGE_SIZE);
+    for (i = 0; i < RAM_DIR_SIZE; ++i)
+    {
+        mid = ram->mid[i];
+        if (mid == NULL)
+            continue;
+
+        for (j = 0; j < RAM_MID_SIZE; ++j)
+        {
+            leaf = mid->leaf[j];
+            if (leaf == NULL)
+                continue;
+
+            for (k = 0; k < RAM_LEAF_SIZE; ++k)
+            {
+                page = leaf->page[k];
+                if (page == NULL)
+                    continue;
+
+                addr = ((i * RAM_MID_SIZE + j) * RAM_LEAF_SIZE + k) * RAM_PAGE_SIZE;
+                for (w = 0; w < RAM_PAGE_SIZE; ++w)
+                    printf("MEM[ %zu ] = %ld\n", addr + w, page->word[w]);
+            }
+        }
+    }
+}
@@ -0,0 +1,661 @@
+#include <server.h>
+#include <libtomasulo.h>
+#include <parser.h>
+#include <tokens.h>
+#include <log.h>
+#include <compiler.h>
+#include <common.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sim_log.h>
+
+#define SERVER_LINE_SIZE 256
+
+/* parsed program in cache */
+typedef struct Server_program
+{
+    uint64_t hash;
+    char *text;
+    size_t len;
+
+    Token **program;
+    size_t num_instr;
+
+    struct Server_program *next; /* in bucket */
+} Server_program;
+
+/* client connection, freed when reader and all its jobs are done */
+typedef struct Server_connection
+{
+    int fd;
+    pthread_mutex_t lock; /* results from many workers */
+    size_t refs;
+} Server_connection;
+
+typedef struct Server_job
+{
+    Server_connection *conn;
+    uint64_t id;
+    uint64_t max_cycles;
+    uint64_t max_retired;
+
+    char *text; /* asm program */
+    size_t len;
+
+    struct Server_job *next;
+} Server_job;
+
+typedef struct Server
+{
+    int fd;
+
+    /* job queue, FIFO */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    Server_job *head;
+    Server_job *tail;
+
+    /* program cache */
+    pthread_mutex_t cache_lock;
+    Server_program *cache[SERVER_CACHE_BUCKETS];
+    size_t cache_entries;
+} Server;
+
+typedef struct Server_reader
+{
+    Server *server;
+    Server_connection *conn;
+} Server_reader;
+
+/*
+    FNV-1a hash of text
+
+    PARAMS
+    @IN text - text
+    @IN len - length of text
+
+    RETURN
+    Hash
+*/
+static ___inline___ uint64_t server_hash(const char *text, size_t len);
+
+/*
+    Find program in cache, cache_lock has to be held
+
+    PARAMS
+    @IN server - pointer to server
+    @IN bucket - bucket of program
+    @IN hash - hash of program text
+    @IN job - pointer to job with program text
+
+    RETURN
+    NULL iff program is not in cache
+    Pointer to program iff program is in cache
+*/
+static Server_program *server_cache_find(const Server *server, size_t bucket, uint64_t hash, const Server_job *job);
+
+/*
+    Get program from cache, parse and insert it iff needed
+
+    PARAMS
+    @IN server - pointer to server
+    @IN job - pointer to job
+    @OUT cached - true iff program was already in cache
+    @OUT owned - true iff program is not in cache and caller has to destroy it
+
+    RETURN
+    NULL iff failure
+    Pointer to program iff success
+*/
+static Server_program *server_get_program(Server *server, const Server_job *job, bool *cached, bool *owned);
+
+/*
+    Destroy program
+
+    PARAMS
+    @IN prog - pointer to program
+
+    RETURN
+    This is a void function
+*/
+static void server_program_destroy(Server_program *prog);
+
+/*
+    Find END which closes job. END is the last word of line (line ends with newline
+    or connection is closed), it can follow the last program line without newline
+
+    PARAMS
+    @IN line - line from client
+    @IN len - length of line
+
+    RETURN
+    -1 iff line does not close job
+    Length of program text before END iff line closes job
+*/
+static ssize_t server_find_end(const char *line, size_t len);
+
+/*
+    Send line to client, ignore closed connection
+
+    PARAMS
+    @IN conn - pointer to connection
+    @IN fmt - printf like format
+    @IN ... - arguments
+
+    RETURN
+    This is a void function
+*/
+static void server_send(Server_connection *conn, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/*
+    Release reference to connection, close it with the last one
+
+    PARAMS
+    @IN conn - pointer to connection
+
+    RETURN
+    This is a void function
+*/
+static void server_connection_release(Server_connection *conn);
+
+/*
+    Put job to queue / Take job from queue (wait for it)
+
+    PARAMS
+    @IN server - pointer to server
+    @IN job - pointer to job
+
+    RETURN
+    Pointer to job (pop)
+*/
+static void server_push_job(Server *server, Server_job *job);
+static Server_job *server_pop_job(Server *server);
+
+/*
+    Thread which reads jobs from connection
+
+    PARAMS
+    @IN arg - pointer to Server_reader
+
+    RETURN
+    NULL
+*/
+static void *server_reader_thread(void *arg);
+
+/*
+    Worker thread with own simulator
+
+    PARAMS
+    @IN arg - pointer to Server
+
+    RETURN
+    NULL
+*/
+static void *server_worker_thread(void *arg);
+
+static ___inline___ uint64_t server_hash(const char *text, size_t len)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    size_t i;
+
+    for (i = 0; i < len; ++i)
+    {
+        hash ^= (uint64_t)(unsigned char)text[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static void server_program_destroy(Server_program *prog)
+{
+    size_t i;
+
+    TRACE();
+
+    if (prog == NULL)
+        return;
+
+    for (i = 0; i < prog->num_instr; ++i)
+        token_destroy(prog->program[i]);
+
+    FREE(prog->program);
+    FREE(prog->text);
+    FREE(prog);
+}
+
+static Server_program *server_cache_find(const Server *server, size_t bucket, uint64_t hash, const Server_job *job)
+{
+    Server_program *prog;
+
+    for (prog = server->cache[bucket]; prog != NULL; prog = prog->next)
+        if (prog->hash == hash && prog->len == job->len && memcmp(prog->text, job->text, job->len) == 0)
+            return prog;
+
+    return NULL;
+}
+
+static Server_program *server_get_program(Server *server, const Server_job *job, bool *cached, bool *owned)
+{
+    Server_program *prog;
+    Server_program *cached_prog;
+    uint64_t hash;
+    size_t bucket;
+
+    TRACE();
+
+    hash = server_hash(job->text, job->len);
+    bucket = (size_t)(hash % SERVER_CACHE_BUCKETS);
+
+    *cached = false;
+    *owned = false;
+
+    (void)pthread_mutex_lock(&server->cache_lock);
+    prog = server_cache_find(server, bucket, hash, job);
+    (void)pthread_mutex_unlock(&server->cache_lock);
+
+    if (prog != NULL)
+    {
+        *cached = true;
+        return prog;
+    }
+
+    /* parse without lock, other worker can parse the same program in meantime */
+    prog = (Server_program *)calloc(1, sizeof(Server_program));
+    if (prog == NULL)
+        ERROR("calloc error\n", NULL);
+
+    prog->hash = hash;
+    prog->len = job->len;
+    prog->text = (char *)malloc(job->len + 1);
+    if (prog->text == NULL)
+    {
+        FREE(prog);
+        ERROR("malloc error\n", NULL);
+    }
+
+    (void)memcpy(prog->text, job->text, job->len + 1);
+    prog->program = parse_buffer(prog->text, prog->len, &prog->num_instr);
+    if (prog->program == NULL)
+    {
+        FREE(prog->text);
+        FREE(prog);
+        ERROR("parse error\n", NULL);
+    }
+
+    (void)pthread_mutex_lock(&server->cache_lock);
+    /* other worker could insert the same program while this one was parsing */
+    cached_prog = server_cache_find(server, bucket, hash, job);
+    if (cached_prog != NULL)
+    {
+        (void)pthread_mutex_unlock(&server->cache_lock);
+        server_program_destroy(prog);
+        *cached = true;
+        return cached_prog;
+    }
+
+    if (server->cache_entries < SERVER_CACHE_ENTRIES)
+    {
+        prog->next = server->cache[bucket];
+        server->cache[bucket] = prog;
+        ++server->cache_entries;
+    }
+    else
+        *owned = true;
+    (void)pthread_mutex_unlock(&server->cache_lock);
+
+    return prog;
+}
+
+static ssize_t server_find_end(const char *line, size_t len)
+{
+    while (len > 0 && isspace((unsigned char)line[len - 1]))
+        --len;
+
+    if (len < 3 || strncmp(line + len - 3, "END", 3) != 0)
+        return -1;
+
+    return (ssize_t)(len - 3);
+}
+
+static void server_send(Server_connection *conn, const char *fmt, ...)
+{
+    char line[SERVER_LINE_SIZE];
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+
+    if (len < 0)
+        return;
+
+    if ((size_t)len >= sizeof(line))
+        len = (int)sizeof(line) - 1;
+
+    /* client could go away, MSG_NOSIGNAL avoids SIGPIPE */
+    (void)pthread_mutex_lock(&conn->lock);
+    (void)send(conn->fd, line, (size_t)len, MSG_NOSIGNAL);
+    (void)pthread_mutex_unlock(&conn->lock);
+}
+
+static void server_connection_release(Server_connection *conn)
+{
+    size_t refs;
+
+    TRACE();
+
+    (void)pthread_mutex_lock(&conn->lock);
+    refs = --conn->refs;
+    (void)pthread_mutex_unlock(&conn->lock);
+
+    if (refs > 0)
+        return;
+
+    (void)close(conn->fd);
+    (void)pthread_mutex_destroy(&conn->lock);
+    FREE(conn);
+}
+
+static void server_push_job(Server *server, Server_job *job)
+{
+    TRACE();
+
+    job->next = NULL;
+
+    (void)pthread_mutex_lock(&server->lock);
+    if (server->tail == NULL)
+        server->head = job;
+    else
+        server->tail->next = job;
+
+    server->tail = job;
+    (void)pthread_cond_signal(&server->cond);
+    (void)pthread_mutex_unlock(&server->lock);
+}
+
+static Server_job *server_pop_job(Server *server)
+{
+    Server_job *job;
+
+    TRACE();
+
+    (void)pthread_mutex_lock(&server->lock);
+    while (server->head == NULL)
+        (void)pthread_cond_wait(&server->cond, &server->lock);
+
+    job = server->head;
+    server->head = job->next;
+    if (server->head == NULL)
+        server->tail = NULL;
+    (void)pthread_mutex_unlock(&server->lock);
+
+    return job;
+}
+
+static void *server_reader_thread(void *arg)
+{
+    Server_reader *reader = (Server_reader *)arg;
+    Server *server = reader->server;
+    Server_connection *conn = reader->conn;
+    Server_job *job = NULL;
+    FILE *in;
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t len;
+    ssize_t end;
+    const char *opt;
+    bool too_big = false;
+
+    TRACE();
+
+    FREE(reader);
+
+    in = fdopen(dup(conn->fd), "r");
+    if (in == NULL)
+    {
+        server_connection_release(conn);
+        return NULL;
+    }
+
+    while ((len = getline(&line, &line_size, in)) > 0)
+    {
+        if (job == NULL)
+        {
+            if (strncmp(line, "QUIT", 4) == 0)
+                break;
+
+            if (strncmp(line, "JOB ", 4) != 0)
+            {
+                server_send(conn, "FAIL - expected JOB\n");
+                continue;
+            }
+
+            job = (Server_job *)calloc(1, sizeof(Server_job));
+            if (job == NULL)
+                FATAL("calloc error\n");
+
+            job->conn = conn;
+            job->id = strtoull(line + 4, NULL, 10);
+            job->max_cycles = UINT64_MAX;
+            job->max_retired = UINT64_MAX;
+            if ((opt = strstr(line, "cycles=")) != NULL)
+                job->max_cycles = strtoull(opt + 7, NULL, 10);
+            if ((opt = strstr(line, "retired=")) != NULL)
+                job->max_retired = strtoull(opt + 8, NULL, 10);
+
+            too_big = false;
+            continue;
+        }
+
+        /* last program line can be glued with END, it gets own newline */
+        end = server_find_end(line, (size_t)len);
+        if (end >= 0)
+        {
+            line[end] = '\n';
+            line[end + 1] = '\0';
+            len = end > 0 ? end + 1 : 0;
+        }
+
+        if (too_big || job->len + (size_t)len > SERVER_MAX_PROGRAM)
+            too_big = true;
+        else if (len > 0)
+        {
+            job->text = (char *)realloc(job->text, job->len + (size_t)len + 1);
+            if (job->text == NULL)
+                FATAL("realloc error\n");
+
+            (void)memcpy(job->text + job->len, line, (size_t)len + 1);
+            job->len += (size_t)len;
+        }
+
+        if (end < 0)
+            continue;
+
+        if (too_big)
+        {
+            server_send(conn, "FAIL %" PRIu64 " program is too big\n", job->id);
+            FREE(job->text);
+            FREE(job);
+            continue;
+        }
+
+        (void)pthread_mutex_lock(&conn->lock);
+        ++conn->refs;
+        (void)pthread_mutex_unlock(&conn->lock);
+
+        server_push_job(server, job);
+        job = NULL;
+    }
+
+    /* job without END is dropped */
+    if (job != NULL)
+    {
+        FREE(job->text);
+        FREE(job);
+    }
+
+    FREE(line);
+    (void)fclose(in);
+
+    server_connection_release(conn);
+    return NULL;
+}
+
+static void *server_worker_thread(void *arg)
+{
+    Server *server = (Server *)arg;
+    Server_job *job;
+    Server_program *prog;
+    Tomasulo_sim *sim;
+    Tomasulo_sim_state state;
+    Tomasulo_sim_stop stop;
+    struct timespec start;
+    struct timespec end;
+    bool cached;
+    bool owned;
+
+    TRACE();
+
+    sim = tomasulo_sim_create();
+    if (sim == NULL)
+        FATAL("tomasulo_sim_create error\n");
+
+    for (;;)
+    {
+        job = server_pop_job(server);
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &start);
+
+        prog = job->text == NULL ? NULL : server_get_program(server, job, &cached, &owned);
+        if (prog == NULL || tomasulo_sim_load_program(sim, prog->program, prog->num_instr))
+        {
+            server_send(job->conn, "FAIL %" PRIu64 " cannot parse program\n", job->id);
+            if (prog != NULL && owned)
+                server_program_destroy(prog);
+        }
+        else
+        {
+            stop.cycle = job->max_cycles;
+            stop.retired = job->max_retired;
+            stop.pc = UINT64_MAX;
+
+            (void)tomasulo_sim_run_until(sim, &stop);
+            tomasulo_sim_get_state(sim, &state);
+            (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+            server_send(job->conn, "RESULT %" PRIu64 " cycles=%" PRIu64 " retired=%" PRIu64 " ipc=%.4lf pc=%" PRIu64
+                        " finished=%d cached=%d host=%.6lf\n",
+                        job->id, state.cycle, state.retired,
+                        state.cycle > 0 ? (double)state.retired / (double)state.cycle : 0.0,
+                        state.pc, state.finished, cached,
+                        (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9);
+
+            /* program is not in cache, simulator does not touch tokens after run */
+            if (owned)
+                server_program_destroy(prog);
+        }
+
+        server_connection_release(job->conn);
+        FREE(job->text);
+        FREE(job);
+    }
+
+    return NULL;
+}
+
+int server_run(const char *path, size_t num_workers)
+{
+    Server *server;
+    Server_reader *reader;
+    Server_connection *conn;
+    struct sockaddr_un addr;
+    pthread_t thread;
+    size_t i;
+    int fd;
+
+    TRACE();
+
+    if (path == NULL || num_workers == 0)
+        ERROR("path == NULL || num_workers == 0\n", 1);
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        ERROR("Socket path is too long\n", 1);
+
+    server = (Server *)calloc(1, sizeof(Server));
+    if (server == NULL)
+        ERROR("calloc error\n", 1);
+
+    (void)pthread_mutex_init(&server->lock, NULL);
+    (void)pthread_mutex_init(&server->cache_lock, NULL);
+    (void)pthread_cond_init(&server->cond, NULL);
+
+    server->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server->fd < 0)
+    {
+        FREE(server);
+        ERROR("socket error\n", 1);
+    }
+
+    (void)memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    (void)strcpy(addr.sun_path, path);
+
+    /* socket left by previous server */
+    (void)unlink(path);
+    if (bind(server->fd, (struct sockaddr *)&addr, sizeof(addr)) || listen(server->fd, SERVER_BACKLOG))
+    {
+        (void)close(server->fd);
+        FREE(server);
+        ERROR("bind / listen error\n", 1);
+    }
+
+    for (i = 0; i < num_workers; ++i)
+    {
+        if (pthread_create(&thread, NULL, server_worker_thread, server))
+            FATAL("pthread_create error\n");
+
+        (void)pthread_detach(thread);
+    }
+
+    printf("Listening on %s, %zu workers\n", path, num_workers);
+    (void)fflush(stdout);
+
+    for (;;)
+    {
+        fd = accept(server->fd, NULL, NULL);
+        if (fd < 0)
+            continue;
+
+        conn = (Server_connection *)calloc(1, sizeof(Server_connection));
+        reader = (Server_reader *)calloc(1, sizeof(Server_reader));
+        if (conn == NULL || reader == NULL)
+            FATAL("calloc error\n");
+
+        conn->fd = fd;
+        conn->refs = 1; /* reader */
+        (void)pthread_mutex_init(&conn->lock, NULL);
+
+        reader->server = server;
+        reader->conn = conn;
+
+        if (pthread_create(&thread, NULL, server_reader_thread, reader))
+            FATAL("pthread_create error\n");
+
+        (void)pthread_detach(thread);
+    }
+
+    return 0;
+}
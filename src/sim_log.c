@@ -0,0 +1,346 @@
+#include <sim_log.h>
+
+#if SIM_LOG_LEVEL > SIM_LOG_LEVEL_NONE
+
+#include <compiler.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+#include <signal.h>
+#include <inttypes.h>
+
+#define SIM_LOG_SPEC_SIZE 32
+
+typedef enum sim_log_arg_t
+{
+    SIM_LOG_ARG_INT,
+    SIM_LOG_ARG_LONG,
+    SIM_LOG_ARG_LLONG,
+    SIM_LOG_ARG_DOUBLE,
+    SIM_LOG_ARG_PTR,
+    SIM_LOG_ARG_STR
+} sim_log_arg_t;
+
+typedef struct Sim_log_spec
+{
+    const char *start; /* points to '%' */
+    size_t len; /* length of whole conversion */
+    sim_log_arg_t type;
+} Sim_log_spec;
+
+typedef struct Sim_log_record
+{
+    uint64_t seq; /* sequence number + 1 of complete record, 0 while record is written */
+    const char *fmt; /* NULL iff TRACE record */
+    const char *func;
+    uint32_t line;
+    uint32_t num_args;
+    uint64_t arg[SIM_LOG_MAX_ARGS];
+} Sim_log_record;
+
+typedef struct Sim_log_ring
+{
+    Sim_log_record record[SIM_LOG_RING_SIZE];
+    uint64_t num_records; /* all records, ring keeps last SIM_LOG_RING_SIZE */
+} Sim_log_ring;
+
+static Sim_log_ring sim_log_ring;
+
+/*
+    Find next conversion in format
+
+    PARAMS
+    @IN fmt - format
+    @OUT spec - found conversion
+
+    RETURN
+    Pointer to format after conversion
+    NULL iff there is no more conversions
+*/
+static const char *sim_log_next_spec(const char *fmt, Sim_log_spec *spec);
+
+/*
+    Print record to stream
+
+    PARAMS
+    @IN out - output stream
+    @IN seq - sequence number of record
+    @IN record - pointer to record
+
+    RETURN
+    This is a void function
+*/
+static void sim_log_print_record(FILE *out, uint64_t seq, const Sim_log_record *record);
+
+/*
+    Copy record from ring, copy is valid only when slot holds complete record
+    of this sequence number before and after copy (writer may reuse slot meanwhile)
+
+    PARAMS
+    @IN seq - sequence number of record
+    @OUT record - copy of record
+
+    RETURN
+    true iff record is complete
+    false iff record is being written or was overwritten
+*/
+static bool sim_log_read_record(uint64_t seq, Sim_log_record *record);
+
+/*
+    Signal handler, dump ring, for crash signals die with default action
+
+    PARAMS
+    @IN sig - signal number
+
+    RETURN
+    This is a void function
+*/
+static void sim_log_signal(int sig);
+
+static const char *sim_log_next_spec(const char *fmt, Sim_log_spec *spec)
+{
+    int lmod = 0; /* 0 - int, 1 - long, 2 - long long */
+
+    while (*fmt != '\0')
+    {
+        if (*fmt != '%')
+        {
+            ++fmt;
+            continue;
+        }
+
+        if (fmt[1] == '%')
+        {
+            fmt += 2;
+            continue;
+        }
+
+        spec->start = fmt++;
+
+        /* flags, width and precision */
+        while (*fmt != '\0' && strchr("-+ #0123456789.", *fmt) != NULL)
+            ++fmt;
+
+        /* length modifiers */
+        while (*fmt != '\0' && strchr("hlLqjzt", *fmt) != NULL)
+        {
+            if (*fmt == 'l' || *fmt == 'q' || *fmt == 'L')
+                ++lmod;
+            else if (*fmt == 'j' || *fmt == 'z' || *fmt == 't')
+                lmod = 1;
+            ++fmt;
+        }
+
+        switch (*fmt)
+        {
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                spec->type = SIM_LOG_ARG_DOUBLE;
+                break;
+            case 's':
+                spec->type = SIM_LOG_ARG_STR;
+                break;
+            case 'p':
+                spec->type = SIM_LOG_ARG_PTR;
+                break;
+            default:
+                spec->type = lmod == 0 ? SIM_LOG_ARG_INT : lmod == 1 ? SIM_LOG_ARG_LONG : SIM_LOG_ARG_LLONG;
+                break;
+        }
+
+        if (*fmt != '\0')
+            ++fmt;
+
+        spec->len = (size_t)(fmt - spec->start);
+        return fmt;
+    }
+
+    return NULL;
+}
+
+void sim_log_record(const char *func, uint32_t line, const char *fmt, ...)
+{
+    va_list args;
+    Sim_log_spec spec;
+    Sim_log_record *record;
+    const char *ptr = fmt;
+    double d;
+    uint64_t seq;
+
+    /* cores of multi-core simulation log from many threads */
+    seq = __atomic_fetch_add(&sim_log_ring.num_records, 1, __ATOMIC_RELAXED);
+    record = &sim_log_ring.record[seq & (SIM_LOG_RING_SIZE - 1)];
+
+    /* invalidate slot before fields are overwritten, reader drops it until seq is published */
+    __atomic_store_n(&record->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    record->fmt = fmt;
+    record->func = func;
+    record->line = line;
+    record->num_args = 0;
+
+    if (fmt == NULL)
+    {
+        __atomic_store_n(&record->seq, seq + 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    va_start(args, fmt);
+    while (record->num_args < SIM_LOG_MAX_ARGS && (ptr = sim_log_next_spec(ptr, &spec)) != NULL)
+    {
+        switch (spec.type)
+        {
+            case SIM_LOG_ARG_INT:
+                record->arg[record->num_args] = (uint64_t)va_arg(args, int);
+                break;
+            case SIM_LOG_ARG_LONG:
+                record->arg[record->num_args] = (uint64_t)va_arg(args, long);
+                break;
+            case SIM_LOG_ARG_LLONG:
+                record->arg[record->num_args] = (uint64_t)va_arg(args, long long);
+                break;
+            case SIM_LOG_ARG_DOUBLE:
+                d = va_arg(args, double);
+                (void)memcpy(&record->arg[record->num_args], &d, sizeof(d));
+                break;
+            case SIM_LOG_ARG_PTR:
+            case SIM_LOG_ARG_STR:
+            default:
+                record->arg[record->num_args] = (uint64_t)(uintptr_t)va_arg(args, const void *);
+                break;
+        }
+        ++record->num_args;
+    }
+    va_end(args);
+
+    /* publish record, all fields are visible to reader which sees this seq */
+    __atomic_store_n(&record->seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+static void sim_log_print_record(FILE *out, uint64_t seq, const Sim_log_record *record)
+{
+    Sim_log_spec spec;
+    char buf[SIM_LOG_SPEC_SIZE];
+    const char *ptr = record->fmt;
+    const char *next;
+    uint32_t i = 0;
+    double d;
+
+    fprintf(out, "[%8" PRIu64 "] %s:%" PRIu32 "\t", seq, record->func, record->line);
+    if (record->fmt == NULL)
+    {
+        fprintf(out, "TRACE\n");
+        return;
+    }
+
+    while (i < record->num_args && (next = sim_log_next_spec(ptr, &spec)) != NULL)
+    {
+        /* literal text before conversion */
+        fprintf(out, "%.*s", (int)(spec.start - ptr), ptr);
+
+        if (spec.len >= sizeof(buf))
+            spec.len = sizeof(buf) - 1;
+
+        (void)memcpy(buf, spec.start, spec.len);
+        buf[spec.len] = '\0';
+
+        switch (spec.type)
+        {
+            case SIM_LOG_ARG_INT:
+                fprintf(out, buf, (int)record->arg[i]);
+                break;
+            case SIM_LOG_ARG_LONG:
+                fprintf(out, buf, (long)record->arg[i]);
+                break;
+            case SIM_LOG_ARG_LLONG:
+                fprintf(out, buf, (long long)record->arg[i]);
+                break;
+            case SIM_LOG_ARG_DOUBLE:
+                (void)memcpy(&d, &record->arg[i], sizeof(d));
+                fprintf(out, buf, d);
+                break;
+            case SIM_LOG_ARG_STR:
+                fprintf(out, buf, (const char *)(uintptr_t)record->arg[i]);
+                break;
+            case SIM_LOG_ARG_PTR:
+            default:
+                fprintf(out, buf, (const void *)(uintptr_t)record->arg[i]);
+                break;
+        }
+
+        ptr = next;
+        ++i;
+    }
+
+    fprintf(out, "%s", ptr);
+}
+
+static bool sim_log_read_record(uint64_t seq, Sim_log_record *record)
+{
+    const Sim_log_record *slot = &sim_log_ring.record[seq & (SIM_LOG_RING_SIZE - 1)];
+    uint32_t i;
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != seq + 1)
+        return false;
+
+    record->fmt = __atomic_load_n(&slot->fmt, __ATOMIC_RELAXED);
+    record->func = __atomic_load_n(&slot->func, __ATOMIC_RELAXED);
+    record->line = __atomic_load_n(&slot->line, __ATOMIC_RELAXED);
+    record->num_args = __atomic_load_n(&slot->num_args, __ATOMIC_RELAXED);
+    if (record->num_args > SIM_LOG_MAX_ARGS)
+        record->num_args = SIM_LOG_MAX_ARGS;
+
+    for (i = 0; i < record->num_args; ++i)
+        record->arg[i] = __atomic_load_n(&slot->arg[i], __ATOMIC_RELAXED);
+
+    /* writer reused slot during copy */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq + 1;
+}
+
+void sim_log_dump(FILE *out)
+{
+    Sim_log_record record;
+    uint64_t seq;
+    uint64_t first = 0;
+    uint64_t num_records = __atomic_load_n(&sim_log_ring.num_records, __ATOMIC_ACQUIRE);
+
+    if (num_records > SIM_LOG_RING_SIZE)
+        first = num_records - SIM_LOG_RING_SIZE;
+
+    fprintf(out, "Log ring, last %" PRIu64 " of %" PRIu64 " records\n",
+            num_records - first, num_records);
+
+    for (seq = first; seq < num_records; ++seq)
+    {
+        if (sim_log_read_record(seq, &record))
+            sim_log_print_record(out, seq, &record);
+        else
+            fprintf(out, "[%8" PRIu64 "] record is being written\n", seq);
+    }
+
+    fflush(out);
+}
+
+static void sim_log_signal(int sig)
+{
+    /* not async-signal-safe, but process is dying anyway */
+    sim_log_dump(stderr);
+
+    if (sig == SIGUSR1)
+        return;
+
+    (void)signal(sig, SIG_DFL);
+    (void)raise(sig);
+}
+
+void sim_log_init(void)
+{
+    (void)signal(SIGUSR1, sim_log_signal);
+    (void)signal(SIGSEGV, sim_log_signal);
+    (void)signal(SIGBUS, sim_log_signal);
+    (void)signal(SIGFPE, sim_log_signal);
+    (void)signal(SIGABRT, sim_log_signal);
+}
+
+#endif
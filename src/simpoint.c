@@ -0,0 +1,605 @@
+#include <simpoint.h>
+#include <functional.h>
+#include <arch.h>
+#include <log.h>
+#include <compiler.h>
+#include <common.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <float.h>
+#include <inttypes.h>
+
+#define SIMPOINT_SEED       0x5EED5EEDULL
+#define SIMPOINT_MIN_VAR    1e-12
+
+/*
+    Split program into basic blocks
+
+    PARAMS
+    @IN program - set of instructions
+    @IN num_instr - number of instruction in set of instructions
+    @OUT pc_to_block - basic block of each instruction
+
+    RETURN
+    Number of basic blocks
+*/
+static size_t simpoint_find_blocks(Token **program, size_t num_instr, uint32_t *pc_to_block);
+
+/*
+    Random number generators (splitmix64 / xorshift64)
+
+    PARAMS
+    @IN x - seed / @IN state - pointer to state
+
+    RETURN
+    Random number
+*/
+static ___inline___ uint64_t simpoint_hash(uint64_t x);
+static ___inline___ uint64_t simpoint_rand(uint64_t *state);
+
+/*
+    Project BBV of interval to SIMPOINT_DIMS dimensions and clear counters
+
+    PARAMS
+    @IN block_count - executed instructions per block
+    @IN num_blocks - number of blocks
+    @IN num_instr - instructions in interval
+    @OUT point - projected BBV
+
+    RETURN
+    This is a void function
+*/
+static void simpoint_project(uint64_t *block_count, size_t num_blocks, uint64_t num_instr, double *point);
+
+/*
+    Squared euclidean distance
+
+    PARAMS
+    @IN a - point
+    @IN b - point
+
+    RETURN
+    Squared distance
+*/
+static ___inline___ double simpoint_dist2(const double *a, const double *b);
+
+/*
+    Cluster intervals by k-means (k-means++ init)
+
+    PARAMS
+    @IN sp - pointer to Simpoint
+    @IN k - number of clusters
+    @OUT assign - cluster of each interval
+    @OUT centroid - k centroids
+
+    RETURN
+    Sum of squared distances to centroids
+*/
+static double simpoint_kmeans(const Simpoint *sp, uint32_t k, uint32_t *assign, double (*centroid)[SIMPOINT_DIMS]);
+
+/*
+    Bayesian information criterion of clustering
+
+    PARAMS
+    @IN sp - pointer to Simpoint
+    @IN k - number of clusters
+    @IN assign - cluster of each interval
+    @IN sum_dist2 - sum of squared distances to centroids
+
+    RETURN
+    BIC score (higher is better)
+*/
+static double simpoint_bic(const Simpoint *sp, uint32_t k, const uint32_t *assign, double sum_dist2);
+
+/*
+    Choose k, cluster intervals and pick samples closest to centroids
+
+    PARAMS
+    @IN sp - pointer to Simpoint
+    @IN max_clusters - max number of clusters
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int simpoint_cluster(Simpoint *sp, uint32_t max_clusters);
+
+/*
+    Compare functions for qsort
+*/
+static int simpoint_cmp_dist(const void *a, const void *b);
+static int simpoint_cmp_start(const void *a, const void *b);
+
+static size_t simpoint_find_blocks(Token **program, size_t num_instr, uint32_t *pc_to_block)
+{
+    size_t i;
+    uint32_t block = 0;
+    uint32_t line;
+
+    TRACE();
+
+    /* mark leaders first */
+    (void)memset(pc_to_block, 0, sizeof(uint32_t) * num_instr);
+    pc_to_block[0] = 1;
+    for (i = 0; i < num_instr; ++i)
+        if (program[i]->type == TOKEN_JUMP)
+        {
+            line = program[i]->token_jump.line;
+            if (line < num_instr)
+                pc_to_block[line] = 1;
+
+            if (i + 1 < num_instr)
+                pc_to_block[i + 1] = 1;
+        }
+
+    for (i = 0; i < num_instr; ++i)
+    {
+        if (pc_to_block[i] && i > 0)
+            ++block;
+
+        pc_to_block[i] = block;
+    }
+
+    return (size_t)block + 1;
+}
+
+static ___inline___ uint64_t simpoint_hash(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+
+    return x ^ (x >> 31);
+}
+
+static ___inline___ uint64_t simpoint_rand(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+
+    return *state;
+}
+
+static void simpoint_project(uint64_t *block_count, size_t num_blocks, uint64_t num_instr, double *point)
+{
+    size_t b;
+    size_t d;
+    double frac;
+
+    (void)memset(point, 0, sizeof(double) * SIMPOINT_DIMS);
+    for (b = 0; b < num_blocks; ++b)
+    {
+        if (block_count[b] == 0)
+            continue;
+
+        frac = (double)block_count[b] / (double)num_instr;
+        for (d = 0; d < SIMPOINT_DIMS; ++d)
+            /* uniform projection weight in [-1, 1) fixed for (block, dim) */
+            point[d] += frac * ((double)(simpoint_hash(b * SIMPOINT_DIMS + d) >> 11) / (double)(1ULL << 52) - 1.0);
+
+        block_count[b] = 0;
+    }
+}
+
+static ___inline___ double simpoint_dist2(const double *a, const double *b)
+{
+    size_t d;
+    double sum = 0.0;
+
+    for (d = 0; d < SIMPOINT_DIMS; ++d)
+        sum += (a[d] - b[d]) * (a[d] - b[d]);
+
+    return sum;
+}
+
+static double simpoint_kmeans(const Simpoint *sp, uint32_t k, uint32_t *assign, double (*centroid)[SIMPOINT_DIMS])
+{
+    size_t i;
+    size_t d;
+    uint32_t c;
+    uint32_t best;
+    uint32_t iter;
+    uint64_t rng = SIMPOINT_SEED;
+    double *min_dist;
+    double sum;
+    double r;
+    double dist;
+    double best_dist;
+    double sum_dist2 = 0.0;
+    uint64_t count[SIMPOINT_MAX_CLUSTERS];
+    bool changed = true;
+
+    TRACE();
+
+    min_dist = (double *)malloc(sizeof(double) * sp->num_intervals);
+    if (min_dist == NULL)
+        ERROR("malloc error\n", -1.0);
+
+    /* k-means++: next centroid with probability proportional to squared distance */
+    (void)memcpy(centroid[0], sp->intervals[simpoint_rand(&rng) % sp->num_intervals].point, sizeof(centroid[0]));
+    for (i = 0; i < sp->num_intervals; ++i)
+        min_dist[i] = simpoint_dist2(sp->intervals[i].point, centroid[0]);
+
+    for (c = 1; c < k; ++c)
+    {
+        sum = 0.0;
+        for (i = 0; i < sp->num_intervals; ++i)
+            sum += min_dist[i];
+
+        r = sum * (double)(simpoint_rand(&rng) >> 11) / (double)(1ULL << 53);
+        for (i = 0; i + 1 < sp->num_intervals && r >= min_dist[i]; ++i)
+            r -= min_dist[i];
+
+        (void)memcpy(centroid[c], sp->intervals[i].point, sizeof(centroid[0]));
+        for (i = 0; i < sp->num_intervals; ++i)
+        {
+            dist = simpoint_dist2(sp->intervals[i].point, centroid[c]);
+            if (dist < min_dist[i])
+                min_dist[i] = dist;
+        }
+    }
+
+    FREE(min_dist);
+
+    for (i = 0; i < sp->num_intervals; ++i)
+        assign[i] = UINT32_MAX;
+
+    for (iter = 0; iter < SIMPOINT_KMEANS_ITERATIONS && changed; ++iter)
+    {
+        changed = false;
+        sum_dist2 = 0.0;
+
+        for (i = 0; i < sp->num_intervals; ++i)
+        {
+            best = 0;
+            best_dist = DBL_MAX;
+            for (c = 0; c < k; ++c)
+            {
+                dist = simpoint_dist2(sp->intervals[i].point, centroid[c]);
+                if (dist < best_dist)
+                {
+                    best_dist = dist;
+                    best = c;
+                }
+            }
+
+            if (assign[i] != best)
+            {
+                assign[i] = best;
+                changed = true;
+            }
+            sum_dist2 += best_dist;
+        }
+
+        (void)memset(centroid, 0, sizeof(centroid[0]) * k);
+        (void)memset(count, 0, sizeof(count));
+        for (i = 0; i < sp->num_intervals; ++i)
+        {
+            ++count[assign[i]];
+            for (d = 0; d < SIMPOINT_DIMS; ++d)
+                centroid[assign[i]][d] += sp->intervals[i].point[d];
+        }
+
+        for (c = 0; c < k; ++c)
+            for (d = 0; d < SIMPOINT_DIMS; ++d)
+                centroid[c][d] = count[c] == 0 ? 0.0 : centroid[c][d] / (double)count[c];
+    }
+
+    return sum_dist2;
+}
+
+static double simpoint_bic(const Simpoint *sp, uint32_t k, const uint32_t *assign, double sum_dist2)
+{
+    size_t i;
+    uint32_t c;
+    uint64_t size[SIMPOINT_MAX_CLUSTERS];
+    const double r = (double)sp->num_intervals;
+    const double m = (double)SIMPOINT_DIMS;
+    double var;
+    double rn;
+    double loglike = 0.0;
+
+    (void)memset(size, 0, sizeof(size));
+    for (i = 0; i < sp->num_intervals; ++i)
+        ++size[assign[i]];
+
+    var = sp->num_intervals > k ? sum_dist2 / (m * (r - (double)k)) : 0.0;
+    if (var < SIMPOINT_MIN_VAR)
+        var = SIMPOINT_MIN_VAR;
+
+    for (c = 0; c < k; ++c)
+    {
+        if (size[c] == 0)
+            continue;
+
+        rn = (double)size[c];
+        loglike += rn * log(rn) - rn * log(r) - rn * m / 2.0 * log(2.0 * M_PI * var) - m * (rn - 1.0) / 2.0;
+    }
+
+    return loglike - (double)k * (m + 1.0) / 2.0 * log(r);
+}
+
+static int simpoint_cmp_dist(const void *a, const void *b)
+{
+    const Simpoint_interval *ia = *(const Simpoint_interval *const *)a;
+    const Simpoint_interval *ib = *(const Simpoint_interval *const *)b;
+
+    if (ia->cluster != ib->cluster)
+        return ia->cluster < ib->cluster ? -1 : 1;
+
+    if (ia->dist != ib->dist)
+        return ia->dist < ib->dist ? -1 : 1;
+
+    return ia->start < ib->start ? -1 : ia->start > ib->start;
+}
+
+static int simpoint_cmp_start(const void *a, const void *b)
+{
+    const Simpoint_sample *sa = (const Simpoint_sample *)a;
+    const Simpoint_sample *sb = (const Simpoint_sample *)b;
+
+    return sa->start < sb->start ? -1 : sa->start > sb->start;
+}
+
+static int simpoint_cluster(Simpoint *sp, uint32_t max_clusters)
+{
+    uint32_t k;
+    uint32_t c;
+    size_t i;
+    uint32_t *assign;
+    double (*centroid)[SIMPOINT_DIMS];
+    double bic[SIMPOINT_MAX_CLUSTERS + 1];
+    double min_bic = DBL_MAX;
+    double max_bic = -DBL_MAX;
+    double sum_dist2;
+    uint32_t taken[SIMPOINT_MAX_CLUSTERS];
+    Simpoint_interval **sorted;
+
+    TRACE();
+
+    if (max_clusters > SIMPOINT_MAX_CLUSTERS)
+        max_clusters = SIMPOINT_MAX_CLUSTERS;
+
+    if (max_clusters > sp->num_intervals)
+        max_clusters = (uint32_t)sp->num_intervals;
+
+    if (max_clusters == 0)
+        max_clusters = 1;
+
+    assign = (uint32_t *)malloc(sizeof(uint32_t) * sp->num_intervals);
+    centroid = malloc(sizeof(centroid[0]) * SIMPOINT_MAX_CLUSTERS);
+    sorted = (Simpoint_interval **)malloc(sizeof(Simpoint_interval *) * sp->num_intervals);
+    sp->samples = (Simpoint_sample *)calloc((size_t)max_clusters * SIMPOINT_SAMPLES_PER_CLUSTER, sizeof(Simpoint_sample));
+    if (assign == NULL || centroid == NULL || sorted == NULL || sp->samples == NULL)
+    {
+        FREE(assign);
+        FREE(centroid);
+        FREE(sorted);
+        ERROR("malloc error\n", 1);
+    }
+
+    for (k = 1; k <= max_clusters; ++k)
+    {
+        sum_dist2 = simpoint_kmeans(sp, k, assign, centroid);
+        bic[k] = simpoint_bic(sp, k, assign, sum_dist2);
+
+        if (bic[k] < min_bic)
+            min_bic = bic[k];
+        if (bic[k] > max_bic)
+            max_bic = bic[k];
+    }
+
+    /* smallest k which is good enough */
+    for (k = 1; k < max_clusters; ++k)
+        if (bic[k] >= min_bic + SIMPOINT_BIC_THRESHOLD * (max_bic - min_bic))
+            break;
+
+    sp->num_clusters = k;
+    (void)simpoint_kmeans(sp, k, assign, centroid);
+
+    (void)memset(sp->cluster_instr, 0, sizeof(sp->cluster_instr));
+    for (i = 0; i < sp->num_intervals; ++i)
+    {
+        sp->intervals[i].cluster = assign[i];
+        sp->intervals[i].dist = simpoint_dist2(sp->intervals[i].point, centroid[assign[i]]);
+        sp->cluster_instr[assign[i]] += sp->intervals[i].num_instr;
+        sorted[i] = &sp->intervals[i];
+    }
+
+    /* closest intervals to centroid represent cluster */
+    qsort(sorted, sp->num_intervals, sizeof(sorted[0]), simpoint_cmp_dist);
+
+    (void)memset(taken, 0, sizeof(taken));
+    sp->num_samples = 0;
+    for (i = 0; i < sp->num_intervals; ++i)
+    {
+        c = sorted[i]->cluster;
+        if (taken[c] >= SIMPOINT_SAMPLES_PER_CLUSTER)
+            continue;
+
+        ++taken[c];
+        sp->samples[sp->num_samples].start = sorted[i]->start;
+        sp->samples[sp->num_samples].num_instr = sorted[i]->num_instr;
+        sp->samples[sp->num_samples].cluster = c;
+        ++sp->num_samples;
+    }
+
+    qsort(sp->samples, sp->num_samples, sizeof(sp->samples[0]), simpoint_cmp_start);
+
+    FREE(assign);
+    FREE(centroid);
+    FREE(sorted);
+
+    return 0;
+}
+
+Simpoint *simpoint_create(Token **program, size_t num_instr, uint64_t interval_size, uint32_t max_clusters)
+{
+    Simpoint *sp;
+    uint64_t *block_count;
+    uint64_t executed;
+    size_t capacity = 0;
+    Simpoint_interval *intervals;
+
+    TRACE();
+
+    if (program == NULL || num_instr == 0 || interval_size == 0)
+        ERROR("Wrong arguments\n", NULL);
+
+    sp = (Simpoint *)calloc(1, sizeof(Simpoint));
+    if (sp == NULL)
+        ERROR("malloc error\n", NULL);
+
+    sp->interval_size = interval_size;
+    sp->pc_to_block = (uint32_t *)malloc(sizeof(uint32_t) * num_instr);
+    if (sp->pc_to_block == NULL)
+    {
+        FREE(sp);
+        ERROR("malloc error\n", NULL);
+    }
+
+    sp->num_blocks = simpoint_find_blocks(program, num_instr, sp->pc_to_block);
+
+    block_count = (uint64_t *)calloc(sp->num_blocks, sizeof(uint64_t));
+    if (block_count == NULL)
+    {
+        simpoint_destroy(sp);
+        ERROR("malloc error\n", NULL);
+    }
+
+    /* profile BBV of each interval */
+    while ((executed = functional_run_bbv(program, num_instr, interval_size, sp->pc_to_block, block_count)) > 0)
+    {
+        if (sp->num_intervals == capacity)
+        {
+            capacity = capacity == 0 ? 64 : capacity * 2;
+            intervals = (Simpoint_interval *)realloc(sp->intervals, sizeof(Simpoint_interval) * capacity);
+            if (intervals == NULL)
+            {
+                FREE(block_count);
+                simpoint_destroy(sp);
+                ERROR("realloc error\n", NULL);
+            }
+            sp->intervals = intervals;
+        }
+
+        sp->intervals[sp->num_intervals].start = sp->total_instr;
+        sp->intervals[sp->num_intervals].num_instr = executed;
+        simpoint_project(block_count, sp->num_blocks, executed, sp->intervals[sp->num_intervals].point);
+
+        ++sp->num_intervals;
+        sp->total_instr += executed;
+    }
+
+    FREE(block_count);
+
+    if (sp->num_intervals == 0 || simpoint_cluster(sp, max_clusters))
+    {
+        simpoint_destroy(sp);
+        ERROR("Cannot choose samples\n", NULL);
+    }
+
+    return sp;
+}
+
+void simpoint_destroy(Simpoint *sp)
+{
+    TRACE();
+
+    if (sp == NULL)
+        return;
+
+    FREE(sp->pc_to_block);
+    FREE(sp->intervals);
+    FREE(sp->samples);
+    FREE(sp);
+}
+
+void simpoint_print_estimate(const Simpoint *sp)
+{
+    size_t i;
+    uint32_t c;
+    uint64_t intervals[SIMPOINT_MAX_CLUSTERS];
+    uint32_t n[SIMPOINT_MAX_CLUSTERS];
+    double sum[SIMPOINT_MAX_CLUSTERS];
+    double sum2[SIMPOINT_MAX_CLUSTERS];
+    double cpi;
+    double w;
+    double mean;
+    double var;
+    double pooled_var = 0.0;
+    uint32_t pooled = 0;
+    double est_cpi = 0.0;
+    double se2 = 0.0;
+    uint64_t detailed = 0;
+
+    TRACE();
+
+    (void)memset(intervals, 0, sizeof(intervals));
+    (void)memset(n, 0, sizeof(n));
+    (void)memset(sum, 0, sizeof(sum));
+    (void)memset(sum2, 0, sizeof(sum2));
+
+    for (i = 0; i < sp->num_intervals; ++i)
+        ++intervals[sp->intervals[i].cluster];
+
+    printf("Sampled simulation\n");
+    printf("\t%" PRIu64 " instructions, %zu basic blocks, %zu intervals of %" PRIu64 ", %" PRIu32 " phases\n",
+           sp->total_instr, sp->num_blocks, sp->num_intervals, sp->interval_size, sp->num_clusters);
+    printf("\t%-8s %8s %14s %10s %12s %8s\n", "Phase", "Weight", "Start", "Instr", "Cycles", "CPI");
+
+    for (i = 0; i < sp->num_samples; ++i)
+    {
+        c = sp->samples[i].cluster;
+        cpi = sp->samples[i].instr == 0 ? 0.0 : (double)sp->samples[i].cycles / (double)sp->samples[i].instr;
+
+        ++n[c];
+        sum[c] += cpi;
+        sum2[c] += cpi * cpi;
+        detailed += sp->samples[i].instr;
+
+        printf("\t%-8" PRIu32 " %8.4lf %14" PRIu64 " %10" PRIu64 " %12" PRIu64 " %8.3lf\n",
+               c, (double)sp->cluster_instr[c] / (double)sp->total_instr,
+               sp->samples[i].start, sp->samples[i].instr, sp->samples[i].cycles, cpi);
+    }
+
+    /* variance inside phase, pooled for phases with one sample */
+    for (c = 0; c < sp->num_clusters; ++c)
+        if (n[c] > 1)
+        {
+            mean = sum[c] / n[c];
+            pooled_var += (sum2[c] - (double)n[c] * mean * mean) / (double)(n[c] - 1);
+            ++pooled;
+        }
+
+    if (pooled > 0)
+        pooled_var /= pooled;
+
+    /* stratified estimate, phases are strata */
+    for (c = 0; c < sp->num_clusters; ++c)
+    {
+        if (n[c] == 0)
+            continue;
+
+        w = (double)sp->cluster_instr[c] / (double)sp->total_instr;
+        mean = sum[c] / n[c];
+        var = n[c] > 1 ? (sum2[c] - (double)n[c] * mean * mean) / (double)(n[c] - 1) : pooled_var;
+        if (var < 0.0)
+            var = 0.0;
+
+        est_cpi += w * mean;
+        se2 += w * w * var / n[c] * (1.0 - (double)n[c] / (double)intervals[c]);
+    }
+
+    printf("\tDetailed instructions  = %" PRIu64 " (%.2lf%%)\n",
+           detailed, 100.0 * (double)detailed / (double)sp->total_instr);
+    printf("\tEstimated cycles       = %.0lf +- %.0lf (95%%)\n",
+           est_cpi * (double)sp->total_instr, 1.96 * sqrt(se2) * (double)sp->total_instr);
+    printf("\tEstimated CPI          = %.4lf +- %.4lf (95%%)\n", est_cpi, 1.96 * sqrt(se2));
+    printf("\tEstimated IPC          = %.4lf\n", est_cpi > 0.0 ? 1.0 / est_cpi : 0.0);
+    if (pooled == 0 && sp->num_intervals > sp->num_clusters)
+        printf("\tError estimate not available, every phase has one sample\n");
+}
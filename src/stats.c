@@ -0,0 +1,383 @@
+#include <stats.h>
+#include <log.h>
+#include <compiler.h>
+#include <inttypes.h>
+
+/*
+    Get const char* from type
+*/
+static ___inline___ const char *issue_outcome_get_str(issue_outcome_t outcome);
+static ___inline___ const char *instr_class_get_str(instr_class_t instr_class);
+
+/*
+    Get class of instruction
+
+    PARAMS
+    @IN token - pointer to token
+
+    RETURN
+    Instruction class
+*/
+static ___inline___ instr_class_t instr_class_from_token(const Token *token);
+
+/*
+    Get histogram bucket of latency and lowest latency in bucket
+
+    PARAMS
+    @IN latency - latency / @IN bucket - bucket index
+
+    RETURN
+    Bucket index / Lowest latency in bucket
+*/
+static ___inline___ size_t histogram_get_bucket(uint64_t latency);
+static ___inline___ uint64_t histogram_bucket_get_min(size_t bucket);
+
+/*
+    Add latency to histogram
+
+    PARAMS
+    @IN hist - pointer to histogram
+    @IN latency - latency
+
+    RETURN
+    This is a void function
+*/
+static ___inline___ void histogram_add(Latency_histogram *hist, uint64_t latency);
+
+/*
+    Get percentile of latency from histogram, inside log buckets it is lowest latency in bucket
+
+    PARAMS
+    @IN hist - pointer to histogram
+    @IN percent - percentile (0 - 100)
+
+    RETURN
+    Latency
+*/
+static uint64_t histogram_get_percentile(const Latency_histogram *hist, double percent);
+
+/*
+    Print one row of class table
+
+    PARAMS
+    @IN out - output stream
+    @IN fmt - row format (name, count, mean, p50, p90, p99, max)
+    @IN name - class name
+    @IN hist - pointer to histogram
+
+    RETURN
+    This is a void function
+*/
+static void stats_print_row(FILE *out, const char *fmt, const char *name, const Latency_histogram *hist);
+
+static ___inline___ const char *issue_outcome_get_str(issue_outcome_t outcome)
+{
+    switch (outcome)
+    {
+        case ISSUE_OK:
+            return "Issued";
+        case ISSUE_STALL_FETCH:
+            return "Stall: fetch queue empty";
+        case ISSUE_STALL_RS_ADD_SUB:
+            return "Stall: add-sub rsc";
+        case ISSUE_STALL_RS_MUL_DIV_MOD:
+            return "Stall: mul-div-mod rsc";
+        case ISSUE_STALL_RS_CMP:
+            return "Stall: cmp rsc";
+        case ISSUE_STALL_RS_VECTOR:
+            return "Stall: vector rsc";
+        case ISSUE_STALL_LOAD_BUFFER:
+            return "Stall: load buffer";
+        case ISSUE_STALL_STORE_BUFFER:
+            return "Stall: store buffer";
+        case ISSUE_STALL_BRANCH:
+            return "Stall: branch";
+        case ISSUE_DRAINED:
+            return "Drained";
+        default:
+            return NULL;
+    }
+
+    return NULL;
+}
+
+static ___inline___ const char *instr_class_get_str(instr_class_t instr_class)
+{
+    switch (instr_class)
+    {
+        case INSTR_CLASS_MOVE_REG:
+            return "mov-reg";
+        case INSTR_CLASS_MOVE_MEM:
+            return "mov-mem";
+        case INSTR_CLASS_ADD:
+            return "add";
+        case INSTR_CLASS_SUB:
+            return "sub";
+        case INSTR_CLASS_MUL:
+            return "mul";
+        case INSTR_CLASS_DIV:
+            return "div";
+        case INSTR_CLASS_MOD:
+            return "mod";
+        case INSTR_CLASS_CMP:
+            return "cmp";
+        case INSTR_CLASS_JUMP:
+            return "jump";
+        case INSTR_CLASS_VECTOR_ALU:
+            return "vec-alu";
+        case INSTR_CLASS_VECTOR_MEM:
+            return "vec-mem";
+        default:
+            return NULL;
+    }
+
+    return NULL;
+}
+
+static ___inline___ instr_class_t instr_class_from_token(const Token *token)
+{
+    switch (token->type)
+    {
+        case TOKEN_MOVE:
+        {
+            if (token->token_move.dst.type == VAR_MEMORY || token->token_move.src.type == VAR_MEMORY)
+                return INSTR_CLASS_MOVE_MEM;
+
+            return INSTR_CLASS_MOVE_REG;
+        }
+        case TOKEN_ARYTHMETIC:
+        {
+            switch (token->token_arythmetic.type)
+            {
+                case OP_ADD:
+                    return INSTR_CLASS_ADD;
+                case OP_SUB:
+                    return INSTR_CLASS_SUB;
+                case OP_MUL:
+                    return INSTR_CLASS_MUL;
+                case OP_DIV:
+                    return INSTR_CLASS_DIV;
+                default:
+                    return INSTR_CLASS_MOD;
+            }
+        }
+        case TOKEN_CMP:
+            return INSTR_CLASS_CMP;
+        case TOKEN_VECTOR:
+        {
+            if (token->token_vector.type == VOP_LOAD || token->token_vector.type == VOP_STORE)
+                return INSTR_CLASS_VECTOR_MEM;
+
+            return INSTR_CLASS_VECTOR_ALU;
+        }
+        default:
+            return INSTR_CLASS_JUMP;
+    }
+}
+
+static ___inline___ size_t histogram_get_bucket(uint64_t latency)
+{
+    size_t bucket = STATS_HISTOGRAM_LINEAR;
+
+    if (latency < STATS_HISTOGRAM_LINEAR)
+        return (size_t)latency;
+
+    latency /= STATS_HISTOGRAM_LINEAR;
+    while (latency > 1 && bucket < STATS_HISTOGRAM_BUCKETS - 1)
+    {
+        latency >>= 1;
+        ++bucket;
+    }
+
+    return bucket;
+}
+
+static ___inline___ uint64_t histogram_bucket_get_min(size_t bucket)
+{
+    if (bucket < STATS_HISTOGRAM_LINEAR)
+        return (uint64_t)bucket;
+
+    return (uint64_t)STATS_HISTOGRAM_LINEAR << (bucket - STATS_HISTOGRAM_LINEAR);
+}
+
+static ___inline___ void histogram_add(Latency_histogram *hist, uint64_t latency)
+{
+    ++hist->bucket[histogram_get_bucket(latency)];
+    ++hist->count;
+    hist->sum += latency;
+    if (latency > hist->max)
+        hist->max = latency;
+}
+
+static uint64_t histogram_get_percentile(const Latency_histogram *hist, double percent)
+{
+    size_t i;
+    uint64_t rank;
+    uint64_t seen = 0;
+
+    if (hist->count == 0)
+        return 0;
+
+    /* nearest rank */
+    rank = (uint64_t)(percent / 100.0 * (double)hist->count + 0.5);
+    if (rank == 0)
+        rank = 1;
+
+    for (i = 0; i < STATS_HISTOGRAM_BUCKETS; ++i)
+    {
+        seen += hist->bucket[i];
+        if (seen >= rank)
+            return histogram_bucket_get_min(i);
+    }
+
+    return hist->max;
+}
+
+static void stats_print_row(FILE *out, const char *fmt, const char *name, const Latency_histogram *hist)
+{
+    fprintf(out, fmt, name, hist->count,
+            hist->count == 0 ? 0.0 : (double)hist->sum / (double)hist->count,
+            histogram_get_percentile(hist, 50.0),
+            histogram_get_percentile(hist, 90.0),
+            histogram_get_percentile(hist, 99.0),
+            hist->max);
+}
+
+void stats_count_issue(Stats *stats, issue_outcome_t outcome)
+{
+    ++stats->issue[outcome];
+}
+
+void stats_print_issue(const Stats *stats)
+{
+    size_t i;
+    uint64_t cycles = 0;
+
+    TRACE();
+
+    for (i = 0; i < ISSUE_OUTCOMES; ++i)
+        cycles += stats->issue[i];
+
+    printf("Issue breakdown, %" PRIu64 " cycles\n", cycles);
+    for (i = 0; i < ISSUE_OUTCOMES; ++i)
+        printf("\t%-24s %12" PRIu64 " %7.2lf%%\n",
+               issue_outcome_get_str((issue_outcome_t)i), stats->issue[i],
+               cycles == 0 ? 0.0 : 100.0 * (double)stats->issue[i] / (double)cycles);
+}
+
+void stats_count_fetch(Stats *stats, uint64_t fetched, uint64_t from_loop_buffer, uint64_t occupancy, bool full)
+{
+    stats->fetched += fetched;
+    stats->fetched_loop_buffer += from_loop_buffer;
+    if (full)
+        ++stats->fetch_full;
+
+    histogram_add(&stats->fetch_queue, occupancy);
+}
+
+void stats_count_redirect(Stats *stats)
+{
+    ++stats->fetch_redirects;
+}
+
+void stats_print_fetch(const Stats *stats, uint64_t cycles)
+{
+    const Latency_histogram *hist = &stats->fetch_queue;
+
+    TRACE();
+
+    printf("Fetch, %" PRIu64 " instructions fetched, %" PRIu64 " redirects\n", stats->fetched, stats->fetch_redirects);
+    printf("\tQueue full (issue bound) %12" PRIu64 " %7.2lf%%\n", stats->fetch_full,
+           cycles == 0 ? 0.0 : 100.0 * (double)stats->fetch_full / (double)cycles);
+    printf("\tFrom loop buffer         %12" PRIu64 " %7.2lf%%\n", stats->fetched_loop_buffer,
+           stats->fetched == 0 ? 0.0 : 100.0 * (double)stats->fetched_loop_buffer / (double)stats->fetched);
+    printf("\tQueue occupancy          mean %.2lf p50 %" PRIu64 " p90 %" PRIu64 " max %" PRIu64 "\n",
+           hist->count == 0 ? 0.0 : (double)hist->sum / (double)hist->count,
+           histogram_get_percentile(hist, 50.0), histogram_get_percentile(hist, 90.0), hist->max);
+}
+
+void stats_count_retire(Stats *stats, const Token *token, uint32_t issue_cycle, uint32_t exec_cycle)
+{
+    uint64_t latency = (uint64_t)(exec_cycle - issue_cycle);
+
+    histogram_add(&stats->latency[instr_class_from_token(token)], latency);
+    histogram_add(&stats->latency_all, latency);
+}
+
+void stats_print_retire(const Stats *stats, uint64_t cycles)
+{
+    size_t i;
+    size_t j;
+    const char *const fmt = "\t%-8s %12" PRIu64 " %10.2lf %6" PRIu64 " %6" PRIu64 " %6" PRIu64 " %6" PRIu64 "\n";
+
+    TRACE();
+
+    /* CPI is property of whole program, classes overlap in time, so they have count and latency only */
+    printf("Retired %" PRIu64 " instructions in %" PRIu64 " cycles, IPC %.3lf CPI %.3lf\n",
+           stats->latency_all.count, cycles,
+           cycles == 0 ? 0.0 : (double)stats->latency_all.count / (double)cycles,
+           stats->latency_all.count == 0 ? 0.0 : (double)cycles / (double)stats->latency_all.count);
+    printf("\t%-8s %12s %10s %6s %6s %6s %6s\n",
+           "Class", "Count", "Latency", "p50", "p90", "p99", "max");
+
+    stats_print_row(stdout, fmt, "all", &stats->latency_all);
+    for (i = 0; i < INSTR_CLASSES; ++i)
+        if (stats->latency[i].count > 0)
+            stats_print_row(stdout, fmt, instr_class_get_str((instr_class_t)i), &stats->latency[i]);
+
+    printf("Issue to complete latency histograms (latency:count)\n");
+    for (i = 0; i < INSTR_CLASSES; ++i)
+    {
+        if (stats->latency[i].count == 0)
+            continue;
+
+        printf("\t%-8s", instr_class_get_str((instr_class_t)i));
+        for (j = 0; j < STATS_HISTOGRAM_BUCKETS; ++j)
+            if (stats->latency[i].bucket[j] > 0)
+                printf(" %s%" PRIu64 ":%" PRIu64,
+                       j < STATS_HISTOGRAM_LINEAR ? "" : ">=",
+                       histogram_bucket_get_min(j), stats->latency[i].bucket[j]);
+        printf("\n");
+    }
+}
+
+void stats_print_host(const Stats *stats, uint64_t cycles, double seconds)
+{
+    TRACE();
+
+    printf("Host performance\n");
+    printf("\tHost time              %14.6lf s\n", seconds);
+    printf("\tSimulated cycles / s   %14.0lf\n", seconds > 0.0 ? (double)cycles / seconds : 0.0);
+    printf("\tInstructions / s       %14.0lf\n", seconds > 0.0 ? (double)stats->latency_all.count / seconds : 0.0);
+}
+
+int stats_write_csv(const Stats *stats, const char *path, uint64_t cycles)
+{
+    FILE *file;
+    size_t i;
+    const char *const fmt = "%s,%" PRIu64 ",%lf,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64;
+
+    TRACE();
+
+    file = fopen(path, "w");
+    if (file == NULL)
+        ERROR("fopen error\n", 1);
+
+    /* cycles, IPC and CPI are property of whole program, so only row "all" has them */
+    fprintf(file, "class,count,latency_mean,latency_p50,latency_p90,latency_p99,latency_max,cycles,ipc,cpi\n");
+    stats_print_row(file, fmt, "all", &stats->latency_all);
+    fprintf(file, ",%" PRIu64 ",%lf,%lf\n", cycles,
+            cycles == 0 ? 0.0 : (double)stats->latency_all.count / (double)cycles,
+            stats->latency_all.count == 0 ? 0.0 : (double)cycles / (double)stats->latency_all.count);
+
+    for (i = 0; i < INSTR_CLASSES; ++i)
+    {
+        stats_print_row(file, fmt, instr_class_get_str((instr_class_t)i), &stats->latency[i]);
+        fprintf(file, ",,,\n");
+    }
+
+    if (fclose(file) != 0)
+        ERROR("fclose error\n", 1);
+
+    return 0;
+}
@@ -28,6 +28,19 @@ ___unused___ static void variable_dbg_print(const Variable *var);
 */
 static void variable_print(const Variable *var);
 
+/*
+    Print Variable to string (like snprintf)
+
+    PARAMS
+    @OUT buf - buffer for string
+    @IN size - size of buffer
+    @IN var - pointer to Variable
+
+    RETURN
+    Number of chars which would have been written
+*/
+static int variable_snprint(char *buf, size_t size, const Variable *var);
+
 /*
     Get const string from token jump type
 
@@ -52,6 +65,18 @@ ___unused___ static const char *token_jump_get_str_from_type(const Token_jump *t
 */
 ___unused___ static const char *token_arythmetic_get_str_from_type(const Token_arythmetic *token);
 
+/*
+    Get const string from token vector type
+
+    PARAMS
+    @IN token - pointer to token_vector
+
+    RETURN
+    NULL iff failure
+    Pointer to const string iff success
+*/
+static const char *token_vector_get_str_from_type(const Token_vector *token);
+
 ___unused___ static const char *token_jump_get_str_from_type(const Token_jump *token)
 {
     TRACE();
@@ -111,6 +136,33 @@ ___unused___ static const char *token_arythmetic_get_str_from_type(const Token_a
     return NULL;
 }
 
+static const char *token_vector_get_str_from_type(const Token_vector *token)
+{
+    TRACE();
+
+    if (token == NULL)
+        return NULL;
+
+    switch (token->type)
+    {
+        case VOP_ADD:
+            return mnemonics.vadd;
+        case VOP_MUL:
+            return mnemonics.vmul;
+        case VOP_LOAD:
+            return mnemonics.vld;
+        case VOP_STORE:
+            return mnemonics.vst;
+        default:
+        {
+            LOG("Unsupported token type\n");
+            return NULL;
+        }
+    }
+
+    return NULL;
+}
+
 ___unused___ static void variable_dbg_print(const Variable *var)
 {
     TRACE();
@@ -135,6 +187,11 @@ ___unused___ static void variable_dbg_print(const Variable *var)
             LOG("\t VAL = %" PRIu32 "\n", var->val);
             break;
         }
+        case VAR_VREGISTER:
+        {
+            LOG("\tVREG[ %" PRIu32" ]\n", var->nr);
+            break;
+        }
         default:
             LOG("\tUnsupported Variable type\n");
     }
@@ -164,11 +221,38 @@ static void variable_print(const Variable *var)
             printf("%c%" PRIu32 " ",decimal_mode_c ,var->val);
             break;
         }
+        case VAR_VREGISTER:
+        {
+            printf("%c%" PRIu32 " ",vector_register_c ,var->nr);
+            break;
+        }
         default:
             break;
     }
 }
 
+static int variable_snprint(char *buf, size_t size, const Variable *var)
+{
+    switch (var->type)
+    {
+        case VAR_MEMORY:
+            return snprintf(buf, size, " %c%" PRIu32, memory_c, var->nr);
+        case VAR_REGISTER:
+            return snprintf(buf, size, " %c%" PRIu32, register_c, var->nr);
+        case VAR_VALUE:
+            return snprintf(buf, size, " %c%" PRIu32, decimal_mode_c, var->val);
+        case VAR_VREGISTER:
+            return snprintf(buf, size, " %c%" PRIu32, vector_register_c, var->nr);
+        default:
+            break;
+    }
+
+    if (size > 0)
+        buf[0] = '\0';
+
+    return 0;
+}
+
 Token *token_create(token_t type, void *token)
 {
     Token *g_token;
@@ -211,6 +295,12 @@ Token *token_create(token_t type, void *token)
             size = sizeof(g_token->token_jump);
             break;
         }
+        case TOKEN_VECTOR:
+        {
+            dst = (void *)&g_token->token_vector;
+            size = sizeof(g_token->token_vector);
+            break;
+        }
         default:
             ERROR("Unsupported token type\n", NULL);
     }
@@ -236,6 +326,7 @@ void token_dbg_print(const Token *token)
     const Token_cmp *token_cmp = (Token_cmp *)&token->token_cmp;
     const Token_jump *token_jump = (Token_jump *)&token->token_jump;
     const Token_move *token_move = (Token_move *)&token->token_move;
+    const Token_vector *token_vector = (Token_vector *)&token->token_vector;
 
     TRACE();
 
@@ -244,6 +335,18 @@ void token_dbg_print(const Token *token)
 
     switch (token->type)
     {
+        case TOKEN_VECTOR:
+        {
+            LOG("Token vector:\n");
+            LOG("\tTYPE:\t%s\n", token_vector_get_str_from_type(token_vector));
+            LOG("\tDST:\n");
+            variable_dbg_print(&token_vector->dst);
+            LOG("\tSRC1:\n");
+            variable_dbg_print(&token_vector->src1);
+            LOG("\tSRC2:\n");
+            variable_dbg_print(&token_vector->src2);
+            break;
+        }
         case TOKEN_ARYTHMETIC:
         {
             LOG("Token Arythmetic:\n");
@@ -298,6 +401,7 @@ void token_print(const Token *token)
     const Token_cmp *token_cmp = (Token_cmp *)&token->token_cmp;
     const Token_jump *token_jump = (Token_jump *)&token->token_jump;
     const Token_move *token_move = (Token_move *)&token->token_move;
+    const Token_vector *token_vector = (Token_vector *)&token->token_vector;
 
     TRACE();
 
@@ -306,6 +410,16 @@ void token_print(const Token *token)
 
     switch (token->type)
     {
+        case TOKEN_VECTOR:
+        {
+            printf("%s ", token_vector_get_str_from_type(token_vector));
+            variable_print(&token_vector->dst);
+            variable_print(&token_vector->src1);
+            variable_print(&token_vector->src2);
+            printf("\n");
+
+            break;
+        }
         case TOKEN_ARYTHMETIC:
         {
             printf("%s ", token_arythmetic_get_str_from_type(token_arythmetic));
@@ -345,4 +459,59 @@ void token_print(const Token *token)
         default:
             LOG("Unsupported token type\n");
     }
-}
\ No newline at end of file
+}
+
+int token_snprint(char *buf, size_t size, const Token *token)
+{
+    int len = 0;
+    const Variable *vars[3] = { NULL, NULL, NULL };
+    size_t i;
+
+    TRACE();
+
+    if (token == NULL)
+        return -1;
+
+    switch (token->type)
+    {
+        case TOKEN_ARYTHMETIC:
+        {
+            len = snprintf(buf, size, "%s", token_arythmetic_get_str_from_type(&token->token_arythmetic));
+            vars[0] = &token->token_arythmetic.dst;
+            vars[1] = &token->token_arythmetic.src1;
+            vars[2] = &token->token_arythmetic.src2;
+            break;
+        }
+        case TOKEN_CMP:
+        {
+            len = snprintf(buf, size, "%s", mnemonics.cmp);
+            vars[0] = &token->token_cmp.src1;
+            vars[1] = &token->token_cmp.src2;
+            break;
+        }
+        case TOKEN_JUMP:
+            return snprintf(buf, size, "%s %" PRIu32, token_jump_get_str_from_type(&token->token_jump), token->token_jump.line);
+        case TOKEN_VECTOR:
+        {
+            len = snprintf(buf, size, "%s", token_vector_get_str_from_type(&token->token_vector));
+            vars[0] = &token->token_vector.dst;
+            vars[1] = &token->token_vector.src1;
+            vars[2] = &token->token_vector.src2;
+            break;
+        }
+        case TOKEN_MOVE:
+        {
+            len = snprintf(buf, size, "%s", mnemonics.mov);
+            vars[0] = &token->token_move.dst;
+            vars[1] = &token->token_move.src;
+            break;
+        }
+        default:
+            return -1;
+    }
+
+    for (i = 0; i < 3 && vars[i] != NULL; ++i)
+        len += variable_snprint((size_t)len < size ? buf + len : NULL, (size_t)len < size ? size - (size_t)len : 0, vars[i]);
+
+    return len;
+}
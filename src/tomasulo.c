@@ -1,6 +1,14 @@
 #include <arch.h>
 #include <tokens.h>
 #include <tomasulo.h>
+#include <libtomasulo.h>
+#include <parser.h>
+#include <stats.h>
+#include <critical_path.h>
+#include <trace.h>
+#include <functional.h>
+#include <simpoint.h>
+#include <profile.h>
 #include <log.h>
 #include <compiler.h>
 #include <darray.h>
@@ -8,14 +16,76 @@
 #include <common.h>
 #include <inttypes.h>
 #include <getch.h>
+#include <time.h>
+#include <pthread.h>
+#include <sim_log.h>
 
 typedef struct Tomasulo_data
 {
-    Darray *is_array;
+    Darray *is_array; /* pool of Instructions_status *, in flight or free */
+    Instructions_status *is_free; /* free statuses linked by next */
+    uint64_t next_id; /* id of next issued instruction */
     uint32_t cycle;
+    Stats stats;
+    Critical_path critical_path;
+
+    /* SMT, per hardware thread */
+    uint64_t inflight[SMT_THREADS_MAX]; /* issued, not completed */
+    uint64_t retired[SMT_THREADS_MAX];
+    uint32_t last_fetch; /* thread which issued last instruction */
+    Trace *trace; /* NULL iff tracing is disabled */
 } Tomasulo_data;
 
-static Tomasulo_data tomasulo_data;
+/* data of core simulated by current host thread */
+static Tomasulo_data tomasulo_data_default;
+static __thread Tomasulo_data *current_data = &tomasulo_data_default;
+#define tomasulo_data (*current_data)
+
+/* one core of multi-core simulation, all cores share RAM */
+typedef struct Tomasulo_core
+{
+    Board arch;
+    Tomasulo_data data;
+    Ram_store_buffer *stores; /* writes of core in current quantum */
+
+    Token **program;
+    size_t num_instr;
+    uint64_t issued;
+    bool finished;
+} Tomasulo_core;
+
+typedef struct Tomasulo_multicore
+{
+    Tomasulo_core *core;
+    size_t num_cores;
+    size_t num_threads;
+    uint32_t quantum; /* cycles between barriers */
+
+    RAM ram;
+    pthread_barrier_t barrier;
+    bool finished; /* all cores finished */
+} Tomasulo_multicore;
+
+typedef struct Tomasulo_thread
+{
+    Tomasulo_multicore *mc;
+    size_t id; /* thread steps cores id, id + num_threads, ... */
+    pthread_t thread;
+} Tomasulo_thread;
+
+/* simulation of libtomasulo */
+struct Tomasulo_sim
+{
+    Tomasulo_core core;
+    bool owns_program; /* program parsed by tomasulo_sim_load_file */
+};
+
+/* board and data of simulation simulated by current host thread */
+typedef struct Tomasulo_context
+{
+    Board *arch;
+    Tomasulo_data *data;
+} Tomasulo_context;
 
 #define current_cycle() tomasulo_data.cycle
 #define reset_terminal() \
@@ -24,6 +94,23 @@ static Tomasulo_data tomasulo_data;
             FATAL("Terminal reset failed\n"); \
     } while (0)
 
+#define trace_enabled() (tomasulo_data.trace != NULL)
+
+/* tracks in trace, one per RSC, IO buffer and slot in unit pipeline */
+#define TRACK_BRANCH            1
+#define TRACK_LOAD              100
+#define TRACK_WRITE             200
+#define TRACK_RS_ADD_SUB        300
+#define TRACK_RS_MUL_DIV_MOD    400
+#define TRACK_RS_CMP            500
+#define TRACK_RS_VECTOR         600
+#define TRACK_FU_ADD_SUB        1000
+#define TRACK_FU_MUL_DIV_MOD    2000
+#define TRACK_FU_CMP            3000
+#define TRACK_FU_VECTOR         4000
+
+#define INSTRUCTION_NAME_SIZE   64
+
 #define reset_io(IO)      (void)memset((void *)IO, 0, sizeof(*IO))
 #define reset_rsc(RSC)    (void)memset((void *)RSC, 0, sizeof(*RSC))
 /*
@@ -35,7 +122,210 @@ static Tomasulo_data tomasulo_data;
     RETURN
     This is a void function
 */
-static ___inline___ void tomasulo_init(void);
+static ___inline___ void tomasulo_init(const Tomasulo_options *options);
+
+/*
+    Execute program only functionally and print architectural state
+
+    PARAMS
+    @IN program - set of instructions
+    @IN num_instr - number of instruction in set of instructions
+    @IN threaded - use threaded code, else interpret tokens
+
+    RETURN
+    This is a void function
+*/
+static void tomasulo_functional(Token **program, size_t num_instr, bool threaded);
+
+/*
+    Fast-forward functionally with threaded code, warming caches
+
+    PARAMS
+    @IN program - set of instructions
+    @IN num_instr - number of instruction in set of instructions
+    @IN max_instr - number of instructions to fast-forward
+
+    RETURN
+    Number of executed instructions
+*/
+static uint64_t tomasulo_fast_forward(Token **program, size_t num_instr, uint64_t max_instr);
+
+/*
+    Simulate cycles until max_issue instructions are issued (or program ends) and all jobs are done
+
+    PARAMS
+    @IN program - set of instructions
+    @IN num_instr - number of instruction in set of instructions
+    @IN max_issue - max number of instructions to issue
+    @IN headless - do not print board and do not wait for key
+
+    RETURN
+    Number of issued instructions
+*/
+static uint64_t tomasulo_run(Token **program, size_t num_instr, uint64_t max_issue, bool headless);
+
+/*
+    Fetch and execute one cycle, cycle counter is not incremented
+
+    PARAMS
+    @IN program - set of instructions
+    @IN num_instr - number of instruction in set of instructions
+    @IN max_issue - max number of instructions to issue
+    @IN issued - pointer to number of issued instructions
+
+    RETURN
+    false iff program is done (nothing was simulated)
+    true iff cycle was simulated
+*/
+static ___inline___ bool tomasulo_cycle(Token **program, size_t num_instr, uint64_t max_issue, uint64_t *issued);
+
+/*
+    Order threads by fetch priority
+
+    PARAMS
+    @IN policy - fetch policy
+    @OUT order - threads, the first one has the highest priority
+
+    RETURN
+    This is a void function
+*/
+static void smt_fetch_order(smt_fetch_policy_t policy, uint32_t *order);
+
+/*
+    Fetch from the first thread (by policy) which can issue and execute one cycle,
+    cycle counter is not incremented
+
+    PARAMS
+    @IN programs - set of instructions per thread
+    @IN num_instr - number of instruction in set of instructions per thread
+    @IN policy - fetch policy
+
+    RETURN
+    false iff all programs are done (nothing was simulated)
+    true iff cycle was simulated
+*/
+static bool tomasulo_smt_cycle(Token ***programs, const size_t *num_instr, smt_fetch_policy_t policy);
+
+/*
+    Switch current board and data
+
+    PARAMS
+    @IN board - pointer to new board
+    @IN data - pointer to new data
+
+    RETURN
+    Previous context
+*/
+static ___inline___ Tomasulo_context tomasulo_switch_context(Board *board_new, Tomasulo_data *data_new);
+
+/*
+    Destroy program owned by simulation
+
+    PARAMS
+    @IN sim - pointer to simulation
+
+    RETURN
+    This is a void function
+*/
+static void tomasulo_sim_free_program(Tomasulo_sim *sim);
+
+/*
+    Step core by quantum of cycles (or until it finishes)
+
+    PARAMS
+    @IN core - pointer to core
+    @IN quantum - number of cycles
+
+    RETURN
+    This is a void function
+*/
+static void tomasulo_core_step(Tomasulo_core *core, uint32_t quantum);
+
+/*
+    Host thread of multi-core simulation
+
+    PARAMS
+    @IN arg - pointer to Tomasulo_thread
+
+    RETURN
+    NULL
+*/
+static void *tomasulo_core_thread(void *arg);
+
+/*
+    Commit writes of all cores to shared RAM in core order, called between barriers
+
+    PARAMS
+    @IN mc - pointer to multi-core simulation
+
+    RETURN
+    This is a void function
+*/
+static void tomasulo_multicore_commit(Tomasulo_multicore *mc);
+
+/*
+    Sampled simulation: profile phases functionally, simulate in detail only samples
+
+    PARAMS
+    @IN program - set of instructions
+    @IN num_instr - number of instruction in set of instructions
+    @IN options - pointer to options
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int tomasulo_sampled(Token **program, size_t num_instr, const Tomasulo_options *options);
+
+/*
+    Get seconds between two points of time
+
+    PARAMS
+    @IN start - start time
+    @IN end - end time
+
+    RETURN
+    Seconds
+*/
+static ___inline___ double timespec_diff(const struct timespec *start, const struct timespec *end);
+
+/*
+    Create trace and name all tracks
+
+    PARAMS
+    @IN path - path to JSON file
+
+    RETURN
+    This is a void function
+*/
+static void tomasulo_trace_init(const char *path);
+
+/*
+    Get track of RSC / IO in trace
+
+    PARAMS
+    @IN rsc / io - pointer to RSC / IO
+
+    RETURN
+    Track id
+*/
+static uint32_t rsc_get_track(const Reservation_station_chunk *rsc);
+static uint32_t io_get_track(const IO_info *io);
+
+/*
+    Write slice of instruction to trace
+
+    PARAMS
+    @IN track - track id
+    @IN is - pointer to instruction
+    @IN cat - category of slice
+    @IN start - first cycle of slice
+    @IN end - last cycle of slice (inclusive)
+
+    RETURN
+    This is a void function
+*/
+static void tomasulo_trace_instruction(uint32_t track, const Instructions_status *is, const char *cat, uint32_t start, uint32_t end);
 
 /*
     Exec next cycle
@@ -53,11 +343,23 @@ static ___inline___ void tomasulo_next_cycle(void);
 
     PARAMS
     @IN token - pointer to token
+    @IN latency - time of job
 
     RETURN
     Pointer to tracked is
 */
-static ___inline___ Instructions_status *tomasulo_add_instruction_to_tracking(Token *token);
+static ___inline___ Instructions_status *tomasulo_add_instruction_to_tracking(Token *token, int32_t latency);
+
+/*
+    Count completed instruction, its status goes back to pool (is is invalid after call)
+
+    PARAMS
+    @IN is - pointer to completed instruction
+
+    RETURN
+    This is a void function
+*/
+static ___inline___ void tomasulo_retire(Instructions_status *is);
 
 /*
     Deinit whole tomasulo data
@@ -110,6 +412,7 @@ static ___inline___ bool is_io_busy(const IO_info *io_array, size_t io_array_siz
 #define is_rsc_mul_div_mod_busy() is_rsc_busy((const Reservation_station_chunk *)board.rs.mul, RS_MUL_DIV_MOD_SIZE)
 #define is_rsc_add_sub_busy()     is_rsc_busy((const Reservation_station_chunk *)board.rs.add, RS_ADD_SUB_SIZE)
 #define is_rsc_cmp_busy()         is_rsc_busy((const Reservation_station_chunk *)&board.rs.cmp, 1)
+#define is_rsc_vector_busy()      is_rsc_busy((const Reservation_station_chunk *)board.rs.vec, RS_VECTOR_SIZE)
 #define is_io_load_busy()         is_io_busy((const IO_info *)board.load_buffer.load, LOAD_BUFFER_SIZE)
 #define is_io_write_busy()        is_io_busy((const IO_info *)board.write_buffer.write, WRITE_BUFFER_SIZE)
 
@@ -143,6 +446,7 @@ static ___inline___ IO_info *get_first_free_io(const IO_info *io_array, size_t i
 #define get_first_free_mul_div_mod() get_first_free_rsc((const Reservation_station_chunk *)board.rs.mul, RS_MUL_DIV_MOD_SIZE)
 #define get_first_free_add_sub()     get_first_free_rsc((const Reservation_station_chunk *)board.rs.add, RS_ADD_SUB_SIZE)
 #define get_first_free_cmp()         get_first_free_rsc((const Reservation_station_chunk *)&board.rs.cmp, 1)
+#define get_first_free_vector()      get_first_free_rsc((const Reservation_station_chunk *)board.rs.vec, RS_VECTOR_SIZE)
 #define get_first_free_io_load()     get_first_free_io((const IO_info *)board.load_buffer.load, LOAD_BUFFER_SIZE)
 #define get_first_free_io_write()    get_first_free_io((const IO_info *)board.write_buffer.write, WRITE_BUFFER_SIZE)
 
@@ -158,6 +462,93 @@ static ___inline___ IO_info *get_first_free_io(const IO_info *io_array, size_t i
 */
 static void execute_io(IO_info *io_array, size_t io_array_size);
 
+#define io_reads_memory(IO)     ((IO)->src.type == VAR_MEMORY)
+#define io_writes_memory(IO)    ((IO)->dst.type == VAR_MEMORY)
+#define io_touches_memory(IO)   (io_reads_memory(IO) || io_writes_memory(IO))
+
+/* words of memory accessed by IO, vld / vst access whole vector */
+#define io_mem_len(IO) \
+    (((IO)->dst.type == VAR_VREGISTER || (IO)->src.type == VAR_VREGISTER) ? (uint32_t)VECTOR_LENGTH : 1U)
+
+/*
+    Get time of IO job, memory accesses go through caches,
+    so call it only when IO is issued
+
+    PARAMS
+    @IN io - pointer to IO_info
+
+    RETURN
+    Time of IO job
+*/
+static ___inline___ int32_t io_get_time(const IO_info *io);
+
+/*
+    Insert IO to load / store queue (only iff IO touches memory)
+    IOs are inserted in program order, so queue is ordered by age
+
+    PARAMS
+    @IN io - pointer to IO_info
+
+    RETURN
+    This is a void function
+*/
+static ___inline___ void lsq_insert(IO_info *io);
+
+/*
+    Remove IO from load / store queue
+
+    PARAMS
+    @IN io - pointer to IO_info
+
+    RETURN
+    This is a void function
+*/
+static ___inline___ void lsq_remove(const IO_info *io);
+
+/*
+    Check if memory ranges of 2 IO overlap
+
+    PARAMS
+    @IN addr1 - address of the first word accessed by @io1
+    @IN io1 - pointer to IO_info
+    @IN addr2 - address of the first word accessed by @io2
+    @IN io2 - pointer to IO_info
+
+    RETURN
+    true iff ranges overlap
+    false iff not
+*/
+static ___inline___ bool lsq_overlap(uint32_t addr1, const IO_info *io1, uint32_t addr2, const IO_info *io2);
+
+/*
+    Check if IO can access memory now.
+    Load can take value from the youngest older store to the same address
+    iff data of this store is ready, otherwise load has to wait for store.
+    Store has to wait for all older accesses to the same address.
+    Vector access is never forwarded, it waits for older overlapping store.
+
+    PARAMS
+    @IN io - pointer to IO_info
+    @OUT val - forwarded value (only iff LSQ_ACCESS_FORWARD)
+
+    RETURN
+    LSQ_ACCESS_READY iff IO can use memory
+    LSQ_ACCESS_FORWARD iff value has been forwarded from store
+    LSQ_ACCESS_BLOCKED iff IO has to wait for older access
+*/
+static lsq_access_t lsq_check_access(const IO_info *io, reg_t *val);
+
+/*
+    Count memory accesses in flight in this cycle
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    This is a void function
+*/
+static ___inline___ void lsq_update_stats(void);
+
 /*
     Helper for execute ayrthmetic / cmp
 
@@ -171,45 +562,124 @@ static void execute_io(IO_info *io_array, size_t io_array_size);
 static void execute_rsc(Reservation_station_chunk *rsc_array, size_t rsc_array_size);
 
 /*
-    Clear dependency Helper for
-    dependency_clear_and_prepare_work
+    Is any op in flight in functional units ?
+
+    PARAMS
+    @IN fu_array - array of functional units
+    @IN fu_array_size - @fu_array length
+
+    RETURN
+    true iff at least 1 op is in flight
+    false iff all units are empty
+*/
+static ___inline___ bool is_fu_busy(const Functional_unit *fu_array, size_t fu_array_size);
+
+/*
+    Has thread cmp in rsc or in unit ? Jump of thread has to wait for compare flag
+
+    PARAMS
+    @IN thread - hardware thread
+
+    RETURN
+    true iff cmp of thread is not completed
+    false iff compare flag of thread is set correctly
+*/
+static ___inline___ bool is_cmp_pending(uint32_t thread);
+
+/*
+    Get unit which can accept new op in this cycle
+
+    PARAMS
+    @IN fu_array - array of functional units
+    @IN fu_array_size - @fu_array length
+
+    RETURN
+    NULL iff all units are busy
+    Pointer to free slot in unit pipeline iff is any
+*/
+static ___inline___ Reservation_station_chunk *get_first_free_fu_slot(Functional_unit *fu_array, size_t fu_array_size, Functional_unit **fu);
+
+/*
+    Move op from RSC to slot in unit pipeline,
+    registers working with RSC will work with slot
+
+    PARAMS
+    @IN rsc - pointer to RSC
+    @IN slot - pointer to slot in unit pipeline
+
+    RETURN
+    This is a void function
+*/
+static ___inline___ void rsc_move_to_fu(Reservation_station_chunk *rsc, Reservation_station_chunk *slot);
+
+/*
+    Dispatch ready ops from RSC to functional units
 
     PARAMS
-    @IN dep - dependency
+    @IN rsc_array - array of RSC
+    @IN rsc_array_size - @rsc_array length
+    @IN fu_array - array of functional units
+    @IN fu_array_size - @fu_array length
+    @IN ii - initiation interval of units
+    @OUT stalls - counter of ready ops waiting for units
 
     RETURN
     This is a void function
 */
-static ___inline___ void __dependency_clear(Dependency *dep);
+static void dispatch_rsc(Reservation_station_chunk *rsc_array, size_t rsc_array_size,
+                         Functional_unit *fu_array, size_t fu_array_size, int32_t ii, uint64_t *stalls);
+
+/*
+    Execute ops in flight and move pipelines to next cycle
+
+    PARAMS
+    @IN fu_array - array of functional units
+    @IN fu_array_size - @fu_array length
 
+    RETURN
+    This is a void function
+*/
+static void execute_fu(Functional_unit *fu_array, size_t fu_array_size);
 
 /*
-    Clear dependency on whole dependency array
-    and schedule new work for io / rsc waiting for this job
+    Broadcast tag and result of completed instruction (common data bus),
+    operands waiting for it capture result and are ready
 
     PARAMS
-    @IN dep_array - array of dependencies
-    @IN dep_array_size - @dep_array length
+    @IN tag - tag of completed instruction
+    @IN track - track of completed instruction in trace (used only iff tracing)
+    @IN result - result of completed instruction
 
     RETURN
     This is a void function
 */
-static ___inline___ void dependency_clear_and_prepare_work(Dependency *dep_array, size_t dep_array_size);
+static void tag_broadcast(tag_t tag, uint32_t track, const Operand_value *result);
 
-#define dependency_clear_and_prepare_work_io(IO) \
-    dependency_clear_and_prepare_work((Dependency *)IO->dependency, DEPENDENCY_NR_OF_SLOT_IO)
+/*
+    Operands waiting for tag capture result and are ready
+
+    PARAMS
+    @IN wait_tag - array of tags waited by operands
+    @OUT val - array of operand values
+    @IN wait_tag_size - @wait_tag length
+    @IN tag - tag of completed instruction
+    @IN result - result of completed instruction
 
-#define dependency_clear_and_prepare_work_rsc(RSC) \
-    dependency_clear_and_prepare_work((Dependency *)RSC->dependency, DEPENDENCY_NR_OF_SLOT_RSC)
+    RETURN
+    true iff any operand waited for tag
+    false iff none
+*/
+static ___inline___ bool __tag_wake(tag_t *wait_tag, Operand_value *val, size_t wait_tag_size, tag_t tag,
+                                    const Operand_value *result);
 
 #define io_can_do_job(IO) \
     ((IO->state == STATE_BUSY) \
-     && (!IO->has_dependency[DEPENDENCY_FROM_DST] && !IO->has_dependency[DEPENDENCY_FROM_SRC1]))
+     && (IO->wait_tag[DEPENDENCY_FROM_DST] == TAG_NONE && IO->wait_tag[DEPENDENCY_FROM_SRC1] == TAG_NONE))
 
 #define rsc_can_do_job(RSC) \
     ((RSC->state == STATE_BUSY) && \
-    (!RSC->has_dependency[DEPENDENCY_FROM_DST] && !RSC->has_dependency[DEPENDENCY_FROM_SRC1] \
-     && !RSC->has_dependency[DEPENDENCY_FROM_SRC2]))
+    (RSC->wait_tag[DEPENDENCY_FROM_DST] == TAG_NONE && RSC->wait_tag[DEPENDENCY_FROM_SRC1] == TAG_NONE \
+     && RSC->wait_tag[DEPENDENCY_FROM_SRC2] == TAG_NONE))
 
 /*
     Execute all load / write /  arythmetic operation
@@ -246,99 +716,199 @@ static ___inline___ void execute(void);
 static ___inline___ void tomasulo_print(void);
 
 /*
-    Helper for prepare_work: Prepare variable to work (check register state)
+    Rename source register operand at issue: value is captured now iff register
+    has no writer in flight, else operand waits for tag of the last writer
+    (readers of one register wait for the same tag and wake together)
 
     PARAMS
     @IN var - pointer to variable
-    @IN worker - pointer to Worker
-    @IN dep_slot - index in dependency array
+    @IN slot - operand slot
+    @OUT wait_tag - array of tags waited by operands
+    @OUT val - array of operand values
 
     RETURN
     This is a void function
 */
-static void __prepare_work(Variable *var, Worker *worker, int dep_slot);
+static ___inline___ void __rat_read(const Variable *var, dependency_slot_t slot, tag_t *wait_tag, Operand_value *val);
 
 /*
-    Prepare Work for set worker (check register state)
+    Rename destination register operand at issue: instruction becomes the last writer of register,
+    destination never waits (older readers have own copy of value, older writer does not write back)
 
     PARAMS
-    @IN worker - pointer to Worker
+    @IN var - pointer to variable
+    @IN tag - tag of instruction
+    @IN job - job of instruction
 
     RETURN
-    This is a void function
+    NULL iff variable is not register
+    Pointer to register iff success
 */
-static ___inline___ void prepare_work(Worker *worker);
+static Register_info *__rat_write(const Variable *var, tag_t tag, job_t job);
 
 /*
-    Helper for setup_work: Setup variable to work
-    Dont check if regitser is busy
+    Get entry of register alias table for register operand
 
     PARAMS
     @IN var - pointer to variable
-    @IN worker - pointer to Worker
-    @IN dep_slot - index in dependency array
 
     RETURN
-    This is a void function
+    NULL iff variable is not register (or vector register is out of range)
+    Pointer to Rat_entry iff success
 */
-static void __setup_work(Variable *var, Worker *worker, int dep_slot);
+static ___inline___ Rat_entry *__rat_entry(const Variable *var);
 
 /*
-    Prepare Work for worker (dont check register sttae)
+    Write result of completed instruction to destination register iff instruction
+    is still the last writer of register (else younger writer owns it), register is free
+    when its last writer has completed
 
     PARAMS
-    @IN worker - pointer to Worker
+    @IN var - pointer to variable
+    @IN tag - tag of completed instruction
+    @IN result - result of instruction
 
     RETURN
     This is a void function
 */
-static ___inline___ void setup_work(Worker *worker);
+static ___inline___ void __rat_write_back(const Variable *var, tag_t tag, const Operand_value *result);
+
 /*
-    Fetch new token
+    Tag new instruction in RSC / IO and rename its operands
 
     PARAMS
-    @IN token - new token
+    @IN rsc / io - pointer to RSC / IO with new instruction
 
     RETURN
     This is a void function
 */
-static void fetch(Token *token);
+static void rat_rename_rsc(Reservation_station_chunk *rsc);
+static void rat_rename_io(IO_info *io);
 
 /*
-    Checks Arch for unfinished jobs
+    Operand of arythmetic or cmp, units read register file by number of every operand (also M and #)
 
     PARAMS
-    NO PARAMS
+    @IN var - pointer to variable
 
     RETURN
-    true iff is any unfinished job
-    false iff all jobs  are finished
+    Register operand
 */
-static ___inline___ bool wait_for_unfinished_job(void);
+static ___inline___ Variable rsc_register_operand(const Variable *var);
 
 /*
-    Check if variable has dependency
+    Decode token: classify unit and resolve latency
 
     PARAMS
-    Var - pointer to variable
+    @IN token - token to decode
+    @OUT uop - decoded instruction
 
     RETURN
-    true iff variable has dep
-    false iff variable has not any dep
+    This is a void function
 */
-static ___inline___ bool var_works_with_dep(const Variable *var);
+static void decode(Token *token, Uop *uop);
 
-static void __is_destroy(void *is)
-{
-    Instructions_status *__is = *(Instructions_status **)is;
-    FREE(__is);
-}
+/*
+    Issue decoded instruction
 
-static ___inline___ Reservation_station_chunk *get_first_free_rsc(const Reservation_station_chunk *rsc_array, size_t rsc_array_size)
-{
-    size_t i;
+    PARAMS
+    @IN uop - decoded instruction from head of fetch queue
 
-    TRACE();
+    RETURN
+    ISSUE_OK iff instruction has been issued
+    Reason of stall iff instruction has to wait
+*/
+static issue_outcome_t issue(const Uop *uop);
+
+/*
+    Capture body of loop closed by predicted taken jump to loop buffer,
+    loop is captured when the same jump is fetched twice in a row and body
+    fits in buffer without other jumps
+
+    PARAMS
+    @IN lb - loop buffer of current thread
+    @IN program - program of current thread
+    @IN pc - PC of backward jump
+
+    RETURN
+    true iff loop has been captured
+    false iff not
+*/
+static bool loop_buffer_capture(Loop_buffer *lb, Token **program, program_counter_t pc);
+
+/*
+    Restart front end of current thread at its PC, flush is not a redirect
+    (PC was moved by fast-forward, not by mispredicted jump)
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    This is a void function
+*/
+static ___inline___ void front_end_reset(void);
+
+/*
+    Issue instruction from head of fetch queue of current thread,
+    queue is flushed iff it holds wrong path (PC changed by jump)
+
+    PARAMS
+    @IN program - program of current thread
+
+    RETURN
+    ISSUE_OK iff instruction has been issued
+    Reason of stall iff instruction has to wait
+*/
+static issue_outcome_t issue_from_fetch_queue(Token **program);
+
+/*
+    Fetch up to FETCH_WIDTH instructions of current thread on predicted path to fetch queue
+
+    PARAMS
+    @IN program - program of current thread
+    @IN num_instr - number of instructions in program
+
+    RETURN
+    This is a void function
+*/
+static void fetch(Token **program, size_t num_instr);
+
+/*
+    Predict jump statically, backward jump (loop) is taken, forward jump is not taken
+
+    PARAMS
+    @IN tjump - pointer to jump
+    @IN pc - address of jump
+
+    RETURN
+    true iff jump is predicted as taken
+*/
+static ___inline___ bool jump_predict_taken(const Token_jump *tjump, program_counter_t pc);
+
+/*
+    Checks Arch for unfinished jobs
+
+    PARAMS
+    NO PARAMS
+
+    RETURN
+    true iff is any unfinished job
+    false iff all jobs  are finished
+*/
+static ___inline___ bool wait_for_unfinished_job(void);
+
+static void __is_destroy(void *is)
+{
+    Instructions_status *__is = *(Instructions_status **)is;
+    critical_path_retire(&tomasulo_data.critical_path, __is);
+    FREE(__is);
+}
+
+static ___inline___ Reservation_station_chunk *get_first_free_rsc(const Reservation_station_chunk *rsc_array, size_t rsc_array_size)
+{
+    size_t i;
+
+    TRACE();
 
     for (i = 0; i < rsc_array_size; ++i)
         if (rsc_array[i].state == STATE_FREE)
@@ -386,49 +956,321 @@ static ___inline___  bool is_io_busy(const IO_info *io_array, size_t io_array_si
     return true;
 }
 
-static ___inline___ void dependency_clear_and_prepare_work(Dependency *dep_array, size_t dep_array_size)
+static ___inline___ bool is_fu_busy(const Functional_unit *fu_array, size_t fu_array_size)
 {
     size_t i;
+    size_t j;
 
     TRACE();
 
-    for (i = 0; i < dep_array_size; ++i)
+    for (i = 0; i < fu_array_size; ++i)
+        for (j = 0; j < FU_PIPELINE_DEPTH; ++j)
+            if (fu_array[i].pipeline[j].state == STATE_BUSY)
+                return true;
+
+    return false;
+}
+
+static ___inline___ bool is_cmp_pending(uint32_t thread)
+{
+    size_t i;
+    size_t j;
+
+    TRACE();
+
+    if (board.rs.cmp.state == STATE_BUSY && board.rs.cmp.is->thread == thread)
+        return true;
+
+    for (i = 0; i < FU_CMP_NUM; ++i)
+        for (j = 0; j < FU_PIPELINE_DEPTH; ++j)
+            if (board.fu.cmp[i].pipeline[j].state == STATE_BUSY && board.fu.cmp[i].pipeline[j].is->thread == thread)
+                return true;
+
+    return false;
+}
+
+static ___inline___ Reservation_station_chunk *get_first_free_fu_slot(Functional_unit *fu_array, size_t fu_array_size, Functional_unit **fu)
+{
+    size_t i;
+    Reservation_station_chunk *slot;
+
+    TRACE();
+
+    for (i = 0; i < fu_array_size; ++i)
     {
-        __dependency_clear(&dep_array[i]);
-        if (dep_array[i].type != DEPENDENCY_NONE)
+        if (fu_array[i].ii_wait > 0)
+            continue;
+
+        slot = get_first_free_rsc((const Reservation_station_chunk *)fu_array[i].pipeline, FU_PIPELINE_DEPTH);
+        if (slot != NULL)
         {
-            LOG("Has dependency, now it is clear, setup worker\n");
-            setup_work((Worker *)&dep_array[i]);
+            *fu = &fu_array[i];
+            return slot;
         }
     }
+
+    return NULL;
+}
+
+static ___inline___ void rsc_move_to_fu(Reservation_station_chunk *rsc, Reservation_station_chunk *slot)
+{
+    TRACE();
+
+    rsc->is->started = true;
+    rsc->is->start_cycle = current_cycle();
+
+    /* op waited in rsc from issue to dispatch */
+    if (trace_enabled() && rsc->is->start_cycle > rsc->is->issue_cycle)
+        tomasulo_trace_instruction(rsc_get_track(rsc), rsc->is, "wait", rsc->is->issue_cycle, rsc->is->start_cycle - 1);
+
+    /* tag moves with op, so register alias table is still valid */
+    *slot = *rsc;
+
+    reset_rsc(rsc);
+    rsc->state = STATE_FREE;
+    rsc->job = JOB_IDLE;
 }
 
-static ___inline___ void __dependency_clear(Dependency *dep)
+static void dispatch_rsc(Reservation_station_chunk *rsc_array, size_t rsc_array_size,
+                         Functional_unit *fu_array, size_t fu_array_size, int32_t ii, uint64_t *stalls)
 {
+    size_t i;
+    Reservation_station_chunk *rsc;
+    Reservation_station_chunk *slot;
+    Functional_unit *fu;
+
     TRACE();
 
-    switch (dep->type)
+    for (i = 0; i < rsc_array_size; ++i)
     {
-        case DEPENDENCY_IO:
+        rsc = &rsc_array[i];
+        if (!rsc_can_do_job(rsc))
+            continue;
+
+        slot = get_first_free_fu_slot(fu_array, fu_array_size, &fu);
+        if (slot == NULL)
         {
-            LOG("Clear IO dependency for slot %d\n", dep->slot);
-            dep->io->has_dependency[dep->slot] = false;
-            break;
+            LOG("All units busy, op waits in rsc\n");
+            ++(*stalls);
+            continue;
         }
-        case DEPENDENCY_OP:
-        {
-            LOG("Clear RSC dependency for slot %d\n", dep->slot);
-            dep->rsc->has_dependency[dep->slot] = false;
+
+        LOG("Dispatch job %d to unit\n", rsc->job);
+        rsc_move_to_fu(rsc, slot);
+
+        fu->ii_wait = ii;
+        ++fu->ops;
+    }
+}
+
+static void execute_fu(Functional_unit *fu_array, size_t fu_array_size)
+{
+    size_t i;
+
+    TRACE();
+
+    for (i = 0; i < fu_array_size; ++i)
+    {
+        if (is_fu_busy(&fu_array[i], 1))
+            ++fu_array[i].busy_cycles;
+
+        execute_rsc((Reservation_station_chunk *)fu_array[i].pipeline, FU_PIPELINE_DEPTH);
+
+        if (fu_array[i].ii_wait > 0)
+            --fu_array[i].ii_wait;
+    }
+}
+
+static ___inline___ int32_t io_get_time(const IO_info *io)
+{
+    int32_t time = 0;
+
+    TRACE();
+
+    /* register to register or value to register */
+    if (!io_touches_memory(io))
+        return CYCLES_MOV_REG;
+
+    if (io_reads_memory(io))
+        time += memory_access_time_range(io->src.nr, io_mem_len(io), false);
+
+    if (io_writes_memory(io))
+        time += memory_access_time_range(io->dst.nr, io_mem_len(io), true);
+
+    return time;
+}
+
+static ___inline___ void lsq_insert(IO_info *io)
+{
+    TRACE();
+
+    if (!io_touches_memory(io))
+        return;
+
+    if (board.lsq.num_entries >= LOAD_STORE_QUEUE_SIZE)
+        FATAL("Load / store queue overflow\n");
+
+    board.lsq.entry[board.lsq.num_entries++] = io;
+}
+
+static ___inline___ void lsq_remove(const IO_info *io)
+{
+    size_t i;
+
+    TRACE();
+
+    for (i = 0; i < board.lsq.num_entries; ++i)
+        if (board.lsq.entry[i] == io)
+            break;
+
+    if (i == board.lsq.num_entries)
+        return;
+
+    --board.lsq.num_entries;
+    for (; i < board.lsq.num_entries; ++i)
+        board.lsq.entry[i] = board.lsq.entry[i + 1];
+
+    board.lsq.entry[board.lsq.num_entries] = NULL;
+}
+
+static ___inline___ bool lsq_overlap(uint32_t addr1, const IO_info *io1, uint32_t addr2, const IO_info *io2)
+{
+    return (uint64_t)addr1 < (uint64_t)addr2 + io_mem_len(io2) && (uint64_t)addr2 < (uint64_t)addr1 + io_mem_len(io1);
+}
+
+static lsq_access_t lsq_check_access(const IO_info *io, reg_t *val)
+{
+    size_t pos;
+    size_t i;
+    const IO_info *older;
+
+    TRACE();
+
+    for (pos = 0; pos < board.lsq.num_entries; ++pos)
+        if (board.lsq.entry[pos] == io)
             break;
+
+    /* not in queue, so it does not touch memory */
+    if (pos == board.lsq.num_entries)
+        return LSQ_ACCESS_READY;
+
+    /* store can't overtake any older access to the same address */
+    if (io_writes_memory(io))
+        for (i = 0; i < pos; ++i)
+        {
+            older = board.lsq.entry[i];
+            if ((io_writes_memory(older) && lsq_overlap(older->dst.nr, older, io->dst.nr, io)) ||
+                (io_reads_memory(older) && lsq_overlap(older->src.nr, older, io->dst.nr, io)))
+            {
+                LOG("Store to M%" PRIu32 " waits for older access\n", io->dst.nr);
+                return LSQ_ACCESS_BLOCKED;
+            }
         }
-        case DEPENDENCY_NONE:
+
+    if (!io_reads_memory(io))
+        return LSQ_ACCESS_READY;
+
+    /* find the youngest older store to the same address */
+    for (i = pos; i > 0; --i)
+    {
+        older = board.lsq.entry[i - 1];
+        if (!io_writes_memory(older) || !lsq_overlap(older->dst.nr, older, io->src.nr, io))
+            continue;
+
+        /* only loads to register can be served by store, mem to mem store reads memory itself */
+        if (io->dst.type == VAR_REGISTER && io_can_do_job(older) && !io_reads_memory(older) &&
+            older->src.type != VAR_VREGISTER)
         {
-            break;
+            LOG("Forward M%" PRIu32 " from older store\n", io->src.nr);
+
+            /* store has captured its register operand (also of other thread) */
+            *val = older->src.type == VAR_REGISTER ? older->val[DEPENDENCY_FROM_SRC1].val : variable_get_value(&older->src);
+            return LSQ_ACCESS_FORWARD;
         }
-        default:
+
+        LOG("Load from M%" PRIu32 " waits for older store\n", io->src.nr);
+        return LSQ_ACCESS_BLOCKED;
+    }
+
+    return LSQ_ACCESS_READY;
+}
+
+static ___inline___ void lsq_update_stats(void)
+{
+    size_t i;
+    uint64_t inflight = 0;
+    const IO_info *io;
+
+    TRACE();
+
+    for (i = 0; i < board.lsq.num_entries; ++i)
+    {
+        io = board.lsq.entry[i];
+        if (io_can_do_job(io))
+            ++inflight;
+    }
+
+    if (inflight > 0)
+    {
+        board.lsq.inflight_sum += inflight;
+        ++board.lsq.inflight_cycles;
+    }
+}
+
+static ___inline___ bool __tag_wake(tag_t *wait_tag, Operand_value *val, size_t wait_tag_size, tag_t tag,
+                                    const Operand_value *result)
+{
+    size_t i;
+    bool woken = false;
+
+    for (i = 0; i < wait_tag_size; ++i)
+        if (wait_tag[i] == tag)
         {
-            break;
+            wait_tag[i] = TAG_NONE;
+            val[i] = *result;
+            woken = true;
         }
+
+    return woken;
+}
+
+static void tag_broadcast(tag_t tag, uint32_t track, const Operand_value *result)
+{
+    size_t i;
+    IO_info *io;
+    Reservation_station_chunk *rsc;
+
+    TRACE();
+
+    /* only IO and RSC can wait, ops in units have all operands */
+    for (i = 0; i < LOAD_BUFFER_SIZE + WRITE_BUFFER_SIZE; ++i)
+    {
+        io = i < LOAD_BUFFER_SIZE ? &board.load_buffer.load[i] : &board.write_buffer.write[i - LOAD_BUFFER_SIZE];
+        if (io->state != STATE_BUSY || !__tag_wake(io->wait_tag, io->val, DEPENDENCY_NR_OF_SLOT_IO, tag, result))
+            continue;
+
+        LOG("IO waited for tag %" PRIu64 ", operand captured\n", tag);
+        if (trace_enabled())
+            trace_flow(tomasulo_data.trace, track, io_get_track(io), current_cycle());
+    }
+
+    for (i = 0; i < RS_ADD_SUB_SIZE + RS_MUL_DIV_MOD_SIZE + 1 + RS_VECTOR_SIZE; ++i)
+    {
+        if (i < RS_ADD_SUB_SIZE)
+            rsc = &board.rs.add[i];
+        else if (i < RS_ADD_SUB_SIZE + RS_MUL_DIV_MOD_SIZE)
+            rsc = &board.rs.mul[i - RS_ADD_SUB_SIZE];
+        else if (i == RS_ADD_SUB_SIZE + RS_MUL_DIV_MOD_SIZE)
+            rsc = &board.rs.cmp;
+        else
+            rsc = &board.rs.vec[i - RS_ADD_SUB_SIZE - RS_MUL_DIV_MOD_SIZE - 1];
+
+        if (rsc->state != STATE_BUSY || !__tag_wake(rsc->wait_tag, rsc->val, DEPENDENCY_NR_OF_SLOT_RSC, tag, result))
+            continue;
+
+        LOG("RSC waited for tag %" PRIu64 ", operand captured\n", tag);
+        if (trace_enabled())
+            trace_flow(tomasulo_data.trace, track, rsc_get_track(rsc), current_cycle());
     }
 }
 
@@ -436,6 +1278,10 @@ static void execute_io(IO_info *io_array, size_t io_array_size)
 {
     size_t i;
     IO_info *io;
+    lsq_access_t access;
+    reg_t val = 0;
+    Operand_value result;
+    Vector_register_info vtmp;
 
     TRACE();
     for (i = 0; i < io_array_size; ++i)
@@ -445,20 +1291,64 @@ static void execute_io(IO_info *io_array, size_t io_array_size)
         /* Can be executed  */
         if (io_can_do_job(io))
         {
+            if (!io->is->started)
+            {
+                io->is->started = true;
+                io->is->start_cycle = current_cycle();
+            }
+
             /* completed */
             if (io->wait_time == 0)
             {
+                board_switch_thread(io->is->thread);
+                access = lsq_check_access(io, &val);
+                if (access == LSQ_ACCESS_BLOCKED)
+                {
+                    ++board.lsq.blocked;
+                    continue;
+                }
+
                 LOG("IO %d JOB completed\n", io->job);
-                if (io->dst.type == VAR_REGISTER)
-                    copy_data_to_reg(io->dst.nr, &io->src);
+
+                /* register source was captured at issue or broadcast, result goes to register file at write back */
+                (void)memset(&result, 0, sizeof(result));
+                if (access == LSQ_ACCESS_FORWARD)
+                {
+                    ++board.lsq.forwarded;
+                    result.val = val;
+                }
+                else if (io->dst.type == VAR_VREGISTER)
+                {
+                    do_vector_load(&vtmp, io->src.nr);
+                    result.vval = vtmp.val;
+                }
+                else if (io->src.type == VAR_VREGISTER)
+                {
+                    vtmp.val = io->val[DEPENDENCY_FROM_SRC1].vval;
+                    do_vector_store(io->dst.nr, &vtmp);
+                }
+                else if (io->dst.type == VAR_REGISTER)
+                    result.val = io->src.type == VAR_REGISTER ? io->val[DEPENDENCY_FROM_SRC1].val
+                                                              : variable_get_value(&io->src);
+                else if (io->dst.type == VAR_MEMORY && io->src.type == VAR_REGISTER)
+                    copy_value_to_memory(io->dst.nr, io->val[DEPENDENCY_FROM_SRC1].val);
                 else if (io->dst.type == VAR_MEMORY)
                     copy_data_to_memory(io->dst.nr, &io->src);
 
+                lsq_remove(io);
+                __rat_write_back(&io->dst, io->tag, &result);
+
                 /* operation complete lets notify dependency */
-                dependency_clear_and_prepare_work_io(io);
+                tag_broadcast(io->tag, trace_enabled() ? io_get_track(io) : 0, &result);
 
                 io->is->exec_cycle = current_cycle();
-                
+                if (trace_enabled())
+                {
+                    tomasulo_trace_instruction(io_get_track(io), io->is, "io", io->is->issue_cycle, io->is->exec_cycle);
+                    tomasulo_trace_instruction(io_get_track(io), io->is, "exec", io->is->start_cycle, io->is->exec_cycle);
+                }
+
+                tomasulo_retire(io->is);
                 reset_io(io);
                 io->state = STATE_FREE;
 
@@ -473,9 +1363,15 @@ static void execute_rsc(Reservation_station_chunk *rsc_array, size_t rsc_array_s
 {
     size_t i;
     Reservation_station_chunk *rsc;
+    Operand_value result;
+    Register_info r[DEPENDENCY_NR_OF_SLOT_RSC];
+    Vector_register_info vr[DEPENDENCY_NR_OF_SLOT_RSC];
 
     TRACE();
 
+    (void)memset(r, 0, sizeof(r));
+    (void)memset(vr, 0, sizeof(vr));
+
     for (i = 0; i < rsc_array_size; ++i)
     {
         rsc = &rsc_array[i];
@@ -486,34 +1382,59 @@ static void execute_rsc(Reservation_station_chunk *rsc_array, size_t rsc_array_s
             /* completed */
             if (rsc->wait_time == 0)
             {
+                board_switch_thread(rsc->is->thread);
+
+                /* units compute on operand values captured at issue or broadcast, not on register file */
+                (void)memset(&result, 0, sizeof(result));
                 switch (rsc->job)
                 {
                     case JOB_CMP:
                     {
                         LOG("Cmp JOB completed\n");
-                        do_cmp(&board.registers.regs[rsc->src1.nr],
-                               &board.registers.regs[rsc->src2.nr]);
+                        r[DEPENDENCY_FROM_SRC1].val = rsc->val[DEPENDENCY_FROM_SRC1].val;
+                        r[DEPENDENCY_FROM_SRC2].val = rsc->val[DEPENDENCY_FROM_SRC2].val;
+                        do_cmp(&r[DEPENDENCY_FROM_SRC1], &r[DEPENDENCY_FROM_SRC2]);
 
                         break;
                     }
                     case JOB_ARYTHMETIC:
                     {
                         LOG("Arythmetic JOB %d completed\n", rsc->aryth_type);
+                        r[DEPENDENCY_FROM_SRC1].val = rsc->val[DEPENDENCY_FROM_SRC1].val;
+                        r[DEPENDENCY_FROM_SRC2].val = rsc->val[DEPENDENCY_FROM_SRC2].val;
                         do_arythmetic(rsc->aryth_type,
-                                      &board.registers.regs[rsc->dst.nr],
-                                      &board.registers.regs[rsc->src1.nr],
-                                      &board.registers.regs[rsc->src2.nr]);
+                                      &r[DEPENDENCY_FROM_DST],
+                                      &r[DEPENDENCY_FROM_SRC1],
+                                      &r[DEPENDENCY_FROM_SRC2]);
+                        result.val = r[DEPENDENCY_FROM_DST].val;
+                        break;
+                    }
+                    case JOB_VECTOR:
+                    {
+                        LOG("Vector JOB %d completed\n", rsc->aryth_type);
+                        vr[DEPENDENCY_FROM_SRC1].val = rsc->val[DEPENDENCY_FROM_SRC1].vval;
+                        vr[DEPENDENCY_FROM_SRC2].val = rsc->val[DEPENDENCY_FROM_SRC2].vval;
+                        do_vector_arythmetic(rsc->aryth_type,
+                                             &vr[DEPENDENCY_FROM_DST],
+                                             &vr[DEPENDENCY_FROM_SRC1],
+                                             &vr[DEPENDENCY_FROM_SRC2]);
+                        result.vval = vr[DEPENDENCY_FROM_DST].val;
                         break;
                     }
                     default:
                         break;
                 }
 
+                __rat_write_back(&rsc->dst, rsc->tag, &result);
+
                 /* operation complete lets notify dependency */
-                dependency_clear_and_prepare_work_rsc(rsc);
+                tag_broadcast(rsc->tag, trace_enabled() ? rsc_get_track(rsc) : 0, &result);
 
                 rsc->is->exec_cycle = current_cycle();
+                if (trace_enabled())
+                    tomasulo_trace_instruction(rsc_get_track(rsc), rsc->is, "exec", rsc->is->start_cycle, rsc->is->exec_cycle);
 
+                tomasulo_retire(rsc->is);
                 reset_rsc(rsc);
                 rsc->state = STATE_FREE;
                 rsc->job = JOB_IDLE;
@@ -543,18 +1464,38 @@ static ___inline___ void execute_arythmetic(void)
 {
     TRACE();
 
-    execute_rsc((Reservation_station_chunk *)board.rs.add, RS_ADD_SUB_SIZE);
-    execute_rsc((Reservation_station_chunk *)board.rs.mul, RS_MUL_DIV_MOD_SIZE);
-    execute_rsc((Reservation_station_chunk *)&board.rs.cmp, 1);
+    dispatch_rsc((Reservation_station_chunk *)board.rs.add, RS_ADD_SUB_SIZE,
+                 (Functional_unit *)board.fu.add, FU_ADD_SUB_NUM, II_ADD_SUB, &board.fu.add_stalls);
+    dispatch_rsc((Reservation_station_chunk *)board.rs.mul, RS_MUL_DIV_MOD_SIZE,
+                 (Functional_unit *)board.fu.mul, FU_MUL_DIV_MOD_NUM, II_MUL_DIV_MOD, &board.fu.mul_stalls);
+    dispatch_rsc((Reservation_station_chunk *)&board.rs.cmp, 1,
+                 (Functional_unit *)board.fu.cmp, FU_CMP_NUM, II_CMP, &board.fu.cmp_stalls);
+    dispatch_rsc((Reservation_station_chunk *)board.rs.vec, RS_VECTOR_SIZE,
+                 (Functional_unit *)board.fu.vec, FU_VECTOR_NUM, II_VECTOR, &board.fu.vec_stalls);
+
+    execute_fu((Functional_unit *)board.fu.add, FU_ADD_SUB_NUM);
+    execute_fu((Functional_unit *)board.fu.mul, FU_MUL_DIV_MOD_NUM);
+    execute_fu((Functional_unit *)board.fu.cmp, FU_CMP_NUM);
+    execute_fu((Functional_unit *)board.fu.vec, FU_VECTOR_NUM);
 }
 
 static ___inline___ void execute(void)
 {
     TRACE();
 
+    lsq_update_stats();
+
+    PROFILE_BEGIN(PROFILE_EXECUTE_LOAD);
     execute_load();
+    PROFILE_END(PROFILE_EXECUTE_LOAD);
+
+    PROFILE_BEGIN(PROFILE_EXECUTE_ARYTHMETIC);
     execute_arythmetic();
+    PROFILE_END(PROFILE_EXECUTE_ARYTHMETIC);
+
+    PROFILE_BEGIN(PROFILE_EXECUTE_WRITE);
     execute_write();
+    PROFILE_END(PROFILE_EXECUTE_WRITE);
 }
 
 static ___inline___ void tomasulo_print(void)
@@ -565,9 +1506,13 @@ static ___inline___ void tomasulo_print(void)
     printf("Cycle = %" PRIu32 "\n", current_cycle());
     board_dump();
 
-    printf("Instructions\n");
+    printf("Instructions in flight\n");
     for_each_data(tomasulo_data.is_array, Darray, is)
     {
+        /* free status */
+        if (is->token == NULL)
+            continue;
+
         printf("Instruction:\t");
         token_print(is->token);
         printf("Issue cycle   = %" PRIu32 "\n", is->issue_cycle);
@@ -576,536 +1521,1566 @@ static ___inline___ void tomasulo_print(void)
     printf("\n");
 }
 
-static ___inline___ void tomasulo_init(void)
+static ___inline___ void tomasulo_init(const Tomasulo_options *options)
 {
     TRACE();
 
     (void)memset(&tomasulo_data, 0, sizeof(Tomasulo_data));
     tomasulo_data.is_array = darray_create(DARRAY_UNSORTED, 0, sizeof(Instructions_status *), NULL);
+    critical_path_init(&tomasulo_data.critical_path);
 
     reset_board();
+
+    if (options != NULL && options->trace_json != NULL)
+        tomasulo_trace_init(options->trace_json);
 }
 
-static ___inline___ void tomasulo_deinit(void)
+static void tomasulo_functional(Token **program, size_t num_instr, bool threaded)
 {
+    struct timespec start;
+    struct timespec end;
+    uint64_t executed;
+    double seconds;
+    Functional_program *fp = NULL;
+
     TRACE();
 
-    darray_destroy_with_entries(tomasulo_data.is_array, __is_destroy);
-}
+    if (threaded)
+    {
+        fp = functional_translate(program, num_instr);
+        if (fp == NULL)
+            FATAL("functional_translate error\n");
+    }
 
-static ___inline___ void tomasulo_next_cycle(void)
-{
-    TRACE();
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    if (threaded)
+        executed = functional_exec(fp, UINT64_MAX, false);
+    else
+        executed = functional_run(program, num_instr, UINT64_MAX, false);
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
 
-    ++current_cycle();
+    functional_program_destroy(fp);
+    seconds = timespec_diff(&start, &end);
+
+    board_dump();
+    printf("Functional run (%s)\n", threaded ? "threaded code" : "token switch");
+    printf("\tInstructions           %14" PRIu64 "\n", executed);
+    printf("\tHost time              %14.6lf s\n", seconds);
+    printf("\tInstructions / s       %14.0lf\n", seconds > 0.0 ? (double)executed / seconds : 0.0);
 }
 
-static ___inline___ Instructions_status *tomasulo_add_instruction_to_tracking(Token *token)
+static ___inline___ bool tomasulo_cycle(Token **program, size_t num_instr, uint64_t max_issue, uint64_t *issued)
 {
-    Instructions_status *is;
+    issue_outcome_t outcome;
 
     TRACE();
 
-    LOG("Add token to tracking\n");
-    token_dbg_print(token);
+    if (!((board.ctx->pc < num_instr && *issued < max_issue) || wait_for_unfinished_job()))
+        return false;
 
-    is = (Instructions_status *)malloc(sizeof(Instructions_status));
-    if (is == NULL)
-        FATAL("Malloc error\n");
+    PROFILE_BEGIN(PROFILE_FETCH);
+    if (board.ctx->pc < num_instr && *issued < max_issue)
+    {
+        outcome = issue_from_fetch_queue(program);
+        if (outcome == ISSUE_OK)
+            ++*issued;
+    }
+    else
+        outcome = ISSUE_DRAINED;
 
-    is->token = token;
-    is->exec_cycle = 0;
-    is->issue_cycle = current_cycle();
+    stats_count_issue(&tomasulo_data.stats, outcome);
 
-    darray_insert(tomasulo_data.is_array, (void *)&is);
+    /* fetched instructions can be issued in the next cycle */
+    fetch(program, num_instr);
+    PROFILE_END(PROFILE_FETCH);
+
+    execute();
+    return true;
+}
+
+static uint64_t tomasulo_run(Token **program, size_t num_instr, uint64_t max_issue, bool headless)
+{
+    uint64_t issued = 0;
+
+    TRACE();
+
+    while (tomasulo_cycle(program, num_instr, max_issue, &issued))
+    {
+        if (headless)
+        {
+            tomasulo_next_cycle();
+            continue;
+        }
+
+        PROFILE_BEGIN(PROFILE_PRINT);
+        tomasulo_print();
+        PROFILE_END(PROFILE_PRINT);
+
+        tomasulo_next_cycle();
+
+        printf("Type any key to go to next cycle\n");
+        getch();
+        reset_terminal();
+    }
+
+    return issued;
+}
+
+static uint64_t tomasulo_fast_forward(Token **program, size_t num_instr, uint64_t max_instr)
+{
+    Functional_program *fp;
+    uint64_t executed;
+
+    TRACE();
+
+    if (max_instr == 0)
+        return 0;
+
+    fp = functional_translate(program, num_instr);
+    if (fp == NULL)
+        FATAL("functional_translate error\n");
+
+    executed = functional_exec(fp, max_instr, true);
+    functional_program_destroy(fp);
+
+    front_end_reset();
+
+    return executed;
+}
+
+static int tomasulo_sampled(Token **program, size_t num_instr, const Tomasulo_options *options)
+{
+    Simpoint *sp;
+    size_t i;
+    uint64_t pos = 0;
+    uint32_t cycle;
+    struct timespec start;
+    struct timespec end;
+
+    TRACE();
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+
+    /* intervals are counted from the first instruction, so profile from initial state */
+    tomasulo_deinit();
+    tomasulo_init(options);
+
+    sp = simpoint_create(program, num_instr, options->sample_interval, options->sample_clusters);
+    if (sp == NULL)
+        ERROR("simpoint_create error\n", 1);
+
+    /* profile changed architectural state, start again */
+    tomasulo_deinit();
+    tomasulo_init(options);
+
+    for (i = 0; i < sp->num_samples; ++i)
+    {
+        pos += tomasulo_fast_forward(program, num_instr, sp->samples[i].start - pos);
+
+        cycle = current_cycle();
+        sp->samples[i].instr = tomasulo_run(program, num_instr, sp->samples[i].num_instr, true);
+        sp->samples[i].cycles = current_cycle() - cycle;
+
+        pos += sp->samples[i].instr;
+    }
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+    simpoint_print_estimate(sp);
+    printf("\tHost time              = %.6lf s\n", timespec_diff(&start, &end));
+
+    simpoint_destroy(sp);
+    return 0;
+}
+
+static void smt_fetch_order(smt_fetch_policy_t policy, uint32_t *order)
+{
+    uint32_t i;
+    uint32_t j;
+    uint32_t t;
+    uint32_t n = (uint32_t)board.num_threads;
+
+    TRACE();
+
+    /* round robin, start after thread which issued last */
+    for (i = 0; i < n; ++i)
+        order[i] = (tomasulo_data.last_fetch + 1 + i) % n;
+
+    if (policy != SMT_FETCH_ICOUNT)
+        return;
+
+    /* ICOUNT, the fewest instructions in flight first, ties keep round robin order */
+    for (i = 1; i < n; ++i)
+    {
+        t = order[i];
+        for (j = i; j > 0 && tomasulo_data.inflight[order[j - 1]] > tomasulo_data.inflight[t]; --j)
+            order[j] = order[j - 1];
+
+        order[j] = t;
+    }
+}
+
+static bool tomasulo_smt_cycle(Token ***programs, const size_t *num_instr, smt_fetch_policy_t policy)
+{
+    uint32_t order[SMT_THREADS_MAX] = {0};
+    issue_outcome_t outcome = ISSUE_DRAINED;
+    issue_outcome_t thread_outcome;
+    bool running = false;
+    uint32_t i;
+    uint32_t t;
+
+    TRACE();
+
+    for (t = 0; t < board.num_threads; ++t)
+        if (board.thread[t].pc < num_instr[t])
+            running = true;
+
+    if (!running && !wait_for_unfinished_job())
+        return false;
+
+    PROFILE_BEGIN(PROFILE_FETCH);
+    smt_fetch_order(policy, order);
+    for (i = 0; i < board.num_threads; ++i)
+    {
+        t = order[i];
+        if (board.thread[t].pc >= num_instr[t])
+            continue;
+
+        /* stalled issue has no side effects, so try next thread */
+        board_switch_thread(t);
+        thread_outcome = issue_from_fetch_queue(programs[t]);
+        if (outcome == ISSUE_DRAINED)
+            outcome = thread_outcome;
+
+        if (thread_outcome == ISSUE_OK)
+        {
+            outcome = ISSUE_OK;
+            tomasulo_data.last_fetch = t;
+            break;
+        }
+    }
+
+    stats_count_issue(&tomasulo_data.stats, outcome);
+
+    /* front end of one thread fetches per cycle, the first one by policy which has space in queue */
+    for (i = 0; i < board.num_threads - 1; ++i)
+        if (board.fetch_queue[order[i]].num_entries < FETCH_QUEUE_SIZE && board.fetch_queue[order[i]].fetch_pc < num_instr[order[i]])
+            break;
+
+    board_switch_thread(order[i]);
+    fetch(programs[order[i]], num_instr[order[i]]);
+    PROFILE_END(PROFILE_FETCH);
+
+    execute();
+    return true;
+}
+
+static void tomasulo_core_step(Tomasulo_core *core, uint32_t quantum)
+{
+    uint32_t i;
+
+    if (core->finished)
+        return;
+
+    current_board = &core->arch;
+    current_data = &core->data;
+
+    for (i = 0; i < quantum; ++i)
+    {
+        if (!tomasulo_cycle(core->program, core->num_instr, UINT64_MAX, &core->issued))
+        {
+            core->finished = true;
+            return;
+        }
+
+        tomasulo_next_cycle();
+    }
+}
+
+static void tomasulo_multicore_commit(Tomasulo_multicore *mc)
+{
+    size_t i;
+
+    mc->finished = true;
+    for (i = 0; i < mc->num_cores; ++i)
+    {
+        /* same order in every run, so the last core wins write-write race */
+        ram_store_buffer_commit(mc->core[i].stores, &mc->ram);
+        if (!mc->core[i].finished)
+            mc->finished = false;
+    }
+}
+
+static void *tomasulo_core_thread(void *arg)
+{
+    Tomasulo_thread *thread = (Tomasulo_thread *)arg;
+    Tomasulo_multicore *mc = thread->mc;
+    size_t i;
+
+    do {
+        for (i = thread->id; i < mc->num_cores; i += mc->num_threads)
+            tomasulo_core_step(&mc->core[i], mc->quantum);
+
+        if (pthread_barrier_wait(&mc->barrier) == PTHREAD_BARRIER_SERIAL_THREAD)
+            tomasulo_multicore_commit(mc);
+
+        (void)pthread_barrier_wait(&mc->barrier);
+    } while (!mc->finished);
+
+    PROFILE_MERGE();
+
+    return NULL;
+}
+
+static ___inline___ double timespec_diff(const struct timespec *start, const struct timespec *end)
+{
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void tomasulo_trace_init(const char *path)
+{
+    size_t i;
+    size_t j;
+    char name[INSTRUCTION_NAME_SIZE];
+
+    TRACE();
+
+    tomasulo_data.trace = trace_create(path);
+    if (tomasulo_data.trace == NULL)
+    {
+        fprintf(stderr, "Cannot create trace %s\n", path);
+        return;
+    }
+
+    trace_track_name(tomasulo_data.trace, TRACK_BRANCH, "Branch");
+
+    for (i = 0; i < LOAD_BUFFER_SIZE; ++i)
+    {
+        (void)snprintf(name, sizeof(name), "Load buffer %zu", i);
+        trace_track_name(tomasulo_data.trace, io_get_track(&board.load_buffer.load[i]), name);
+    }
+
+    for (i = 0; i < WRITE_BUFFER_SIZE; ++i)
+    {
+        (void)snprintf(name, sizeof(name), "Write buffer %zu", i);
+        trace_track_name(tomasulo_data.trace, io_get_track(&board.write_buffer.write[i]), name);
+    }
+
+    for (i = 0; i < RS_ADD_SUB_SIZE; ++i)
+    {
+        (void)snprintf(name, sizeof(name), "RS ADD-SUB %zu", i);
+        trace_track_name(tomasulo_data.trace, rsc_get_track(&board.rs.add[i]), name);
+    }
+
+    for (i = 0; i < RS_MUL_DIV_MOD_SIZE; ++i)
+    {
+        (void)snprintf(name, sizeof(name), "RS MUL-DIV-MOD %zu", i);
+        trace_track_name(tomasulo_data.trace, rsc_get_track(&board.rs.mul[i]), name);
+    }
+
+    trace_track_name(tomasulo_data.trace, rsc_get_track(&board.rs.cmp), "RS CMP");
+
+    for (i = 0; i < RS_VECTOR_SIZE; ++i)
+    {
+        (void)snprintf(name, sizeof(name), "RS VECTOR %zu", i);
+        trace_track_name(tomasulo_data.trace, rsc_get_track(&board.rs.vec[i]), name);
+    }
+
+    for (i = 0; i < FU_ADD_SUB_NUM; ++i)
+        for (j = 0; j < FU_PIPELINE_DEPTH; ++j)
+        {
+            (void)snprintf(name, sizeof(name), "FU ADD-SUB %zu.%zu", i, j);
+            trace_track_name(tomasulo_data.trace, rsc_get_track(&board.fu.add[i].pipeline[j]), name);
+        }
+
+    for (i = 0; i < FU_MUL_DIV_MOD_NUM; ++i)
+        for (j = 0; j < FU_PIPELINE_DEPTH; ++j)
+        {
+            (void)snprintf(name, sizeof(name), "FU MUL-DIV-MOD %zu.%zu", i, j);
+            trace_track_name(tomasulo_data.trace, rsc_get_track(&board.fu.mul[i].pipeline[j]), name);
+        }
+
+    for (i = 0; i < FU_CMP_NUM; ++i)
+        for (j = 0; j < FU_PIPELINE_DEPTH; ++j)
+        {
+            (void)snprintf(name, sizeof(name), "FU CMP %zu.%zu", i, j);
+            trace_track_name(tomasulo_data.trace, rsc_get_track(&board.fu.cmp[i].pipeline[j]), name);
+        }
+
+    for (i = 0; i < FU_VECTOR_NUM; ++i)
+        for (j = 0; j < FU_PIPELINE_DEPTH; ++j)
+        {
+            (void)snprintf(name, sizeof(name), "FU VECTOR %zu.%zu", i, j);
+            trace_track_name(tomasulo_data.trace, rsc_get_track(&board.fu.vec[i].pipeline[j]), name);
+        }
+}
+
+static uint32_t rsc_get_track(const Reservation_station_chunk *rsc)
+{
+    size_t i;
+
+    if (rsc >= board.rs.add && rsc < board.rs.add + RS_ADD_SUB_SIZE)
+        return TRACK_RS_ADD_SUB + (uint32_t)(rsc - board.rs.add);
+
+    if (rsc >= board.rs.mul && rsc < board.rs.mul + RS_MUL_DIV_MOD_SIZE)
+        return TRACK_RS_MUL_DIV_MOD + (uint32_t)(rsc - board.rs.mul);
+
+    if (rsc == &board.rs.cmp)
+        return TRACK_RS_CMP;
+
+    if (rsc >= board.rs.vec && rsc < board.rs.vec + RS_VECTOR_SIZE)
+        return TRACK_RS_VECTOR + (uint32_t)(rsc - board.rs.vec);
+
+    for (i = 0; i < FU_ADD_SUB_NUM; ++i)
+        if (rsc >= board.fu.add[i].pipeline && rsc < board.fu.add[i].pipeline + FU_PIPELINE_DEPTH)
+            return TRACK_FU_ADD_SUB + (uint32_t)(i * FU_PIPELINE_DEPTH) + (uint32_t)(rsc - board.fu.add[i].pipeline);
+
+    for (i = 0; i < FU_MUL_DIV_MOD_NUM; ++i)
+        if (rsc >= board.fu.mul[i].pipeline && rsc < board.fu.mul[i].pipeline + FU_PIPELINE_DEPTH)
+            return TRACK_FU_MUL_DIV_MOD + (uint32_t)(i * FU_PIPELINE_DEPTH) + (uint32_t)(rsc - board.fu.mul[i].pipeline);
+
+    for (i = 0; i < FU_CMP_NUM; ++i)
+        if (rsc >= board.fu.cmp[i].pipeline && rsc < board.fu.cmp[i].pipeline + FU_PIPELINE_DEPTH)
+            return TRACK_FU_CMP + (uint32_t)(i * FU_PIPELINE_DEPTH) + (uint32_t)(rsc - board.fu.cmp[i].pipeline);
+
+    for (i = 0; i < FU_VECTOR_NUM; ++i)
+        if (rsc >= board.fu.vec[i].pipeline && rsc < board.fu.vec[i].pipeline + FU_PIPELINE_DEPTH)
+            return TRACK_FU_VECTOR + (uint32_t)(i * FU_PIPELINE_DEPTH) + (uint32_t)(rsc - board.fu.vec[i].pipeline);
+
+    return 0;
+}
+
+static uint32_t io_get_track(const IO_info *io)
+{
+    if (io >= board.load_buffer.load && io < board.load_buffer.load + LOAD_BUFFER_SIZE)
+        return TRACK_LOAD + (uint32_t)(io - board.load_buffer.load);
+
+    return TRACK_WRITE + (uint32_t)(io - board.write_buffer.write);
+}
+
+static void tomasulo_trace_instruction(uint32_t track, const Instructions_status *is, const char *cat, uint32_t start, uint32_t end)
+{
+    char name[INSTRUCTION_NAME_SIZE];
+
+    (void)token_snprint(name, sizeof(name), is->token);
+    trace_slice(tomasulo_data.trace, track, name, cat, start, (uint64_t)(end - start) + 1);
+}
+
+static ___inline___ void tomasulo_deinit(void)
+{
+    TRACE();
+
+    trace_destroy(tomasulo_data.trace);
+    darray_destroy_with_entries(tomasulo_data.is_array, __is_destroy);
+    critical_path_deinit(&tomasulo_data.critical_path);
+    deinit_board();
+}
+
+static ___inline___ void tomasulo_next_cycle(void)
+{
+    TRACE();
+
+    ++current_cycle();
+}
+
+static ___inline___ Instructions_status *tomasulo_add_instruction_to_tracking(Token *token, int32_t latency)
+{
+    Instructions_status *is;
+
+    TRACE();
+
+    LOG("Add token to tracking\n");
+    token_dbg_print(token);
+
+    /* statuses are recycled at retire, so pool is as big as the most instructions in flight */
+    if (tomasulo_data.is_free != NULL)
+    {
+        is = tomasulo_data.is_free;
+        tomasulo_data.is_free = is->next;
+    }
+    else
+    {
+        is = (Instructions_status *)malloc(sizeof(Instructions_status));
+        if (is == NULL)
+            FATAL("Malloc error\n");
+
+        darray_insert(tomasulo_data.is_array, (void *)&is);
+    }
+
+    is->id = tomasulo_data.next_id++;
+    is->thread = board_current_thread();
+    ++tomasulo_data.inflight[is->thread];
+    is->token = token;
+    is->exec_cycle = 0;
+    is->issue_cycle = current_cycle();
+    is->latency = latency;
+    is->started = false;
+    is->start_cycle = 0;
+    is->next = NULL;
+
+    /* jump is resolved at issue, other jobs take wait time + 1 cycles */
+    critical_path_issue(&tomasulo_data.critical_path, is, token->type == TOKEN_JUMP ? 0 : (uint32_t)latency + 1);
 
     return is;
 }
 
-static ___inline___ void setup_work(Worker *worker)
-{
-    TRACE();
-    switch (worker->type)
+static ___inline___ void tomasulo_retire(Instructions_status *is)
+{
+    TRACE();
+
+    critical_path_retire(&tomasulo_data.critical_path, is);
+    stats_count_retire(&tomasulo_data.stats, is->token, is->issue_cycle, is->exec_cycle);
+    ++tomasulo_data.retired[is->thread];
+    --tomasulo_data.inflight[is->thread];
+
+    is->token = NULL;
+    is->next = tomasulo_data.is_free;
+    tomasulo_data.is_free = is;
+}
+
+static ___inline___ Rat_entry *__rat_entry(const Variable *var)
+{
+    if (var->type == VAR_REGISTER)
+        return &board.ctx->rat.entry[var->nr];
+
+    if (var->type == VAR_VREGISTER && var->nr < VREGISTERS_NUM)
+        return &board.ctx->rat.ventry[var->nr];
+
+    return NULL;
+}
+
+static ___inline___ void __rat_read(const Variable *var, dependency_slot_t slot, tag_t *wait_tag, Operand_value *val)
+{
+    const Rat_entry *e;
+
+    TRACE();
+
+    /* rename only registers */
+    if ((e = __rat_entry(var)) == NULL)
+        return;
+
+    if (e->writer != TAG_NONE)
+    {
+        LOG("R%" PRIu32 " is written by tag %" PRIu64 ", wait in slot %d\n", var->nr, e->writer, slot);
+        wait_tag[slot] = e->writer;
+        return;
+    }
+
+    if (var->type == VAR_REGISTER)
+        val[slot].val = board.ctx->registers.regs[var->nr].val;
+    else
+        val[slot].vval = board.ctx->registers.vregs[var->nr].val;
+}
+
+static Register_info *__rat_write(const Variable *var, tag_t tag, job_t job)
+{
+    Rat_entry *e;
+    Register_info *r;
+    Vector_register_info *vr;
+
+    TRACE();
+
+    if ((e = __rat_entry(var)) == NULL)
+        return NULL;
+
+    e->writer = tag;
+
+    if (var->type == VAR_REGISTER)
+    {
+        r = &board.ctx->registers.regs[var->nr];
+
+        LOG("R%" PRIu32 " written by tag %" PRIu64 " job %d\n", r->nr, tag, job);
+        r->state = STATE_BUSY;
+        r->job = job;
+
+        return r;
+    }
+
+    vr = &board.ctx->registers.vregs[var->nr];
+
+    LOG("V%" PRIu32 " written by tag %" PRIu64 " job %d\n", vr->nr, tag, job);
+    vr->state = STATE_BUSY;
+    vr->job = job;
+
+    return NULL;
+}
+
+static ___inline___ void __rat_write_back(const Variable *var, tag_t tag, const Operand_value *result)
+{
+    Rat_entry *e;
+    Vector_register_info *vr;
+
+    TRACE();
+
+    /* younger writer has renamed register, its readers wait for it */
+    if ((e = __rat_entry(var)) == NULL || e->writer != tag)
+        return;
+
+    e->writer = TAG_NONE;
+
+    if (var->type == VAR_REGISTER)
+    {
+        copy_value_to_reg(var->nr, result->val);
+        return;
+    }
+
+    vr = &board.ctx->registers.vregs[var->nr];
+    vr->val = result->vval;
+    vr->state = STATE_FREE;
+    vr->job = JOB_IDLE;
+}
+
+static void rat_rename_rsc(Reservation_station_chunk *rsc)
+{
+    Register_info *r;
+
+    TRACE();
+
+    rsc->tag = rsc->is->id + 1;
+
+    /* sources first, instruction can read register which it writes */
+    __rat_read(&rsc->src1, DEPENDENCY_FROM_SRC1, rsc->wait_tag, rsc->val);
+    __rat_read(&rsc->src2, DEPENDENCY_FROM_SRC2, rsc->wait_tag, rsc->val);
+    if ((r = __rat_write(&rsc->dst, rsc->tag, rsc->job)) != NULL)
+        r->aryth_type = rsc->aryth_type;
+}
+
+static void rat_rename_io(IO_info *io)
+{
+    TRACE();
+
+    io->tag = io->is->id + 1;
+
+    __rat_read(&io->src, DEPENDENCY_FROM_SRC1, io->wait_tag, io->val);
+    (void)__rat_write(&io->dst, io->tag, io->job);
+}
+
+static ___inline___ Variable rsc_register_operand(const Variable *var)
+{
+    Variable reg = *var;
+
+    reg.type = VAR_REGISTER;
+
+    return reg;
+}
+
+static ___inline___ bool jump_predict_taken(const Token_jump *tjump, program_counter_t pc)
+{
+    return tjump->line <= pc;
+}
+
+static bool loop_buffer_capture(Loop_buffer *lb, Token **program, program_counter_t pc)
+{
+    const program_counter_t start = program[pc]->token_jump.line;
+    program_counter_t i;
+
+    TRACE();
+
+    if (lb->candidate != pc)
+    {
+        lb->candidate = pc;
+        return false;
+    }
+
+    if (pc - start + 1 > LOOP_BUFFER_SIZE)
+        return false;
+
+    for (i = start; i < pc; ++i)
+        if (program[i]->type == TOKEN_JUMP)
+            return false;
+
+    for (i = start; i <= pc; ++i)
+        decode(program[i], &lb->uop[i - start]);
+
+    LOG("Loop PC %lu - %lu captured in loop buffer\n", start, pc);
+    lb->start = start;
+    lb->end = pc;
+    lb->active = true;
+
+    return true;
+}
+
+static void fetch(Token **program, size_t num_instr)
+{
+    Fetch_queue *fq = &board.fetch_queue[board_current_thread()];
+    Loop_buffer *lb = &board.loop_buffer[board_current_thread()];
+    const bool full = fq->num_entries == FETCH_QUEUE_SIZE;
+    const Token *token;
+    program_counter_t pc;
+    uint64_t fetched = 0;
+    uint64_t streamed = 0;
+
+    TRACE();
+
+    while (fetched < FETCH_WIDTH && fq->num_entries < FETCH_QUEUE_SIZE && fq->fetch_pc < num_instr)
+    {
+        pc = fq->fetch_pc;
+        fq->pc[(fq->head + fq->num_entries) % FETCH_QUEUE_SIZE] = pc;
+        ++fq->num_entries;
+        ++fetched;
+
+        if (lb->active && pc >= lb->start && pc <= lb->end)
+        {
+            /* loop is already decoded, stream it across loop closing jump */
+            ++streamed;
+            fq->fetch_pc = pc == lb->end ? lb->start : pc + 1;
+            continue;
+        }
+
+        token = program[pc];
+        if (token->type == TOKEN_JUMP && jump_predict_taken(&token->token_jump, pc))
+        {
+            (void)loop_buffer_capture(lb, program, pc);
+
+            /* taken jump ends fetch in this cycle */
+            fq->fetch_pc = token->token_jump.line;
+            break;
+        }
+
+        fq->fetch_pc = pc + 1;
+    }
+
+    stats_count_fetch(&tomasulo_data.stats, fetched, streamed, fq->num_entries, full);
+}
+
+static ___inline___ void front_end_reset(void)
+{
+    Fetch_queue *fq = &board.fetch_queue[board_current_thread()];
+
+    TRACE();
+
+    fq->num_entries = 0;
+    fq->fetch_pc = board.ctx->pc;
+    board.loop_buffer[board_current_thread()].active = false;
+}
+
+static issue_outcome_t issue_from_fetch_queue(Token **program)
+{
+    Fetch_queue *fq = &board.fetch_queue[board_current_thread()];
+    Loop_buffer *lb = &board.loop_buffer[board_current_thread()];
+    const program_counter_t pc = board.ctx->pc;
+    const Uop *uop;
+    Uop decoded;
+    issue_outcome_t outcome;
+
+    TRACE();
+
+    if ((fq->num_entries > 0 && fq->pc[fq->head] != board.ctx->pc) ||
+        (fq->num_entries == 0 && fq->fetch_pc != board.ctx->pc))
+    {
+        LOG("Fetch queue holds wrong path, redirect fetch to PC %lu\n", board.ctx->pc);
+        fq->num_entries = 0;
+        fq->fetch_pc = board.ctx->pc;
+        stats_count_redirect(&tomasulo_data.stats);
+
+        if (lb->active && (pc < lb->start || pc > lb->end))
+        {
+            LOG("Loop exited, loop buffer released\n");
+            lb->active = false;
+        }
+    }
+
+    if (fq->num_entries == 0)
+    {
+        LOG("Fetch queue is empty, waiting\n");
+        return ISSUE_STALL_FETCH;
+    }
+
+    /* instructions of captured loop are already decoded */
+    if (lb->active && pc >= lb->start && pc <= lb->end)
+        uop = &lb->uop[pc - lb->start];
+    else
+    {
+        decode(program[pc], &decoded);
+        uop = &decoded;
+    }
+
+    outcome = issue(uop);
+    if (outcome == ISSUE_OK)
+    {
+        fq->head = (fq->head + 1) % FETCH_QUEUE_SIZE;
+        --fq->num_entries;
+    }
+
+    return outcome;
+}
+
+static void decode(Token *token, Uop *uop)
+{
+    TRACE();
+
+    (void)memset(uop, 0, sizeof(*uop));
+    uop->token = token;
+
+    switch (token->type)
+    {
+        case TOKEN_JUMP:
+        {
+            uop->unit = UOP_JUMP;
+            break;
+        }
+        case TOKEN_CMP:
+        {
+            uop->unit = UOP_CMP;
+            uop->job = JOB_CMP;
+            uop->latency = CYCLES_CMP;
+            break;
+        }
+        case TOKEN_ARYTHMETIC:
+        {
+            uop->job = JOB_ARYTHMETIC;
+            uop->aryth_type = token->token_arythmetic.type;
+            switch (token->token_arythmetic.type)
+            {
+                case OP_ADD:
+                case OP_SUB:
+                {
+                    uop->unit = UOP_ADD_SUB;
+                    uop->latency = CYCLES_ADD;
+                    break;
+                }
+                case OP_MUL:
+                {
+                    uop->unit = UOP_MUL_DIV_MOD;
+                    uop->latency = CYCLES_MUL;
+                    break;
+                }
+                case OP_DIV:
+                {
+                    uop->unit = UOP_MUL_DIV_MOD;
+                    uop->latency = CYCLES_DIV;
+                    break;
+                }
+                case OP_MOD:
+                {
+                    uop->unit = UOP_MUL_DIV_MOD;
+                    uop->latency = CYCLES_MOD;
+                    break;
+                }
+                default:
+                    break;
+            }
+            break;
+        }
+        case TOKEN_MOVE:
+        {
+            /* latency of memory access depends on caches, so it is known at issue */
+            uop->unit = token->token_move.dst.type == VAR_REGISTER ? UOP_LOAD : UOP_STORE;
+            uop->job = uop->unit == UOP_LOAD ? JOB_LOAD : JOB_STORE;
+            break;
+        }
+        case TOKEN_VECTOR:
+        {
+            switch (token->token_vector.type)
+            {
+                case VOP_ADD:
+                case VOP_MUL:
+                {
+                    uop->unit = UOP_VECTOR;
+                    uop->job = JOB_VECTOR;
+                    uop->aryth_type = token->token_vector.type == VOP_ADD ? OP_ADD : OP_MUL;
+                    uop->latency = token->token_vector.type == VOP_ADD ? CYCLES_VADD : CYCLES_VMUL;
+                    break;
+                }
+                /* vector memory access goes through IO buffers like move */
+                case VOP_LOAD:
+                {
+                    uop->unit = UOP_LOAD;
+                    uop->job = JOB_LOAD;
+                    break;
+                }
+                case VOP_STORE:
+                {
+                    uop->unit = UOP_STORE;
+                    uop->job = JOB_STORE;
+                    break;
+                }
+                default:
+                    break;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+static issue_outcome_t issue(const Uop *uop)
+{
+    TRACE();
+
+    Token *token = uop->token;
+    const Token_move *tmove;
+    const Token_cmp *tcmp;
+    const Token_jump *tjump;
+    const Token_arythmetic *taryth;
+    const Token_vector *tvector;
+    Reservation_station_chunk *rsc;
+    IO_info *io;
+    Instructions_status *is;
+    issue_outcome_t outcome = ISSUE_OK;
+
+    switch (uop->unit)
+    {
+        case UOP_JUMP:
+        {
+            LOG("Token jump fetched\n");
+
+            tjump = (Token_jump *)&token->token_jump;
+            if (!is_cmp_pending(board_current_thread())) /* cmp flag is set correctly */
+            {
+                LOG("Cmp rsc is free, so jump now\n");
+                do_jump(tjump->type, tjump->line);
+                is = tomasulo_add_instruction_to_tracking(token, 0);
+                is->exec_cycle = current_cycle();
+                if (trace_enabled())
+                    tomasulo_trace_instruction(TRACK_BRANCH, is, "jump", is->issue_cycle, is->exec_cycle);
+
+                tomasulo_retire(is);
+            }
+            else
+            {
+                LOG("Cmp rsc busy, waiting\n");
+                outcome = ISSUE_STALL_BRANCH;
+            }
+            break;
+        }
+        case UOP_CMP:
+        {
+            LOG("Token cmp fetched\n");
+            tcmp = (Token_cmp *)&token->token_cmp;
+            if (!is_rsc_cmp_busy())
+            {
+                LOG("Cmp rsc free, setup work\n");
+                rsc = get_first_free_cmp();
+
+                /* set cmp job */
+                rsc->state = STATE_BUSY;
+                rsc->job = uop->job;
+                rsc->wait_time = uop->latency;
+                rsc->src1 = rsc_register_operand(&tcmp->src1);
+                rsc->src2 = rsc_register_operand(&tcmp->src2);
+                rsc->is = tomasulo_add_instruction_to_tracking(token, rsc->wait_time);
+
+                rat_rename_rsc(rsc);
+
+                go_to_next_instruction();
+            }
+            else
+            {
+                LOG("Cmp rsc busy, waiting\n");
+                outcome = ISSUE_STALL_RS_CMP;
+            }
+
+            break;
+        }
+        case UOP_ADD_SUB:
+        case UOP_MUL_DIV_MOD:
+        {
+            taryth = (Token_arythmetic *)&token->token_arythmetic;
+            LOG("Token arythmetic fetched %d\n", taryth->type);
+
+            if (uop->unit == UOP_ADD_SUB ? is_rsc_add_sub_busy() : is_rsc_mul_div_mod_busy())
+            {
+                LOG("Arythmetic rsc busy, waiting\n");
+                outcome = uop->unit == UOP_ADD_SUB ? ISSUE_STALL_RS_ADD_SUB : ISSUE_STALL_RS_MUL_DIV_MOD;
+                break;
+            }
+
+            LOG("Arythmetic rsc is free, setup work\n");
+            rsc = uop->unit == UOP_ADD_SUB ? get_first_free_add_sub() : get_first_free_mul_div_mod();
+
+            /* set job */
+            rsc->state = STATE_BUSY;
+            rsc->job = uop->job;
+            rsc->aryth_type = uop->aryth_type;
+            rsc->wait_time = uop->latency;
+            rsc->dst = rsc_register_operand(&taryth->dst);
+            rsc->src1 = rsc_register_operand(&taryth->src1);
+            rsc->src2 = rsc_register_operand(&taryth->src2);
+            rsc->is = tomasulo_add_instruction_to_tracking(token, rsc->wait_time);
+
+            rat_rename_rsc(rsc);
+
+            go_to_next_instruction();
+            break;
+        }
+        case UOP_VECTOR:
+        {
+            tvector = (Token_vector *)&token->token_vector;
+            LOG("Token vector fetched %d\n", tvector->type);
+
+            if (is_rsc_vector_busy())
+            {
+                LOG("Vector rsc busy, waiting\n");
+                outcome = ISSUE_STALL_RS_VECTOR;
+                break;
+            }
+
+            LOG("Vector rsc is free, setup work\n");
+            rsc = get_first_free_vector();
+
+            /* set job */
+            rsc->state = STATE_BUSY;
+            rsc->job = uop->job;
+            rsc->aryth_type = uop->aryth_type;
+            rsc->wait_time = uop->latency;
+            rsc->dst = tvector->dst;
+            rsc->src1 = tvector->src1;
+            rsc->src2 = tvector->src2;
+            rsc->is = tomasulo_add_instruction_to_tracking(token, rsc->wait_time);
+
+            rat_rename_rsc(rsc);
+
+            go_to_next_instruction();
+            break;
+        }
+        case UOP_LOAD:
+        case UOP_STORE:
+        {
+            LOG("Token move fetched\n");
+            if (uop->unit == UOP_LOAD ? is_io_load_busy() : is_io_write_busy())
+            {
+                LOG("IO buffer busy, waiting\n");
+                outcome = uop->unit == UOP_LOAD ? ISSUE_STALL_LOAD_BUFFER : ISSUE_STALL_STORE_BUFFER;
+                break;
+            }
+
+            LOG("IO buffer free, setup work\n");
+            io = uop->unit == UOP_LOAD ? get_first_free_io_load() : get_first_free_io_write();
+            if (token->type == TOKEN_VECTOR)
+            {
+                tvector = (Token_vector *)&token->token_vector;
+                io->dst = tvector->dst;
+                io->src = tvector->src1;
+            }
+            else
+            {
+                tmove = (Token_move *)&token->token_move;
+                io->dst = tmove->dst;
+                io->src = tmove->src;
+            }
+            io->state = STATE_BUSY;
+            io->job = uop->job;
+            io->wait_time = io_get_time(io);
+
+            io->is = tomasulo_add_instruction_to_tracking(token, io->wait_time);
+            lsq_insert(io);
+
+            rat_rename_io(io);
+
+            go_to_next_instruction();
+            break;
+        }
+        default:
+            break;
+    }
+
+    return outcome;
+}
+
+static ___inline___ bool wait_for_unfinished_job(void)
+{
+    TRACE();
+
+    size_t t;
+    for (t = 0; t < board.num_threads; ++t)
+        if (tomasulo_data.inflight[t] > 0)
+            return true;
+
+    return board.lsq.num_entries > 0;
+}
+
+int tomasulo(Token **program, size_t num_instr, const Tomasulo_options *options)
+{
+    int ret = 0;
+    bool headless = options != NULL && options->headless;
+    struct timespec start;
+    struct timespec end;
+    uint64_t ff;
+
+    TRACE();
+
+    LOG("Init tomasulo\n");
+    tomasulo_init(options);
+    if (options != NULL && options->trace_json != NULL && tomasulo_data.trace == NULL)
+    {
+        tomasulo_deinit();
+        return 1;
+    }
+
+    if (options != NULL && options->functional)
+    {
+        tomasulo_functional(program, num_instr, !options->functional_switch);
+        if (options->arch_dump)
+            board_dump_arch();
+
+        tomasulo_deinit();
+        return 0;
+    }
+
+    /* architectural state is on board, so tomasulo just continues from board.ctx->pc */
+    if (options != NULL && options->fast_forward > 0)
+    {
+        (void)clock_gettime(CLOCK_MONOTONIC, &start);
+        ff = tomasulo_fast_forward(program, num_instr, options->fast_forward);
+        (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+        printf("Fast-forwarded %" PRIu64 " instructions in %.6lf s, PC = %lu\n",
+               ff, timespec_diff(&start, &end), board.ctx->pc);
+    }
+
+    if (options != NULL && options->sample_interval > 0)
+    {
+        ret = tomasulo_sampled(program, num_instr, options);
+        tomasulo_deinit();
+        return ret;
+    }
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    (void)tomasulo_run(program, num_instr, UINT64_MAX, headless);
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (!headless)
+        tomasulo_print();
+
+    stats_print_host(&tomasulo_data.stats, current_cycle(), timespec_diff(&start, &end));
+    stats_print_issue(&tomasulo_data.stats);
+    stats_print_fetch(&tomasulo_data.stats, current_cycle());
+    stats_print_retire(&tomasulo_data.stats, current_cycle());
+    critical_path_print(&tomasulo_data.critical_path, current_cycle());
+
+    if (options != NULL && options->arch_dump)
+        board_dump_arch();
+
+    if (options != NULL && options->stats_csv != NULL)
+        if (stats_write_csv(&tomasulo_data.stats, options->stats_csv, current_cycle()))
+        {
+            fprintf(stderr, "Cannot write statistics to %s\n", options->stats_csv);
+            ret = 1;
+        }
+
+    LOG("Deinit tomasulo\n");
+    tomasulo_deinit();
+    return ret;
+}
+
+int tomasulo_multicore(Token ***programs, const size_t *num_instr, size_t num_cores, const Tomasulo_options *options)
+{
+    Tomasulo_multicore mc;
+    Tomasulo_thread *threads;
+    Board *saved_board = current_board;
+    Tomasulo_data *saved_data = current_data;
+    bool headless = options != NULL && options->headless;
+    struct timespec start;
+    struct timespec end;
+    double seconds;
+    uint64_t instr = 0;
+    uint32_t cycles = 0;
+    uint64_t retired;
+    size_t i;
+
+    TRACE();
+
+    if (programs == NULL || num_instr == NULL || num_cores == 0)
+        ERROR("Incorrect cores\n", 1);
+
+    (void)memset(&mc, 0, sizeof(mc));
+    mc.num_cores = num_cores;
+    mc.num_threads = options != NULL && options->threads > 0 ? options->threads : num_cores;
+    mc.quantum = options != NULL && options->quantum > 0 ? options->quantum : 1;
+    if (mc.num_threads > num_cores)
+        mc.num_threads = num_cores;
+
+    mc.core = (Tomasulo_core *)calloc(num_cores, sizeof(Tomasulo_core));
+    if (mc.core == NULL)
+        ERROR("calloc error\n", 1);
+
+    threads = (Tomasulo_thread *)calloc(mc.num_threads, sizeof(Tomasulo_thread));
+    if (threads == NULL)
+    {
+        FREE(mc.core);
+        ERROR("calloc error\n", 1);
+    }
+
+    for (i = 0; i < num_cores; ++i)
+    {
+        mc.core[i].program = programs[i];
+        mc.core[i].num_instr = num_instr[i];
+        mc.core[i].stores = ram_store_buffer_create();
+        if (mc.core[i].stores == NULL)
+            FATAL("ram_store_buffer_create error\n");
+
+        current_board = &mc.core[i].arch;
+        current_data = &mc.core[i].data;
+
+        /* trace has tracks of one core only */
+        tomasulo_init(NULL);
+        board_share_ram(&mc.ram, mc.core[i].stores);
+    }
+
+    if (pthread_barrier_init(&mc.barrier, NULL, (unsigned)mc.num_threads))
+        FATAL("pthread_barrier_init error\n");
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+
+    /* caller is thread 0 */
+    for (i = 0; i < mc.num_threads; ++i)
     {
-        case WORKER_IO:
-        {
-            __setup_work(&worker->io->dst, worker, DEPENDENCY_FROM_DST);
-            __setup_work(&worker->io->src, worker, DEPENDENCY_FROM_SRC1);
-            break;
-        }
-        case WORKER_OP:
+        threads[i].mc = &mc;
+        threads[i].id = i;
+        if (i > 0 && pthread_create(&threads[i].thread, NULL, tomasulo_core_thread, &threads[i]))
+            FATAL("pthread_create error\n");
+    }
+
+    (void)tomasulo_core_thread(&threads[0]);
+    for (i = 1; i < mc.num_threads; ++i)
+        (void)pthread_join(threads[i].thread, NULL);
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = timespec_diff(&start, &end);
+
+    (void)pthread_barrier_destroy(&mc.barrier);
+
+    printf("Multi-core run, %zu cores, %zu host threads, quantum %" PRIu32 " cycles\n",
+           mc.num_cores, mc.num_threads, mc.quantum);
+    for (i = 0; i < num_cores; ++i)
+    {
+        current_board = &mc.core[i].arch;
+        current_data = &mc.core[i].data;
+
+        if (!headless)
         {
-            __setup_work(&worker->rsc->dst, worker, DEPENDENCY_FROM_DST);
-            __setup_work(&worker->rsc->src1, worker, DEPENDENCY_FROM_SRC1);
-            __setup_work(&worker->rsc->src2, worker, DEPENDENCY_FROM_SRC2);
-            break;
+            printf("Core %zu\n", i);
+            board_dump();
         }
-        default:
-            break;
+
+        retired = tomasulo_data.stats.latency_all.count;
+        printf("\tCore %3zu  cycles %12" PRIu32 "  retired %12" PRIu64 "  IPC %6.3lf  stores %12" PRIu64 "\n",
+               i, current_cycle(), retired,
+               current_cycle() > 0 ? (double)retired / (double)current_cycle() : 0.0,
+               mc.core[i].stores->committed);
+
+        instr += retired;
+        if (current_cycle() > cycles)
+            cycles = current_cycle();
+
+        tomasulo_deinit();
+        ram_store_buffer_destroy(mc.core[i].stores);
     }
+
+    printf("\tCycles                 %14" PRIu32 "\n", cycles);
+    printf("\tRetired                %14" PRIu64 "\n", instr);
+    printf("\tHost time              %14.6lf s\n", seconds);
+    printf("\tCycles / s             %14.0lf\n", seconds > 0.0 ? (double)cycles * (double)num_cores / seconds : 0.0);
+    printf("\tInstructions / s       %14.0lf\n", seconds > 0.0 ? (double)instr / seconds : 0.0);
+
+    ram_reset(&mc.ram);
+    FREE(threads);
+    FREE(mc.core);
+
+    current_board = saved_board;
+    current_data = saved_data;
+
+    return 0;
 }
 
-static ___inline___ void prepare_work(Worker *worker)
+int tomasulo_smt(Token ***programs, const size_t *num_instr, size_t num_threads, const Tomasulo_options *options)
 {
+    int ret = 0;
+    bool headless = options != NULL && options->headless;
+    smt_fetch_policy_t policy = options != NULL ? options->smt_policy : SMT_FETCH_ROUND_ROBIN;
+    struct timespec start;
+    struct timespec end;
+    size_t t;
+
     TRACE();
-    switch (worker->type)
+
+    if (programs == NULL || num_instr == NULL || num_threads == 0 || num_threads > SMT_THREADS_MAX)
+        ERROR("Incorrect number of threads\n", 1);
+
+    tomasulo_init(options);
+    if (options != NULL && options->trace_json != NULL && tomasulo_data.trace == NULL)
+    {
+        tomasulo_deinit();
+        return 1;
+    }
+
+    board.num_threads = num_threads;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    while (tomasulo_smt_cycle(programs, num_instr, policy))
     {
-        case WORKER_IO:
+        if (!headless)
         {
-            __prepare_work(&worker->io->dst, worker, DEPENDENCY_FROM_DST);
-            __prepare_work(&worker->io->src, worker, DEPENDENCY_FROM_SRC1);
-            break;
+            PROFILE_BEGIN(PROFILE_PRINT);
+            tomasulo_print();
+            PROFILE_END(PROFILE_PRINT);
         }
-        case WORKER_OP:
+
+        tomasulo_next_cycle();
+
+        if (!headless)
         {
-            __prepare_work(&worker->rsc->dst, worker, DEPENDENCY_FROM_DST);
-            __prepare_work(&worker->rsc->src1, worker, DEPENDENCY_FROM_SRC1);
-            __prepare_work(&worker->rsc->src2, worker, DEPENDENCY_FROM_SRC2);
-            break;
+            printf("Type any key to go to next cycle\n");
+            getch();
+            reset_terminal();
         }
-        default:
-            break;
     }
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (!headless)
+        tomasulo_print();
+
+    stats_print_host(&tomasulo_data.stats, current_cycle(), timespec_diff(&start, &end));
+    stats_print_issue(&tomasulo_data.stats);
+    stats_print_fetch(&tomasulo_data.stats, current_cycle());
+    stats_print_retire(&tomasulo_data.stats, current_cycle());
+
+    printf("SMT, %zu threads, fetch policy %s\n", num_threads, policy == SMT_FETCH_ICOUNT ? "ICOUNT" : "round robin");
+    for (t = 0; t < num_threads; ++t)
+        printf("\tThread %zu  retired %12" PRIu64 "  IPC %6.3lf\n", t, tomasulo_data.retired[t],
+               current_cycle() > 0 ? (double)tomasulo_data.retired[t] / (double)current_cycle() : 0.0);
+
+    printf("\tCombined  retired %12" PRIu64 "  IPC %6.3lf\n", tomasulo_data.stats.latency_all.count,
+           current_cycle() > 0 ? (double)tomasulo_data.stats.latency_all.count / (double)current_cycle() : 0.0);
+
+    if (options != NULL && options->arch_dump)
+        board_dump_arch();
+
+    if (options != NULL && options->stats_csv != NULL)
+        if (stats_write_csv(&tomasulo_data.stats, options->stats_csv, current_cycle()))
+        {
+            fprintf(stderr, "Cannot write statistics to %s\n", options->stats_csv);
+            ret = 1;
+        }
+
+    tomasulo_deinit();
+    return ret;
 }
 
-static void __setup_work(Variable *var, Worker *worker, int dep_slot)
+static ___inline___ Tomasulo_context tomasulo_switch_context(Board *board_new, Tomasulo_data *data_new)
 {
-    Register_info *r;
-    TRACE();
-    
-    if(var->type != VAR_REGISTER)
-        return;
+    Tomasulo_context prev = { .arch = current_board, .data = current_data };
+
+    current_board = board_new;
+    current_data = data_new;
 
-    r = &board.registers.regs[var->nr];
+    return prev;
+}
+
+static void tomasulo_sim_free_program(Tomasulo_sim *sim)
+{
+    size_t i;
 
-    r->worker = *worker;
-    r->worker_slot = dep_slot;
-    r->state = STATE_BUSY;
+    TRACE();
 
-    switch (worker->type)
+    if (sim->owns_program)
     {
-        case WORKER_OP:
-        {
-            LOG("R%" PRIu32 " is free, setup rsc job %d [ %d ]\n", r->nr, r->job, r->aryth_type);
-            r->job = worker->rsc->job;
-            r->aryth_type = worker->rsc->aryth_type;
-            break;
-        }
-        case WORKER_IO:
-        {
-            LOG("R%" PRIu32 " is free, setup io job %d\n", r->nr, r->job);
-            r->job = worker->io->job;
-            break;
-        }
-        default:
-            break;
+        for (i = 0; i < sim->core.num_instr; ++i)
+            token_destroy(sim->core.program[i]);
+
+        FREE(sim->core.program);
     }
+
+    sim->core.program = NULL;
+    sim->core.num_instr = 0;
+    sim->owns_program = false;
 }
 
-static void __prepare_work(Variable *var, Worker *worker, int dep_slot)
+Tomasulo_sim *tomasulo_sim_create(void)
 {
-    Register_info *r;
-    int i;
+    Tomasulo_sim *sim;
+    Tomasulo_context prev;
 
     TRACE();
 
-    /* prepare only registers */
-    if (var->type != VAR_REGISTER)
-        return;
-
-    r = &board.registers.regs[var->nr];
-    if (r->state == STATE_BUSY && memcmp(worker, &r->worker, sizeof(Worker)))
-    {
-        LOG("R%" PRIu32 " is busy, wait for this %d job [ %d ]\n", r->nr, r->job, r->aryth_type);
+    sim = (Tomasulo_sim *)calloc(1, sizeof(Tomasulo_sim));
+    if (sim == NULL)
+        ERROR("calloc error\n", NULL);
 
-        /* notify that Im waiting for this job */
-        switch (r->worker.type)
-        {
-            case WORKER_OP:
-            {
-                for (i = 0; i < DEPENDENCY_NR_OF_SLOT_RSC; ++i)
-                    if (memcmp(worker, &r->worker.rsc->dependency[i], sizeof(Worker)) == 0)
-                    {
-                        LOG("The same dependency on %d, so do nothing\n", i);
-                        return;
-                    }
+    prev = tomasulo_switch_context(&sim->core.arch, &sim->core.data);
+    tomasulo_init(NULL);
+    (void)tomasulo_switch_context(prev.arch, prev.data);
 
-                worker->slot = dep_slot;
-                LOG("Prepare work in rsc for R%" PRIu32 "\n", r->nr);
-                r->worker.rsc->dependency[r->worker_slot] = *(Dependency *)worker;
-                break;
-            }
-            case WORKER_IO:
-            {
-                for (i = 0; i < DEPENDENCY_NR_OF_SLOT_IO; ++i)
-                    if (memcmp(worker, &r->worker.io->dependency[i], sizeof(Worker)) == 0)
-                    {
-                        LOG("The same dependency on %d, so do nothing\n", i);
-                        return;
-                    }
+    /* nothing to simulate yet */
+    sim->core.finished = true;
 
-                worker->slot = dep_slot;
-                LOG("Prepare work in io for R%" PRIu32 "\n", r->nr);
-                r->worker.io->dependency[r->worker_slot] = *(Dependency *)worker;
-                break;
-            }
-            default:
-                break;
-        }
-        
-        /* I have dependency */
-        switch (worker->type)
-        {
-            case WORKER_OP:
-            {
-                LOG("Set RSC dependency in %d slot\n", dep_slot);
-                worker->rsc->has_dependency[dep_slot] = true;
-                break;
-            }
-            case WORKER_IO:
-            {
-                LOG("Set IO dependency in %d slot\n", dep_slot);
-                worker->io->has_dependency[dep_slot] = true;
-                break;
-            }
-            default:
-                break;
-        }
-    }
-    else
-        __setup_work(var, worker, dep_slot);
+    return sim;
 }
 
-static ___inline___ bool var_works_with_dep(const Variable *var)
+void tomasulo_sim_destroy(Tomasulo_sim *sim)
 {
-    const Register_info *r;
+    Tomasulo_context prev;
 
     TRACE();
 
-    if (var->type != VAR_REGISTER)
-        return false;
+    if (sim == NULL)
+        return;
 
-    r = &board.registers.regs[var->nr];
-    switch (r->worker.type)
-    {
-        case WORKER_OP:
-            {
-                return (r->worker.rsc->dependency[r->worker_slot].type != DEPENDENCY_NONE);
-            }
-            case WORKER_IO:
-            {
-                return (r->worker.io->dependency[r->worker_slot].type != DEPENDENCY_NONE);
-            }
-            default:
-                break;
-    }
+    prev = tomasulo_switch_context(&sim->core.arch, &sim->core.data);
+    tomasulo_deinit();
+    (void)tomasulo_switch_context(prev.arch, prev.data);
 
-    return false;
+    tomasulo_sim_free_program(sim);
+    FREE(sim);
 }
 
-static void fetch(Token *token)
+int tomasulo_sim_load_program(Tomasulo_sim *sim, Token **program, size_t num_instr)
 {
+    Tomasulo_context prev;
+
     TRACE();
 
-    const Token_move *tmove;
-    const Token_cmp *tcmp;
-    const Token_jump *tjump;
-    const Token_arythmetic *taryth;
-    Reservation_station_chunk *rsc;
-    IO_info *io;
-    Instructions_status *is;
-    Worker worker;
-    int32_t time = 0;
+    if (sim == NULL || program == NULL)
+        ERROR("sim == NULL || program == NULL\n", 1);
 
-    switch (token->type)
-    {
-        case TOKEN_JUMP:
-        {
-            LOG("Token jump fetched\n");
+    if (!program_is_valid(program, num_instr))
+        ERROR("Invalid program\n", 1);
 
-            tjump = (Token_jump *)&token->token_jump;
-            if (!is_rsc_cmp_busy()) /* cmp flag is set correctly */
-            {
-                LOG("Cmp rsc is free, so jump now\n");
-                do_jump(tjump->type, tjump->line);
-                is = tomasulo_add_instruction_to_tracking(token);
-                is->exec_cycle = current_cycle();
-            }
-            else
-                LOG("Cmp rsc busy, waiting\n");
-            break;
-        }
-        case TOKEN_CMP:
-        {
-            LOG("Token cmp fetched\n");
-            tcmp = (Token_cmp *)&token->token_cmp;
-            if (!is_rsc_cmp_busy())
-            {
-                LOG("Cmp rsc free, try to setup work\n");
+    prev = tomasulo_switch_context(&sim->core.arch, &sim->core.data);
+    tomasulo_deinit();
+    tomasulo_init(NULL);
+    (void)tomasulo_switch_context(prev.arch, prev.data);
 
-                if (!var_works_with_dep(&tcmp->src1) && !var_works_with_dep(&tcmp->src2))
-                    LOG("Regs has not work with dep, setup work\n");
-                else
-                {
-                    LOG("Regs has dependency, waiting\n");
-                    break;
-                }
+    tomasulo_sim_free_program(sim);
+    sim->core.program = program;
+    sim->core.num_instr = num_instr;
+    sim->core.issued = 0;
+    sim->core.finished = false;
 
-                rsc = get_first_free_cmp();
+    return 0;
+}
 
-                /* set cmp job */
-                rsc->state = STATE_BUSY;
-                rsc->job = JOB_CMP;
-                rsc->wait_time = CYCLES_CMP;
-                rsc->src1 = tcmp->src1;
-                rsc->src2 = tcmp->src2;
-                rsc->is = tomasulo_add_instruction_to_tracking(token);
+int tomasulo_sim_load_file(Tomasulo_sim *sim, const char *path)
+{
+    Token **program;
+    size_t num_instr;
+    size_t i;
 
-                worker.type = WORKER_OP;
-                worker.rsc = rsc;
+    TRACE();
 
-                prepare_work(&worker);
+    if (sim == NULL || path == NULL)
+        ERROR("sim == NULL || path == NULL\n", 1);
 
-                go_to_next_instruction();
-            }
-            else
-                LOG("Cmp rsc busy, waiting\n");
+    program = parse(path, &num_instr);
+    if (program == NULL)
+        ERROR("parse error\n", 1);
 
-            break;
-        }
-        case TOKEN_ARYTHMETIC:
-        {
-            taryth = (Token_arythmetic *)&token->token_arythmetic;
-            LOG("Token arythmetic fetched %d\n", taryth->type);
-            switch (taryth->type)
-            {
-                case OP_ADD:
-                {
-                    if (time == 0)
-                        time = CYCLES_ADD;
-                }
-                case OP_SUB:
-                {
-                    if (time == 0)
-                        time = CYCLES_ADD;
+    /* previous program stays loaded */
+    if (tomasulo_sim_load_program(sim, program, num_instr))
+    {
+        for (i = 0; i < num_instr; ++i)
+            token_destroy(program[i]);
 
-                    if (!is_rsc_add_sub_busy())
-                    {
-                        LOG("Add-sub rsc is free, try setup work\n");
-
-                        if (!var_works_with_dep(&taryth->dst) && !var_works_with_dep(&taryth->src1) 
-                            && !var_works_with_dep(&taryth->src2))
-                        LOG("Regs has not work with dep, setup work\n");
-                        else
-                        {
-                            LOG("Regs has dependency, waiting\n");
-                            break;
-                        }
-
-                        rsc = get_first_free_add_sub();
-
-                        /* set job */
-                        rsc->state = STATE_BUSY;
-                        rsc->job = JOB_ARYTHMETIC;
-                        rsc->aryth_type = taryth->type;
-                        rsc->wait_time = time;
-                        rsc->dst = taryth->dst;
-                        rsc->src1 = taryth->src1;
-                        rsc->src2 = taryth->src2;
-                        rsc->is = tomasulo_add_instruction_to_tracking(token);
-
-                        worker.type = WORKER_OP;
-                        worker.rsc = rsc;
-                     
-                        prepare_work(&worker);
-
-                        go_to_next_instruction();
-                    }
-                    else
-                        LOG("Add-sub rsc busy, waiting\n");
+        FREE(program);
+        ERROR("tomasulo_sim_load_program error\n", 1);
+    }
 
-                    break;
-                }
-                case OP_MUL:
-                {
-                    if (time == 0)
-                        time = CYCLES_MUL;
-                }
-                case OP_DIV:
-                {
-                    if (time == 0)
-                        time = CYCLES_DIV;
-                }
-                case OP_MOD:
-                {
-                    if (time == 0)
-                        time = CYCLES_MOD;
+    sim->owns_program = true;
 
-                    if (!is_rsc_mul_div_mod_busy())
-                    {
-                        LOG("Mul-Div-Mod rsc free, try setup work\n");
-
-                        if (!var_works_with_dep(&taryth->dst) && !var_works_with_dep(&taryth->src1) 
-                            && !var_works_with_dep(&taryth->src2))
-                        LOG("Regs has not work with dep, setup work\n");
-                        else
-                        {
-                            LOG("Regs has dependency, waiting\n");
-                            break;
-                        }
-
-                        rsc = get_first_free_mul_div_mod();
-
-                        /* set job */
-                        rsc->state = STATE_BUSY;
-                        rsc->job = JOB_ARYTHMETIC;
-                        rsc->aryth_type = taryth->type;
-                        rsc->wait_time = time;
-                        rsc->dst = taryth->dst;
-                        rsc->src1 = taryth->src1;
-                        rsc->src2 = taryth->src2;
-                        rsc->is = tomasulo_add_instruction_to_tracking(token);
-
-                        worker.type = WORKER_OP;
-                        worker.rsc = rsc;
-                     
-                        prepare_work(&worker);
-
-                        go_to_next_instruction();
-                    }
-                    else
-                        LOG("Mul-Div-Mod rsc busy, waiting\n");
+    return 0;
+}
 
-                    break;
-                }
-                default:
-                    break;
-            }
+uint64_t tomasulo_sim_step(Tomasulo_sim *sim, uint64_t cycles)
+{
+    Tomasulo_context prev;
+    uint64_t i;
+
+    TRACE();
+
+    if (sim == NULL)
+        return 0;
+
+    prev = tomasulo_switch_context(&sim->core.arch, &sim->core.data);
+    for (i = 0; i < cycles && !sim->core.finished; ++i)
+    {
+        if (!tomasulo_cycle(sim->core.program, sim->core.num_instr, UINT64_MAX, &sim->core.issued))
+        {
+            sim->core.finished = true;
             break;
         }
-        case TOKEN_MOVE:
-        {
-            tmove = (Token_move *)&token->token_move;
 
-            LOG("Token move fetched\n");
-            /* one of them is memory */
-            if (tmove->dst.type == VAR_MEMORY || tmove->src.type == VAR_MEMORY)
-                time = CYCLES_MOV_MEM;
-            else /* register to register or value to register */
-                time = CYCLES_MOV_REG;
-
-            if (tmove->dst.type == VAR_REGISTER)
-            {
-                LOG("Assume is load\n");
+        tomasulo_next_cycle();
+    }
+    (void)tomasulo_switch_context(prev.arch, prev.data);
 
-                if (!is_io_load_busy())
-                {
-                    LOG("IO buffer(Load) free, try setup work\n");
+    return i;
+}
 
-                    if (!var_works_with_dep(&tmove->dst) && !var_works_with_dep(&tmove->src))
-                        LOG("Regs has not work with dep, setup work\n");
-                    else
-                    {
-                        LOG("Regs has dependency, waiting\n");
-                        break;
-                    }
+uint64_t tomasulo_sim_run_until(Tomasulo_sim *sim, const Tomasulo_sim_stop *stop)
+{
+    Tomasulo_context prev;
+    uint64_t cycles = 0;
 
-                    io = get_first_free_io_load();
-                    io->dst = tmove->dst;
-                    io->src = tmove->src;
-                    io->state = STATE_BUSY;
-                    io->job = JOB_LOAD;
-                    io->wait_time = time;
-                    
-                    io->is = tomasulo_add_instruction_to_tracking(token);
-
-                    worker.type = WORKER_IO;
-                    worker.io = io;
-                     
-                    prepare_work(&worker);
-
-                    go_to_next_instruction();
-                }
-                else
-                    LOG("IO buffer(Load) busy, waiting\n");
-            }
-            else
-            {
-                LOG("Assume io store\n");
-                if (!is_io_write_busy())
-                {
-                    LOG("IO buffer(Store) free, try setup work\n");
+    TRACE();
 
-                    if (!var_works_with_dep(&tmove->dst) && !var_works_with_dep(&tmove->src))
-                        LOG("Regs has not work with dep, setup work\n");
-                    else
-                    {
-                        LOG("Regs has dependency, waiting\n");
-                        break;
-                    }
+    if (sim == NULL || stop == NULL)
+        return 0;
 
-                    io = get_first_free_io_write();
-                    io->dst = tmove->dst;
-                    io->src = tmove->src;
-                    io->state = STATE_BUSY;
-                    io->job = JOB_STORE;
-                    io->wait_time = time;
-                    
-                    io->is = tomasulo_add_instruction_to_tracking(token);
-
-                    worker.type = WORKER_IO;
-                    worker.io = io;
-                     
-                    prepare_work(&worker);
-
-                    go_to_next_instruction();
-                }
-                else
-                    LOG("IO buffer(Store) busy, waiting\n");
-            }
+    prev = tomasulo_switch_context(&sim->core.arch, &sim->core.data);
+    while (!sim->core.finished)
+    {
+        if (!tomasulo_cycle(sim->core.program, sim->core.num_instr, UINT64_MAX, &sim->core.issued))
+        {
+            sim->core.finished = true;
             break;
         }
-        default:
-            break;
 
+        tomasulo_next_cycle();
+        ++cycles;
+
+        if (current_cycle() >= stop->cycle ||
+            tomasulo_data.stats.latency_all.count >= stop->retired ||
+            board.ctx->pc == stop->pc)
+            break;
     }
+    (void)tomasulo_switch_context(prev.arch, prev.data);
+
+    return cycles;
 }
 
-static ___inline___ bool wait_for_unfinished_job(void)
+void tomasulo_sim_get_state(const Tomasulo_sim *sim, Tomasulo_sim_state *state)
 {
     TRACE();
 
-    size_t i;
-    for (i = 0; i < REGISTERS_NUM; ++i)
-        if (board.registers.regs[i].state == STATE_BUSY)
-            return true;
+    if (sim == NULL || state == NULL)
+        return;
 
-    return false;
+    state->cycle = sim->core.data.cycle;
+    state->issued = sim->core.issued;
+    state->retired = sim->core.data.stats.latency_all.count;
+    state->pc = sim->core.arch.thread[0].pc;
+    state->cf = sim->core.arch.thread[0].cf;
+    state->finished = sim->core.finished;
 }
 
-int tomasulo(Token **program, size_t num_instr)
+DWORD tomasulo_sim_get_register(const Tomasulo_sim *sim, uint32_t nr)
 {
     TRACE();
 
-    LOG("Init tomasulo\n");
-    tomasulo_init();
+    if (sim == NULL || nr >= REGISTERS_NUM)
+        return 0;
 
-    while (board.pc < num_instr || wait_for_unfinished_job())
-    {
-        if (board.pc < num_instr)
-            fetch(program[board.pc]);
+    return sim->core.arch.thread[0].registers.regs[nr].val;
+}
 
-        execute();
-        tomasulo_print();
-        tomasulo_next_cycle();
+DWORD tomasulo_sim_get_memory(const Tomasulo_sim *sim, uint32_t addr)
+{
+    TRACE();
 
-        printf("Type any key to go to next cycle\n");
-        getch();
-        reset_terminal();
-    }
+    if (sim == NULL)
+        return 0;
 
-    tomasulo_print();
-    LOG("Deinit tomasulo\n");
-    tomasulo_deinit();
-    return 0;
-}
\ No newline at end of file
+    return ram_read(sim->core.arch.ram, addr);
+}
+
+const Stats *tomasulo_sim_get_stats(const Tomasulo_sim *sim)
+{
+    TRACE();
+
+    if (sim == NULL)
+        return NULL;
+
+    return &sim->core.data.stats;
+}
@@ -0,0 +1,140 @@
+#include <trace.h>
+#include <log.h>
+#include <compiler.h>
+#include <common.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#define TRACE_BUFFER_SIZE (1 << 20)
+#define TRACE_PID 1
+
+/*
+    Write separator between events
+
+    PARAMS
+    @IN trace - pointer to trace
+
+    RETURN
+    This is a void function
+*/
+static ___inline___ void trace_next_event(Trace *trace);
+
+/*
+    Write string as JSON string literal (quoted, " \\ and control chars escaped)
+
+    PARAMS
+    @IN file - output file
+    @IN str - string
+
+    RETURN
+    This is a void function
+*/
+static void trace_write_string(FILE *file, const char *str);
+
+static ___inline___ void trace_next_event(Trace *trace)
+{
+    if (trace->events++ > 0)
+        fputs(",\n", trace->file);
+}
+
+static void trace_write_string(FILE *file, const char *str)
+{
+    const unsigned char *c;
+
+    fputc('"', file);
+    for (c = (const unsigned char *)str; *c != '\0'; ++c)
+    {
+        if (*c == '"' || *c == '\\')
+        {
+            fputc('\\', file);
+            fputc(*c, file);
+        }
+        else if (*c < 0x20)
+            fprintf(file, "\\u%04x", *c);
+        else
+            fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+Trace *trace_create(const char *path)
+{
+    Trace *trace;
+
+    TRACE();
+
+    trace = (Trace *)malloc(sizeof(Trace));
+    if (trace == NULL)
+        ERROR("malloc error\n", NULL);
+
+    (void)memset(trace, 0, sizeof(Trace));
+
+    trace->file = fopen(path, "w");
+    if (trace->file == NULL)
+    {
+        FREE(trace);
+        ERROR("fopen error\n", NULL);
+    }
+
+    trace->buf = (char *)malloc(TRACE_BUFFER_SIZE);
+    if (trace->buf != NULL)
+        (void)setvbuf(trace->file, trace->buf, _IOFBF, TRACE_BUFFER_SIZE);
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", trace->file);
+
+    trace_next_event(trace);
+    fprintf(trace->file, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,\"args\":{\"name\":\"Tomasulo\"}}", TRACE_PID);
+
+    return trace;
+}
+
+void trace_destroy(Trace *trace)
+{
+    TRACE();
+
+    if (trace == NULL)
+        return;
+
+    fputs("\n]}\n", trace->file);
+    if (fclose(trace->file) != 0)
+        fprintf(stderr, "Cannot write trace\n");
+
+    FREE(trace->buf);
+    FREE(trace);
+}
+
+void trace_track_name(Trace *trace, uint32_t tid, const char *name)
+{
+    trace_next_event(trace);
+    fprintf(trace->file, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%" PRIu32 ",\"args\":{\"name\":",
+            TRACE_PID, tid);
+    trace_write_string(trace->file, name);
+    fputs("}}", trace->file);
+
+    trace_next_event(trace);
+    fprintf(trace->file, "{\"ph\":\"M\",\"name\":\"thread_sort_index\",\"pid\":%d,\"tid\":%" PRIu32 ",\"args\":{\"sort_index\":%" PRIu32 "}}",
+            TRACE_PID, tid, tid);
+}
+
+void trace_slice(Trace *trace, uint32_t tid, const char *name, const char *cat, uint64_t ts, uint64_t dur)
+{
+    trace_next_event(trace);
+    fprintf(trace->file, "{\"ph\":\"X\",\"pid\":%d,\"tid\":%" PRIu32 ",\"name\":", TRACE_PID, tid);
+    trace_write_string(trace->file, name);
+    fputs(",\"cat\":", trace->file);
+    trace_write_string(trace->file, cat);
+    fprintf(trace->file, ",\"ts\":%" PRIu64 ",\"dur\":%" PRIu64 "}", ts, dur);
+}
+
+void trace_flow(Trace *trace, uint32_t from, uint32_t to, uint64_t ts)
+{
+    ++trace->flow_id;
+
+    trace_next_event(trace);
+    fprintf(trace->file, "{\"ph\":\"s\",\"pid\":%d,\"tid\":%" PRIu32 ",\"name\":\"wakeup\",\"cat\":\"dep\",\"id\":%" PRIu64 ",\"ts\":%" PRIu64 "}",
+            TRACE_PID, from, trace->flow_id, ts);
+
+    trace_next_event(trace);
+    fprintf(trace->file, "{\"ph\":\"f\",\"bp\":\"e\",\"pid\":%d,\"tid\":%" PRIu32 ",\"name\":\"wakeup\",\"cat\":\"dep\",\"id\":%" PRIu64 ",\"ts\":%" PRIu64 "}",
+            TRACE_PID, to, trace->flow_id, ts);
+}
@@ -0,0 +1,596 @@
+/*
+    Synthetic workload generator for stress and scaling tests.
+
+    Emits valid program in simulator asm:
+    - body of independent dependency chains (controlled ILP)
+    - instruction mix weighted by op class
+    - memory accesses over M addresses with chosen pattern
+    - optional loop around body built from cmp / jlt
+
+    Output is deterministic for given seed and parameters.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#include <tokens.h>
+#include <arch.h>
+#include <log.h>
+#include <compiler.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+/* reserved registers */
+#define REG_COUNTER     0
+#define REG_ONE         1
+#define REG_LIMIT       2
+#define REG_DIVISOR     3
+#define REG_FIRST_FREE  4
+
+#define FREE_REGS       (REGISTERS_NUM - REG_FIRST_FREE)
+
+#define DIVISOR         7
+#define HOT_ADDRS       8
+#define HOT_PERCENT     90
+
+#define LINE_SIZE       64
+
+typedef enum gen_class_t
+{
+    GEN_ADD,
+    GEN_SUB,
+    GEN_MUL,
+    GEN_DIV,
+    GEN_MOD,
+    GEN_LOAD,
+    GEN_STORE,
+    GEN_BRANCH,
+    GEN_CLASSES
+} gen_class_t;
+
+typedef enum gen_pattern_t
+{
+    PATTERN_SEQ,
+    PATTERN_STRIDE,
+    PATTERN_RANDOM,
+    PATTERN_HOT
+} gen_pattern_t;
+
+typedef struct Gen_options
+{
+    uint64_t seed;
+    uint64_t num_instr; /* static instructions in body */
+    uint32_t iterations; /* loop iterations, 1 means no loop */
+    uint32_t chains; /* independent dependency chains (ILP) */
+    uint32_t cross; /* % of ops reading head of other chain */
+    uint32_t weight[GEN_CLASSES];
+    gen_pattern_t pattern;
+    uint32_t addr_space; /* number of M addresses */
+    uint32_t stride;
+    const char *out;
+} Gen_options;
+
+typedef struct Gen_state
+{
+    FILE *out;
+    uint64_t line; /* index of next instruction */
+    uint64_t rng;
+    uint64_t mem_ops;
+    uint32_t head[FREE_REGS]; /* last written register of chain */
+    uint32_t next_reg[FREE_REGS]; /* next register to write in chain */
+    uint32_t regs_per_chain;
+} Gen_state;
+
+/*
+    Get random number (xorshift64*)
+
+    PARAMS
+    @IN state - pointer to Gen_state
+
+    RETURN
+    Random number
+*/
+static ___inline___ uint64_t gen_rand(Gen_state *state);
+
+/*
+    Print token as one line of program
+
+    PARAMS
+    @IN state - pointer to Gen_state
+    @IN token - pointer to token
+
+    RETURN
+    This is a void function
+*/
+static void gen_emit(Gen_state *state, const Token *token);
+
+/*
+    Emit helpers, one per token type
+
+    PARAMS
+    @IN state - pointer to Gen_state
+    @IN ... - operands
+
+    RETURN
+    This is a void function
+*/
+static void gen_emit_move(Gen_state *state, Variable dst, Variable src);
+static void gen_emit_arythmetic(Gen_state *state, arythemtic_t type, uint32_t dst, uint32_t src1, uint32_t src2);
+static void gen_emit_cmp(Gen_state *state, uint32_t src1, uint32_t src2);
+static void gen_emit_jump(Gen_state *state, jump_t type, uint64_t line);
+
+/*
+    Variable constructors
+*/
+static ___inline___ Variable gen_reg(uint32_t nr);
+static ___inline___ Variable gen_mem(uint32_t nr);
+static ___inline___ Variable gen_val(uint32_t val);
+
+/*
+    Get next memory address from pattern
+
+    PARAMS
+    @IN state - pointer to Gen_state
+    @IN options - pointer to Gen_options
+
+    RETURN
+    Memory address
+*/
+static uint32_t gen_addr(Gen_state *state, const Gen_options *options);
+
+/*
+    Pick class of next instruction from weights
+
+    PARAMS
+    @IN state - pointer to Gen_state
+    @IN options - pointer to Gen_options
+
+    RETURN
+    Class of instruction
+*/
+static gen_class_t gen_pick_class(Gen_state *state, const Gen_options *options);
+
+/*
+    Get source register for chain, head of own chain or iff cross head of other chain
+
+    PARAMS
+    @IN state - pointer to Gen_state
+    @IN options - pointer to Gen_options
+    @IN chain - chain index
+
+    RETURN
+    Register number
+*/
+static uint32_t gen_src(Gen_state *state, const Gen_options *options, uint32_t chain);
+
+/*
+    Get register to write for chain and make it head
+
+    PARAMS
+    @IN state - pointer to Gen_state
+    @IN chain - chain index
+
+    RETURN
+    Register number
+*/
+static uint32_t gen_dst(Gen_state *state, uint32_t chain);
+
+/*
+    Generate whole program
+
+    PARAMS
+    @IN options - pointer to Gen_options
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int gen_program(const Gen_options *options);
+
+/*
+    Parse comma separated weights add,sub,mul,div,mod,load,store,branch
+
+    PARAMS
+    @IN str - string with weights
+    @OUT weight - array of GEN_CLASSES weights
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int gen_parse_weights(const char *str, uint32_t *weight);
+
+/*
+    Print usage on stderr
+
+    PARAMS
+    @IN name - program name
+
+    RETURN
+    This is a void function
+*/
+static void gen_usage(const char *name);
+
+static ___inline___ uint64_t gen_rand(Gen_state *state)
+{
+    state->rng ^= state->rng >> 12;
+    state->rng ^= state->rng << 25;
+    state->rng ^= state->rng >> 27;
+
+    return state->rng * 0x2545F4914F6CDD1DULL;
+}
+
+static ___inline___ Variable gen_reg(uint32_t nr)
+{
+    Variable var = { .type = VAR_REGISTER, .nr = nr };
+
+    return var;
+}
+
+static ___inline___ Variable gen_mem(uint32_t nr)
+{
+    Variable var = { .type = VAR_MEMORY, .nr = nr };
+
+    return var;
+}
+
+static ___inline___ Variable gen_val(uint32_t val)
+{
+    Variable var = { .type = VAR_VALUE, .val = val };
+
+    return var;
+}
+
+static void gen_emit(Gen_state *state, const Token *token)
+{
+    char buf[LINE_SIZE];
+
+    (void)token_snprint(buf, sizeof(buf), token);
+    fprintf(state->out, "%s\n", buf);
+    ++state->line;
+}
+
+static void gen_emit_move(Gen_state *state, Variable dst, Variable src)
+{
+    Token token = { .type = TOKEN_MOVE };
+
+    token.token_move.dst = dst;
+    token.token_move.src = src;
+
+    gen_emit(state, &token);
+}
+
+static void gen_emit_arythmetic(Gen_state *state, arythemtic_t type, uint32_t dst, uint32_t src1, uint32_t src2)
+{
+    Token token = { .type = TOKEN_ARYTHMETIC };
+
+    token.token_arythmetic.type = type;
+    token.token_arythmetic.dst = gen_reg(dst);
+    token.token_arythmetic.src1 = gen_reg(src1);
+    token.token_arythmetic.src2 = gen_reg(src2);
+
+    gen_emit(state, &token);
+}
+
+static void gen_emit_cmp(Gen_state *state, uint32_t src1, uint32_t src2)
+{
+    Token token = { .type = TOKEN_CMP };
+
+    token.token_cmp.src1 = gen_reg(src1);
+    token.token_cmp.src2 = gen_reg(src2);
+
+    gen_emit(state, &token);
+}
+
+static void gen_emit_jump(Gen_state *state, jump_t type, uint64_t line)
+{
+    Token token = { .type = TOKEN_JUMP };
+
+    token.token_jump.type = type;
+    token.token_jump.line = (uint32_t)line;
+
+    gen_emit(state, &token);
+}
+
+static uint32_t gen_addr(Gen_state *state, const Gen_options *options)
+{
+    uint64_t k = state->mem_ops++;
+
+    switch (options->pattern)
+    {
+        case PATTERN_SEQ:
+            return (uint32_t)(k % options->addr_space);
+        case PATTERN_STRIDE:
+            return (uint32_t)((k * options->stride) % options->addr_space);
+        case PATTERN_HOT:
+        {
+            if (gen_rand(state) % 100 < HOT_PERCENT)
+                return (uint32_t)(gen_rand(state) % HOT_ADDRS % options->addr_space);
+
+            return (uint32_t)(gen_rand(state) % options->addr_space);
+        }
+        case PATTERN_RANDOM:
+        default:
+            return (uint32_t)(gen_rand(state) % options->addr_space);
+    }
+
+    return 0;
+}
+
+static gen_class_t gen_pick_class(Gen_state *state, const Gen_options *options)
+{
+    uint64_t sum = 0;
+    uint64_t r;
+    size_t i;
+
+    for (i = 0; i < GEN_CLASSES; ++i)
+        sum += options->weight[i];
+
+    r = gen_rand(state) % sum;
+    for (i = 0; i < GEN_CLASSES; ++i)
+    {
+        if (r < options->weight[i])
+            return (gen_class_t)i;
+
+        r -= options->weight[i];
+    }
+
+    return GEN_ADD;
+}
+
+static uint32_t gen_src(Gen_state *state, const Gen_options *options, uint32_t chain)
+{
+    if (options->chains > 1 && gen_rand(state) % 100 < options->cross)
+        return state->head[gen_rand(state) % options->chains];
+
+    return state->head[chain];
+}
+
+static uint32_t gen_dst(Gen_state *state, uint32_t chain)
+{
+    uint32_t reg = REG_FIRST_FREE + chain * state->regs_per_chain + state->next_reg[chain];
+
+    state->next_reg[chain] = (state->next_reg[chain] + 1) % state->regs_per_chain;
+    state->head[chain] = reg;
+
+    return reg;
+}
+
+static int gen_program(const Gen_options *options)
+{
+    Gen_state state;
+    uint64_t i;
+    uint64_t loop_start;
+    uint64_t body_end;
+    uint32_t chain;
+    uint32_t src1;
+    uint32_t src2;
+    gen_class_t cls;
+    static const arythemtic_t aryth[] = { OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD };
+    static const jump_t jumps[] = { JUMP_EQ, JUMP_NEQ, JUMP_LT, JUMP_LEQ, JUMP_GT, JUMP_GEQ };
+
+    TRACE();
+
+    (void)memset(&state, 0, sizeof(state));
+    state.rng = options->seed == 0 ? 0x9E3779B97F4A7C15ULL : options->seed;
+    state.regs_per_chain = FREE_REGS / options->chains;
+
+    state.out = options->out == NULL ? stdout : fopen(options->out, "w");
+    if (state.out == NULL)
+        ERROR("fopen error\n", 1);
+
+    /* reserved registers */
+    gen_emit_move(&state, gen_reg(REG_COUNTER), gen_val(0));
+    gen_emit_move(&state, gen_reg(REG_ONE), gen_val(1));
+    gen_emit_move(&state, gen_reg(REG_LIMIT), gen_val(options->iterations));
+    gen_emit_move(&state, gen_reg(REG_DIVISOR), gen_val(DIVISOR));
+
+    /* initial value of each chain */
+    for (chain = 0; chain < options->chains; ++chain)
+        gen_emit_move(&state, gen_reg(gen_dst(&state, chain)), gen_val((uint32_t)(gen_rand(&state) % 100) + 1));
+
+    loop_start = state.line;
+    body_end = loop_start + options->num_instr;
+
+    for (i = 0; state.line < body_end; ++i)
+    {
+        chain = (uint32_t)(i % options->chains);
+
+        cls = gen_pick_class(&state, options);
+        switch (cls)
+        {
+            case GEN_ADD:
+            case GEN_SUB:
+            case GEN_MUL:
+            {
+                src1 = state.head[chain];
+                src2 = gen_src(&state, options, chain);
+                gen_emit_arythmetic(&state, aryth[cls], gen_dst(&state, chain), src1, src2);
+                break;
+            }
+            case GEN_DIV:
+            case GEN_MOD:
+            {
+                src1 = gen_src(&state, options, chain);
+                gen_emit_arythmetic(&state, aryth[cls], gen_dst(&state, chain), src1, REG_DIVISOR);
+                break;
+            }
+            case GEN_LOAD:
+            {
+                gen_emit_move(&state, gen_reg(gen_dst(&state, chain)), gen_mem(gen_addr(&state, options)));
+                break;
+            }
+            case GEN_STORE:
+            {
+                gen_emit_move(&state, gen_mem(gen_addr(&state, options)), gen_reg(gen_src(&state, options, chain)));
+                break;
+            }
+            case GEN_BRANCH:
+            {
+                /* forward branch over next instruction, needs 3 lines in body */
+                if (state.line + 3 > body_end)
+                {
+                    gen_emit_arythmetic(&state, OP_ADD, gen_dst(&state, chain), state.head[chain], REG_ONE);
+                    break;
+                }
+
+                gen_emit_cmp(&state, state.head[chain], REG_DIVISOR);
+                gen_emit_jump(&state, jumps[gen_rand(&state) % (sizeof(jumps) / sizeof(jumps[0]))], state.line + 2);
+                gen_emit_arythmetic(&state, OP_ADD, gen_dst(&state, chain), state.head[chain], REG_ONE);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if (options->iterations > 1)
+    {
+        gen_emit_arythmetic(&state, OP_ADD, REG_COUNTER, REG_COUNTER, REG_ONE);
+        gen_emit_cmp(&state, REG_COUNTER, REG_LIMIT);
+        gen_emit_jump(&state, JUMP_LT, loop_start);
+    }
+
+    /* results of chains are visible in memory */
+    for (chain = 0; chain < options->chains; ++chain)
+        gen_emit_move(&state, gen_mem(options->addr_space + chain), gen_reg(state.head[chain]));
+
+    /* write error of buffered output shows up only at close */
+    if (state.out != stdout && fclose(state.out) != 0)
+        ERROR("fclose error\n", 1);
+
+    return 0;
+}
+
+static int gen_parse_weights(const char *str, uint32_t *weight)
+{
+    size_t i;
+    char *end;
+    uint64_t sum = 0;
+
+    for (i = 0; i < GEN_CLASSES; ++i)
+    {
+        weight[i] = (uint32_t)strtoul(str, &end, 10);
+        sum += weight[i];
+        if (end == str)
+            return 1;
+
+        if (i + 1 < GEN_CLASSES)
+        {
+            if (*end != ',')
+                return 1;
+
+            str = end + 1;
+        }
+    }
+
+    return sum == 0;
+}
+
+static void gen_usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [options]\n"
+            "\t-s seed        random seed (default 1)\n"
+            "\t-n num         static instructions in body (default 1000)\n"
+            "\t-l iterations  loop body iterations times, 1 means no loop (default 1)\n"
+            "\t-c chains      independent dependency chains, ILP (default 4, max %d)\n"
+            "\t-x percent     ops reading head of other chain (default 10)\n"
+            "\t-m weights     add,sub,mul,div,mod,load,store,branch (default 30,10,10,2,2,20,16,10)\n"
+            "\t-p pattern     memory pattern seq | stride | random | hot (default seq)\n"
+            "\t-a space       number of M addresses (default 4096)\n"
+            "\t-S stride      stride for stride pattern (default 16)\n"
+            "\t-o file        output file (default stdout)\n",
+            name, FREE_REGS);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    Gen_options options = {
+        .seed = 1,
+        .num_instr = 1000,
+        .iterations = 1,
+        .chains = 4,
+        .cross = 10,
+        .weight = { 30, 10, 10, 2, 2, 20, 16, 10 },
+        .pattern = PATTERN_SEQ,
+        .addr_space = 4096,
+        .stride = 16,
+        .out = NULL
+    };
+
+    while ((opt = getopt(argc, argv, "s:n:l:c:x:m:p:a:S:o:")) != -1)
+    {
+        switch (opt)
+        {
+            case 's':
+                options.seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'n':
+                options.num_instr = strtoull(optarg, NULL, 10);
+                break;
+            case 'l':
+                options.iterations = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'c':
+                options.chains = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'x':
+                options.cross = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'm':
+            {
+                if (gen_parse_weights(optarg, options.weight))
+                {
+                    fprintf(stderr, "Wrong weights %s\n", optarg);
+                    return 1;
+                }
+                break;
+            }
+            case 'p':
+            {
+                if (strcmp(optarg, "seq") == 0)
+                    options.pattern = PATTERN_SEQ;
+                else if (strcmp(optarg, "stride") == 0)
+                    options.pattern = PATTERN_STRIDE;
+                else if (strcmp(optarg, "random") == 0)
+                    options.pattern = PATTERN_RANDOM;
+                else if (strcmp(optarg, "hot") == 0)
+                    options.pattern = PATTERN_HOT;
+                else
+                {
+                    gen_usage(argv[0]);
+                    return 1;
+                }
+                break;
+            }
+            case 'a':
+                options.addr_space = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'S':
+                options.stride = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+            case 'o':
+                options.out = optarg;
+                break;
+            default:
+            {
+                gen_usage(argv[0]);
+                return 1;
+            }
+        }
+    }
+
+    if (options.chains == 0 || options.chains > FREE_REGS || options.addr_space == 0 || options.iterations == 0)
+    {
+        gen_usage(argv[0]);
+        return 1;
+    }
+
+    return gen_program(&options);
+}
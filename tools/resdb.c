@@ -0,0 +1,1754 @@
+/*
+    Columnar store of sweep results and query tool.
+
+    pack converts TSV (header with column names, one row per run) to columnar file:
+    column type is inferred from values (int64, double or string), string columns
+    are dictionary encoded. query mmaps the file and touches only columns it needs,
+    so memory usage does not depend on number of rows (except selection bitmap, 1 bit per row).
+
+    File layout (every section is 8 byte aligned):
+        column data     num_rows values per column (int64_t, double or uint32_t code)
+        dictionaries    NUL terminated strings of string columns, in order of codes
+        zone maps       double min / max per RESDB_BLOCK_ROWS rows per column
+        footer          Resdb_column per column
+        trailer         Resdb_trailer
+
+    Zone maps let filter skip or accept whole blocks without reading values.
+
+    Author: Michal Kukowski
+    email: michalkukowski10@gmail.com
+
+    LICENCE: GPL 3.0
+*/
+
+#define _GNU_SOURCE
+
+#include <log.h>
+#include <common.h>
+#include <compiler.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define RESDB_MAGIC         0x3142445345524d54ULL /* "TMRESDB1" */
+#define RESDB_VERSION       1
+#define RESDB_NAME_SIZE     32
+#define RESDB_MAX_COLUMNS   64
+#define RESDB_MAX_FILTERS   16
+#define RESDB_BLOCK_ROWS    65536 /* rows per zone, multiple of 64 */
+#define RESDB_DEFAULT_LIMIT 10
+
+#define RESDB_ALIGN(x)      (((x) + 7) & ~(uint64_t)7)
+
+typedef enum resdb_type_t
+{
+    RESDB_INT,
+    RESDB_REAL,
+    RESDB_STR
+} resdb_type_t;
+
+typedef enum resdb_op_t
+{
+    RESDB_EQ,
+    RESDB_NE,
+    RESDB_LT,
+    RESDB_LE,
+    RESDB_GT,
+    RESDB_GE
+} resdb_op_t;
+
+typedef struct Resdb_column
+{
+    char name[RESDB_NAME_SIZE];
+    uint32_t type;
+    uint32_t num_strings; /* dictionary size of string column */
+    uint64_t data; /* offset of values */
+    uint64_t dict; /* offset of dictionary */
+    uint64_t zones; /* offset of zone map */
+    double min;
+    double max;
+} Resdb_column;
+
+typedef struct Resdb_trailer
+{
+    uint64_t footer; /* offset of first Resdb_column */
+    uint64_t num_rows;
+    uint32_t num_columns;
+    uint32_t version;
+    uint64_t magic;
+} Resdb_trailer;
+
+/* opened (mmaped) file */
+typedef struct Resdb
+{
+    const uint8_t *base;
+    size_t size;
+    uint64_t num_rows;
+    uint32_t num_columns;
+    const Resdb_column *columns;
+    const char **strings[RESDB_MAX_COLUMNS]; /* dictionary of string column by code */
+} Resdb;
+
+/* string to code map used by pack */
+typedef struct Resdb_dict
+{
+    char **strings; /* by code */
+    uint32_t num_strings;
+    uint32_t *table; /* code + 1, 0 iff empty slot */
+    size_t table_size;
+    uint64_t bytes; /* size of strings with NULs */
+} Resdb_dict;
+
+typedef struct Resdb_filter
+{
+    uint32_t col;
+    resdb_op_t op;
+    double val; /* code for string column, -1 iff string is not in dictionary */
+} Resdb_filter;
+
+typedef struct Resdb_query
+{
+    const char *filter[RESDB_MAX_FILTERS];
+    size_t num_filters;
+    const char *group; /* columns to group by */
+    const char *metrics; /* columns aggregated in groups */
+    const char *pareto; /* objectives min:col / max:col */
+    const char *columns; /* columns to print, NULL iff all */
+    uint64_t limit; /* rows to print, 0 iff all */
+} Resdb_query;
+
+typedef struct Resdb_group
+{
+    uint64_t row; /* first row of group, key is printed from it */
+    uint64_t count;
+} Resdb_group;
+
+typedef struct Resdb_agg
+{
+    double sum;
+    double min;
+    double max;
+} Resdb_agg;
+
+/* list of columns, objectives are negated for max */
+typedef struct Resdb_cols
+{
+    uint32_t col[RESDB_MAX_COLUMNS];
+    bool max[RESDB_MAX_COLUMNS];
+    size_t num;
+} Resdb_cols;
+
+/* pareto front is sorted by first objective */
+static const Resdb *resdb_sort_db;
+static const Resdb_cols *resdb_sort_objectives;
+
+/*
+    Get value of column in row as double (code for string column)
+
+    PARAMS
+    @IN db - pointer to Resdb
+    @IN col - column index
+    @IN row - row index
+
+    RETURN
+    Value
+*/
+static ___inline___ double resdb_value(const Resdb *db, uint32_t col, uint64_t row);
+
+/*
+    Get raw bits of value, equal values have equal bits
+
+    PARAMS
+    @IN db - pointer to Resdb
+    @IN col - column index
+    @IN row - row index
+
+    RETURN
+    Raw value
+*/
+static ___inline___ uint64_t resdb_raw(const Resdb *db, uint32_t col, uint64_t row);
+
+/*
+    Check operator on value
+
+    PARAMS
+    @IN op - operator
+    @IN x - value from column
+    @IN val - value from filter
+
+    RETURN
+    true iff x op val
+*/
+static ___inline___ bool resdb_op_match(resdb_op_t op, double x, double val);
+
+/*
+    Check operator on zone
+
+    PARAMS
+    @IN op - operator
+    @IN val - value from filter
+    @IN min - min value in zone
+    @IN max - max value in zone
+
+    RETURN
+    0 iff no value matches, 1 iff all values match, 2 iff values have to be checked
+*/
+static int resdb_op_zone(resdb_op_t op, double val, double min, double max);
+
+/*
+    Split line by tabs in place, new line is removed
+
+    PARAMS
+    @IN line - line
+    @OUT fields - pointers to fields
+    @IN max - max number of fields
+
+    RETURN
+    Number of fields (max + 1 iff line has more fields)
+*/
+static size_t resdb_split(char *line, char **fields, size_t max);
+
+/*
+    Get type of field
+
+    PARAMS
+    @IN field - field
+
+    RETURN
+    RESDB_INT, RESDB_REAL or RESDB_STR
+*/
+static resdb_type_t resdb_classify(const char *field);
+
+/*
+    Get code of string, string is added iff it is not in dictionary
+
+    PARAMS
+    @IN dict - pointer to Resdb_dict
+    @IN str - string
+
+    RETURN
+    UINT32_MAX iff failure
+    Code iff success
+*/
+static uint32_t resdb_dict_code(Resdb_dict *dict, const char *str);
+
+/*
+    Destroy dictionary
+
+    PARAMS
+    @IN dict - pointer to Resdb_dict
+
+    RETURN
+    This is a void function
+*/
+static void resdb_dict_destroy(Resdb_dict *dict);
+
+/*
+    Write whole buffer at offset, offset is moved
+
+    PARAMS
+    @IN fd - file descriptor
+    @IN buf - buffer
+    @IN size - size of buffer
+    @IN offset - pointer to offset
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int resdb_write(int fd, const void *buf, size_t size, uint64_t *offset);
+
+/*
+    Convert TSV to columnar file
+
+    PARAMS
+    @IN in_path - path to TSV
+    @IN out_path - path to columnar file
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int resdb_pack(const char *in_path, const char *out_path);
+
+/*
+    Map columnar file
+
+    PARAMS
+    @OUT db - pointer to Resdb
+    @IN path - path to file
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int resdb_open(Resdb *db, const char *path);
+
+/*
+    Unmap columnar file
+
+    PARAMS
+    @IN db - pointer to Resdb
+
+    RETURN
+    This is a void function
+*/
+static void resdb_close(Resdb *db);
+
+/*
+    Find column by name
+
+    PARAMS
+    @IN db - pointer to Resdb
+    @IN name - name of column
+    @IN len - length of name
+
+    RETURN
+    UINT32_MAX iff column does not exist
+    Column index iff success
+*/
+static uint32_t resdb_find(const Resdb *db, const char *name, size_t len);
+
+/*
+    Parse comma separated columns, objectives have prefix min: or max:
+
+    PARAMS
+    @IN db - pointer to Resdb
+    @IN str - list of columns
+    @IN objectives - true iff columns have direction prefix
+    @OUT cols - pointer to Resdb_cols
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int resdb_parse_cols(const Resdb *db, const char *str, bool objectives, Resdb_cols *cols);
+
+/*
+    Parse filter col<op>value
+
+    PARAMS
+    @IN db - pointer to Resdb
+    @IN str - filter
+    @OUT filter - pointer to Resdb_filter
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int resdb_parse_filter(const Resdb *db, const char *str, Resdb_filter *filter);
+
+/*
+    Clear bits of rows not matching filter, zone maps are used to skip blocks
+
+    PARAMS
+    @IN db - pointer to Resdb
+    @IN filter - pointer to Resdb_filter
+    @IN sel - selection bitmap
+
+    RETURN
+    This is a void function
+*/
+static void resdb_filter(const Resdb *db, const Resdb_filter *filter, uint64_t *sel);
+
+/*
+    Print value of column in row
+
+    PARAMS
+    @IN db - pointer to Resdb
+    @IN col - column index
+    @IN row - row index
+
+    RETURN
+    This is a void function
+*/
+static void resdb_print_value(const Resdb *db, uint32_t col, uint64_t row);
+
+/*
+    Print selected rows
+
+    PARAMS
+    @IN db - pointer to Resdb
+    @IN sel - selection bitmap
+    @IN cols - columns to print
+    @IN limit - max rows, 0 iff all
+
+    RETURN
+    This is a void function
+*/
+static void resdb_print_rows(const Resdb *db, const uint64_t *sel, const Resdb_cols *cols, uint64_t limit);
+
+/*
+    Group selected rows and print count, mean, min and max of metrics per group
+
+    PARAMS
+    @IN db - pointer to Resdb
+    @IN sel - selection bitmap
+    @IN keys - columns to group by
+    @IN metrics - columns to aggregate
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int resdb_group(const Resdb *db, const uint64_t *sel, const Resdb_cols *keys, const Resdb_cols *metrics);
+
+/*
+    Check if row a dominates row b
+
+    PARAMS
+    @IN db - pointer to Resdb
+    @IN objectives - objectives
+    @IN a - row index
+    @IN b - row index
+
+    RETURN
+    true iff a is not worse in any objective and better in at least one
+*/
+static bool resdb_dominates(const Resdb *db, const Resdb_cols *objectives, uint64_t a, uint64_t b);
+
+/*
+    Compare rows by objectives for qsort
+
+    PARAMS
+    @IN a - pointer to row index
+    @IN b - pointer to row index
+
+    RETURN
+    < 0 iff a is before b, 0 iff equal, > 0 iff a is after b
+*/
+static int resdb_cmp_objectives(const void *a, const void *b);
+
+/*
+    Find and print pareto front of selected rows (block nested loop, one pass over rows)
+
+    PARAMS
+    @IN db - pointer to Resdb
+    @IN sel - selection bitmap
+    @IN objectives - objectives
+    @IN cols - columns to print
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int resdb_pareto(const Resdb *db, const uint64_t *sel, const Resdb_cols *objectives, const Resdb_cols *cols);
+
+/*
+    Print columns of file
+
+    PARAMS
+    @IN path - path to columnar file
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int resdb_info(const char *path);
+
+/*
+    Run query on columnar file
+
+    PARAMS
+    @IN path - path to columnar file
+    @IN query - pointer to Resdb_query
+
+    RETURN
+    0 iff success
+    Non-zero value iff failure
+*/
+static int resdb_query(const char *path, const Resdb_query *query);
+
+/*
+    Print usage on stderr
+
+    PARAMS
+    @IN name - program name
+
+    RETURN
+    This is a void function
+*/
+static void resdb_usage(const char *name);
+
+static ___inline___ double resdb_value(const Resdb *db, uint32_t col, uint64_t row)
+{
+    const Resdb_column *column = &db->columns[col];
+
+    switch (column->type)
+    {
+        case RESDB_INT:
+            return (double)((const int64_t *)(const void *)(db->base + column->data))[row];
+        case RESDB_REAL:
+            return ((const double *)(const void *)(db->base + column->data))[row];
+        default:
+            return (double)((const uint32_t *)(const void *)(db->base + column->data))[row];
+    }
+}
+
+static ___inline___ uint64_t resdb_raw(const Resdb *db, uint32_t col, uint64_t row)
+{
+    const Resdb_column *column = &db->columns[col];
+
+    switch (column->type)
+    {
+        case RESDB_INT:
+        case RESDB_REAL:
+            return ((const uint64_t *)(const void *)(db->base + column->data))[row];
+        default:
+            return ((const uint32_t *)(const void *)(db->base + column->data))[row];
+    }
+}
+
+static ___inline___ bool resdb_op_match(resdb_op_t op, double x, double val)
+{
+    switch (op)
+    {
+        case RESDB_EQ:
+            return x == val;
+        case RESDB_NE:
+            return x != val;
+        case RESDB_LT:
+            return x < val;
+        case RESDB_LE:
+            return x <= val;
+        case RESDB_GT:
+            return x > val;
+        case RESDB_GE:
+            return x >= val;
+        default:
+            return false;
+    }
+}
+
+static int resdb_op_zone(resdb_op_t op, double val, double min, double max)
+{
+    switch (op)
+    {
+        case RESDB_EQ:
+        {
+            if (val < min || val > max)
+                return 0;
+            if (min == val && max == val)
+                return 1;
+            break;
+        }
+        case RESDB_NE:
+        {
+            if (min == val && max == val)
+                return 0;
+            if (val < min || val > max)
+                return 1;
+            break;
+        }
+        case RESDB_LT:
+        {
+            if (min >= val)
+                return 0;
+            if (max < val)
+                return 1;
+            break;
+        }
+        case RESDB_LE:
+        {
+            if (min > val)
+                return 0;
+            if (max <= val)
+                return 1;
+            break;
+        }
+        case RESDB_GT:
+        {
+            if (max <= val)
+                return 0;
+            if (min > val)
+                return 1;
+            break;
+        }
+        case RESDB_GE:
+        {
+            if (max < val)
+                return 0;
+            if (min >= val)
+                return 1;
+            break;
+        }
+        default:
+            break;
+    }
+
+    return 2;
+}
+
+static size_t resdb_split(char *line, char **fields, size_t max)
+{
+    size_t num = 0;
+    size_t len = strlen(line);
+
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+        line[--len] = '\0';
+
+    for (;;)
+    {
+        char *tab = strchr(line, '\t');
+
+        if (num == max)
+            return max + 1;
+
+        fields[num++] = line;
+        if (tab == NULL)
+            break;
+
+        *tab = '\0';
+        line = tab + 1;
+    }
+
+    return num;
+}
+
+static resdb_type_t resdb_classify(const char *field)
+{
+    char *end;
+
+    if (*field == '\0')
+        return RESDB_STR;
+
+    errno = 0;
+    (void)strtoll(field, &end, 10);
+    if (*end == '\0' && errno == 0)
+        return RESDB_INT;
+
+    (void)strtod(field, &end);
+    if (*end == '\0')
+        return RESDB_REAL;
+
+    return RESDB_STR;
+}
+
+static uint32_t resdb_dict_code(Resdb_dict *dict, const char *str)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const char *c;
+    size_t i;
+
+    if ((size_t)dict->num_strings * 2 >= dict->table_size)
+    {
+        size_t size = dict->table_size == 0 ? 64 : dict->table_size * 2;
+        uint32_t *table = calloc(size, sizeof(*table));
+        char **strings = realloc(dict->strings, sizeof(*strings) * size / 2);
+
+        if (table == NULL || strings == NULL)
+        {
+            FREE(table);
+            if (strings != NULL)
+                dict->strings = strings;
+
+            return UINT32_MAX;
+        }
+
+        dict->strings = strings;
+        for (i = 0; i < dict->num_strings; ++i)
+        {
+            uint64_t h = 0xcbf29ce484222325ULL;
+            size_t slot;
+
+            for (c = dict->strings[i]; *c != '\0'; ++c)
+                h = (h ^ (uint8_t)*c) * 0x100000001b3ULL;
+
+            for (slot = h & (size - 1); table[slot] != 0; slot = (slot + 1) & (size - 1))
+                ;
+            table[slot] = (uint32_t)i + 1;
+        }
+
+        FREE(dict->table);
+        dict->table = table;
+        dict->table_size = size;
+    }
+
+    for (c = str; *c != '\0'; ++c)
+        hash = (hash ^ (uint8_t)*c) * 0x100000001b3ULL;
+
+    for (i = hash & (dict->table_size - 1); dict->table[i] != 0; i = (i + 1) & (dict->table_size - 1))
+        if (strcmp(dict->strings[dict->table[i] - 1], str) == 0)
+            return dict->table[i] - 1;
+
+    dict->strings[dict->num_strings] = strdup(str);
+    if (dict->strings[dict->num_strings] == NULL)
+        return UINT32_MAX;
+
+    dict->table[i] = ++dict->num_strings;
+    dict->bytes += strlen(str) + 1;
+
+    return dict->num_strings - 1;
+}
+
+static void resdb_dict_destroy(Resdb_dict *dict)
+{
+    uint32_t i;
+
+    for (i = 0; i < dict->num_strings; ++i)
+        FREE(dict->strings[i]);
+
+    FREE(dict->strings);
+    FREE(dict->table);
+}
+
+static int resdb_write(int fd, const void *buf, size_t size, uint64_t *offset)
+{
+    const uint8_t *ptr = (const uint8_t *)buf;
+
+    while (size > 0)
+    {
+        ssize_t ret = pwrite(fd, ptr, size, (off_t)*offset);
+
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return 1;
+        }
+
+        ptr += ret;
+        size -= (size_t)ret;
+        *offset += (uint64_t)ret;
+    }
+
+    return 0;
+}
+
+static int resdb_pack(const char *in_path, const char *out_path)
+{
+    FILE *in;
+    int fd = -1;
+    char *line = NULL;
+    size_t line_size = 0;
+    char *fields[RESDB_MAX_COLUMNS];
+    size_t num_fields;
+    Resdb_column columns[RESDB_MAX_COLUMNS];
+    Resdb_dict dicts[RESDB_MAX_COLUMNS];
+    double *zones[RESDB_MAX_COLUMNS];
+    Resdb_trailer trailer;
+    uint32_t num_columns;
+    uint64_t num_rows = 0;
+    uint64_t num_blocks;
+    uint64_t offset = 0;
+    uint64_t row;
+    uint8_t *map = NULL;
+    uint32_t i;
+    int ret = 1;
+    static const uint8_t zeros[8];
+
+    TRACE();
+
+    (void)memset(columns, 0, sizeof(columns));
+    (void)memset(dicts, 0, sizeof(dicts));
+    (void)memset(zones, 0, sizeof(zones));
+
+    in = fopen(in_path, "r");
+    if (in == NULL)
+        ERROR("fopen error\n", 1);
+
+    /* header */
+    if (getline(&line, &line_size, in) < 0)
+    {
+        fprintf(stderr, "%s: no header\n", in_path);
+        goto out;
+    }
+
+    num_fields = resdb_split(line, fields, RESDB_MAX_COLUMNS);
+    if (num_fields > RESDB_MAX_COLUMNS)
+    {
+        fprintf(stderr, "%s: more than %d columns\n", in_path, RESDB_MAX_COLUMNS);
+        goto out;
+    }
+
+    num_columns = (uint32_t)num_fields;
+    for (i = 0; i < num_columns; ++i)
+    {
+        if (fields[i][0] == '\0' || strlen(fields[i]) >= RESDB_NAME_SIZE)
+        {
+            fprintf(stderr, "%s: wrong column name \"%s\"\n", in_path, fields[i]);
+            goto out;
+        }
+
+        (void)strcpy(columns[i].name, fields[i]);
+        columns[i].type = RESDB_INT;
+        columns[i].min = INFINITY;
+        columns[i].max = -INFINITY;
+    }
+
+    /* first pass: number of rows and types */
+    while (getline(&line, &line_size, in) >= 0)
+    {
+        num_fields = resdb_split(line, fields, RESDB_MAX_COLUMNS);
+        if (num_fields != num_columns)
+        {
+            fprintf(stderr, "%s:%" PRIu64 ": expected %u fields\n", in_path, num_rows + 2, num_columns);
+            goto out;
+        }
+
+        for (i = 0; i < num_columns; ++i)
+            if (columns[i].type != RESDB_STR)
+            {
+                resdb_type_t type = resdb_classify(fields[i]);
+
+                if (type > columns[i].type)
+                    columns[i].type = type;
+            }
+
+        ++num_rows;
+    }
+
+    num_blocks = (num_rows + RESDB_BLOCK_ROWS - 1) / RESDB_BLOCK_ROWS;
+    for (i = 0; i < num_columns; ++i)
+    {
+        columns[i].data = offset;
+        offset = RESDB_ALIGN(offset + num_rows * (columns[i].type == RESDB_STR ? sizeof(uint32_t) : sizeof(uint64_t)));
+
+        zones[i] = malloc(sizeof(double) * 2 * (num_blocks == 0 ? 1 : num_blocks));
+        if (zones[i] == NULL)
+        {
+            fprintf(stderr, "malloc error\n");
+            goto out;
+        }
+    }
+
+    fd = open(out_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, (off_t)offset) != 0)
+    {
+        fprintf(stderr, "%s: %s\n", out_path, strerror(errno));
+        goto out;
+    }
+
+    if (offset > 0)
+    {
+        map = mmap(NULL, offset, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED)
+        {
+            map = NULL;
+            fprintf(stderr, "mmap error\n");
+            goto out;
+        }
+    }
+
+    /* second pass: values, dictionaries and zone maps */
+    rewind(in);
+    if (getline(&line, &line_size, in) < 0)
+        goto out;
+
+    for (row = 0; row < num_rows && getline(&line, &line_size, in) >= 0; ++row)
+    {
+        const uint64_t block = row / RESDB_BLOCK_ROWS;
+
+        if (resdb_split(line, fields, RESDB_MAX_COLUMNS) != num_columns)
+        {
+            fprintf(stderr, "%s: file changed while packing\n", in_path);
+            goto out;
+        }
+
+        for (i = 0; i < num_columns; ++i)
+        {
+            double val;
+
+            switch (columns[i].type)
+            {
+                case RESDB_INT:
+                {
+                    int64_t x = strtoll(fields[i], NULL, 10);
+
+                    ((int64_t *)(void *)(map + columns[i].data))[row] = x;
+                    val = (double)x;
+                    break;
+                }
+                case RESDB_REAL:
+                {
+                    val = strtod(fields[i], NULL);
+                    ((double *)(void *)(map + columns[i].data))[row] = val;
+                    break;
+                }
+                default:
+                {
+                    uint32_t code = resdb_dict_code(&dicts[i], fields[i]);
+
+                    if (code == UINT32_MAX)
+                    {
+                        fprintf(stderr, "resdb_dict_code error\n");
+                        goto out;
+                    }
+
+                    ((uint32_t *)(void *)(map + columns[i].data))[row] = code;
+                    val = (double)code;
+                    break;
+                }
+            }
+
+            if (row % RESDB_BLOCK_ROWS == 0)
+            {
+                zones[i][2 * block] = val;
+                zones[i][2 * block + 1] = val;
+            }
+            else
+            {
+                if (val < zones[i][2 * block])
+                    zones[i][2 * block] = val;
+                if (val > zones[i][2 * block + 1])
+                    zones[i][2 * block + 1] = val;
+            }
+
+            if (val < columns[i].min)
+                columns[i].min = val;
+            if (val > columns[i].max)
+                columns[i].max = val;
+        }
+    }
+
+    if (row != num_rows)
+    {
+        fprintf(stderr, "%s: file changed while packing\n", in_path);
+        goto out;
+    }
+
+    if (map != NULL)
+    {
+        (void)munmap(map, offset);
+        map = NULL;
+    }
+
+    /* dictionaries */
+    for (i = 0; i < num_columns; ++i)
+    {
+        uint32_t j;
+
+        if (columns[i].type != RESDB_STR)
+            continue;
+
+        columns[i].dict = offset;
+        columns[i].num_strings = dicts[i].num_strings;
+        for (j = 0; j < dicts[i].num_strings; ++j)
+            if (resdb_write(fd, dicts[i].strings[j], strlen(dicts[i].strings[j]) + 1, &offset))
+                goto write_error;
+    }
+
+    if (resdb_write(fd, zeros, RESDB_ALIGN(offset) - offset, &offset))
+        goto write_error;
+
+    /* zone maps */
+    for (i = 0; i < num_columns; ++i)
+    {
+        columns[i].zones = offset;
+        if (resdb_write(fd, zones[i], sizeof(double) * 2 * num_blocks, &offset))
+            goto write_error;
+    }
+
+    /* footer */
+    trailer.footer = offset;
+    trailer.num_rows = num_rows;
+    trailer.num_columns = num_columns;
+    trailer.version = RESDB_VERSION;
+    trailer.magic = RESDB_MAGIC;
+
+    if (resdb_write(fd, columns, sizeof(*columns) * num_columns, &offset) ||
+        resdb_write(fd, &trailer, sizeof(trailer), &offset))
+        goto write_error;
+
+    ret = 0;
+    goto out;
+
+write_error:
+    fprintf(stderr, "%s: %s\n", out_path, strerror(errno));
+
+out:
+    if (map != NULL)
+        (void)munmap(map, offset);
+
+    if (fd >= 0)
+        (void)close(fd);
+
+    for (i = 0; i < RESDB_MAX_COLUMNS; ++i)
+    {
+        resdb_dict_destroy(&dicts[i]);
+        FREE(zones[i]);
+    }
+
+    FREE(line);
+    (void)fclose(in);
+
+    return ret;
+}
+
+static int resdb_open(Resdb *db, const char *path)
+{
+    int fd;
+    struct stat st;
+    Resdb_trailer trailer;
+    uint32_t i;
+
+    TRACE();
+
+    (void)memset(db, 0, sizeof(*db));
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(trailer))
+    {
+        fprintf(stderr, "%s: not a result file\n", path);
+        (void)close(fd);
+        return 1;
+    }
+
+    db->size = (size_t)st.st_size;
+    db->base = mmap(NULL, db->size, PROT_READ, MAP_SHARED, fd, 0);
+    (void)close(fd);
+
+    if (db->base == MAP_FAILED)
+    {
+        db->base = NULL;
+        ERROR("mmap error\n", 1);
+    }
+
+    /* columns are scanned once from start to end */
+    (void)madvise((void *)(uintptr_t)db->base, db->size, MADV_SEQUENTIAL);
+
+    (void)memcpy(&trailer, db->base + db->size - sizeof(trailer), sizeof(trailer));
+    if (trailer.magic != RESDB_MAGIC || trailer.version != RESDB_VERSION ||
+        trailer.num_columns > RESDB_MAX_COLUMNS ||
+        trailer.footer + sizeof(Resdb_column) * trailer.num_columns + sizeof(trailer) != db->size)
+    {
+        fprintf(stderr, "%s: not a result file\n", path);
+        resdb_close(db);
+        return 1;
+    }
+
+    db->num_rows = trailer.num_rows;
+    db->num_columns = trailer.num_columns;
+    db->columns = (const Resdb_column *)(const void *)(db->base + trailer.footer);
+
+    for (i = 0; i < db->num_columns; ++i)
+    {
+        const char *str;
+        uint32_t j;
+
+        if (db->columns[i].type != RESDB_STR)
+            continue;
+
+        db->strings[i] = malloc(sizeof(*db->strings[i]) * (db->columns[i].num_strings + 1));
+        if (db->strings[i] == NULL)
+        {
+            resdb_close(db);
+            ERROR("malloc error\n", 1);
+        }
+
+        str = (const char *)db->base + db->columns[i].dict;
+        for (j = 0; j < db->columns[i].num_strings; ++j)
+        {
+            db->strings[i][j] = str;
+            str += strlen(str) + 1;
+        }
+    }
+
+    return 0;
+}
+
+static void resdb_close(Resdb *db)
+{
+    uint32_t i;
+
+    for (i = 0; i < RESDB_MAX_COLUMNS; ++i)
+        FREE(db->strings[i]);
+
+    if (db->base != NULL)
+        (void)munmap((void *)(uintptr_t)db->base, db->size);
+
+    db->base = NULL;
+}
+
+static uint32_t resdb_find(const Resdb *db, const char *name, size_t len)
+{
+    uint32_t i;
+
+    for (i = 0; i < db->num_columns; ++i)
+        if (strlen(db->columns[i].name) == len && strncmp(db->columns[i].name, name, len) == 0)
+            return i;
+
+    fprintf(stderr, "No column %.*s\n", (int)len, name);
+
+    return UINT32_MAX;
+}
+
+static int resdb_parse_cols(const Resdb *db, const char *str, bool objectives, Resdb_cols *cols)
+{
+    cols->num = 0;
+
+    while (*str != '\0')
+    {
+        size_t len = strcspn(str, ",");
+        bool max = false;
+
+        if (cols->num == RESDB_MAX_COLUMNS)
+            return 1;
+
+        if (objectives)
+        {
+            if (strncmp(str, "max:", 4) == 0)
+                max = true;
+            else if (strncmp(str, "min:", 4) != 0)
+            {
+                fprintf(stderr, "Objective %.*s has to start with min: or max:\n", (int)len, str);
+                return 1;
+            }
+
+            str += 4;
+            len -= len < 4 ? len : 4;
+        }
+
+        cols->col[cols->num] = resdb_find(db, str, len);
+        if (cols->col[cols->num] == UINT32_MAX)
+            return 1;
+
+        cols->max[cols->num++] = max;
+
+        str += len;
+        if (*str == ',')
+            ++str;
+    }
+
+    return cols->num == 0;
+}
+
+static int resdb_parse_filter(const Resdb *db, const char *str, Resdb_filter *filter)
+{
+    static const struct
+    {
+        const char *str;
+        resdb_op_t op;
+    } ops[] = {
+        { "<=", RESDB_LE }, { ">=", RESDB_GE }, { "!=", RESDB_NE },
+        { "=", RESDB_EQ }, { "<", RESDB_LT }, { ">", RESDB_GT }
+    };
+    const size_t name_len = strcspn(str, "<>=!");
+    const char *val;
+    char *end;
+    size_t i;
+
+    filter->col = resdb_find(db, str, name_len);
+    if (filter->col == UINT32_MAX)
+        return 1;
+
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); ++i)
+        if (strncmp(str + name_len, ops[i].str, strlen(ops[i].str)) == 0)
+            break;
+
+    if (i == sizeof(ops) / sizeof(ops[0]))
+    {
+        fprintf(stderr, "Wrong filter %s\n", str);
+        return 1;
+    }
+
+    filter->op = ops[i].op;
+    val = str + name_len + strlen(ops[i].str);
+
+    if (db->columns[filter->col].type == RESDB_STR)
+    {
+        uint32_t j;
+
+        if (filter->op != RESDB_EQ && filter->op != RESDB_NE)
+        {
+            fprintf(stderr, "Only = and != on string column %s\n", db->columns[filter->col].name);
+            return 1;
+        }
+
+        filter->val = -1.0;
+        for (j = 0; j < db->columns[filter->col].num_strings; ++j)
+            if (strcmp(db->strings[filter->col][j], val) == 0)
+                filter->val = (double)j;
+
+        return 0;
+    }
+
+    filter->val = strtod(val, &end);
+    if (*val == '\0' || *end != '\0')
+    {
+        fprintf(stderr, "Wrong value in filter %s\n", str);
+        return 1;
+    }
+
+    return 0;
+}
+
+static void resdb_filter(const Resdb *db, const Resdb_filter *filter, uint64_t *sel)
+{
+    const Resdb_column *column = &db->columns[filter->col];
+    const double *zones = (const double *)(const void *)(db->base + column->zones);
+    const uint64_t num_blocks = (db->num_rows + RESDB_BLOCK_ROWS - 1) / RESDB_BLOCK_ROWS;
+    uint64_t block;
+
+    TRACE();
+
+    for (block = 0; block < num_blocks; ++block)
+    {
+        const uint64_t first = block * RESDB_BLOCK_ROWS;
+        const uint64_t last = first + RESDB_BLOCK_ROWS < db->num_rows ? first + RESDB_BLOCK_ROWS : db->num_rows;
+        uint64_t row;
+
+        switch (resdb_op_zone(filter->op, filter->val, zones[2 * block], zones[2 * block + 1]))
+        {
+            case 0:
+            {
+                (void)memset(&sel[first / 64], 0, sizeof(*sel) * ((last - first + 63) / 64));
+                break;
+            }
+            case 1:
+                break;
+            default:
+            {
+                for (row = first; row < last; ++row)
+                    if (!resdb_op_match(filter->op, resdb_value(db, filter->col, row), filter->val))
+                        sel[row / 64] &= ~(1ULL << (row % 64));
+                break;
+            }
+        }
+    }
+}
+
+static void resdb_print_value(const Resdb *db, uint32_t col, uint64_t row)
+{
+    const Resdb_column *column = &db->columns[col];
+
+    switch (column->type)
+    {
+        case RESDB_INT:
+        {
+            printf("%" PRId64, ((const int64_t *)(const void *)(db->base + column->data))[row]);
+            break;
+        }
+        case RESDB_REAL:
+        {
+            printf("%.6g", ((const double *)(const void *)(db->base + column->data))[row]);
+            break;
+        }
+        default:
+        {
+            printf("%s", db->strings[col][((const uint32_t *)(const void *)(db->base + column->data))[row]]);
+            break;
+        }
+    }
+}
+
+static void resdb_print_rows(const Resdb *db, const uint64_t *sel, const Resdb_cols *cols, uint64_t limit)
+{
+    uint64_t row;
+    uint64_t selected = 0;
+    size_t i;
+
+    for (i = 0; i < cols->num; ++i)
+        printf("%s%s", i == 0 ? "" : "\t", db->columns[cols->col[i]].name);
+    printf("\n");
+
+    for (row = 0; row < db->num_rows; ++row)
+    {
+        if (!(sel[row / 64] & (1ULL << (row % 64))))
+            continue;
+
+        if (limit == 0 || selected < limit)
+        {
+            for (i = 0; i < cols->num; ++i)
+            {
+                if (i > 0)
+                    printf("\t");
+                resdb_print_value(db, cols->col[i], row);
+            }
+            printf("\n");
+        }
+
+        ++selected;
+    }
+
+    printf("Selected %" PRIu64 " of %" PRIu64 " rows\n", selected, db->num_rows);
+}
+
+static int resdb_group(const Resdb *db, const uint64_t *sel, const Resdb_cols *keys, const Resdb_cols *metrics)
+{
+    Resdb_group *groups = NULL;
+    Resdb_agg *aggs = NULL;
+    uint32_t *table = NULL;
+    size_t num_groups = 0;
+    size_t max_groups = 0;
+    size_t table_size = 0;
+    uint64_t row;
+    size_t i;
+    size_t j;
+
+    TRACE();
+
+    for (row = 0; row < db->num_rows; ++row)
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        size_t slot;
+        Resdb_group *group = NULL;
+        Resdb_agg *agg;
+
+        if (!(sel[row / 64] & (1ULL << (row % 64))))
+            continue;
+
+        /* table is at most half full */
+        if (num_groups * 2 >= table_size)
+        {
+            const size_t size = table_size == 0 ? 256 : table_size * 2;
+            uint32_t *new_table = calloc(size, sizeof(*new_table));
+
+            if (new_table == NULL)
+                goto error;
+
+            for (i = 0; i < num_groups; ++i)
+            {
+                uint64_t h = 0xcbf29ce484222325ULL;
+
+                for (j = 0; j < keys->num; ++j)
+                    h = (h ^ resdb_raw(db, keys->col[j], groups[i].row)) * 0x100000001b3ULL;
+
+                for (slot = h & (size - 1); new_table[slot] != 0; slot = (slot + 1) & (size - 1))
+                    ;
+                new_table[slot] = (uint32_t)i + 1;
+            }
+
+            FREE(table);
+            table = new_table;
+            table_size = size;
+        }
+
+        for (j = 0; j < keys->num; ++j)
+            hash = (hash ^ resdb_raw(db, keys->col[j], row)) * 0x100000001b3ULL;
+
+        for (slot = hash & (table_size - 1); table[slot] != 0; slot = (slot + 1) & (table_size - 1))
+        {
+            group = &groups[table[slot] - 1];
+            for (j = 0; j < keys->num; ++j)
+                if (resdb_raw(db, keys->col[j], row) != resdb_raw(db, keys->col[j], group->row))
+                    break;
+
+            if (j == keys->num)
+                break;
+
+            group = NULL;
+        }
+
+        if (group == NULL)
+        {
+            if (num_groups == max_groups)
+            {
+                const size_t size = max_groups == 0 ? 64 : max_groups * 2;
+                Resdb_group *new_groups = realloc(groups, sizeof(*groups) * size);
+                Resdb_agg *new_aggs;
+
+                if (new_groups == NULL)
+                    goto error;
+                groups = new_groups;
+
+                new_aggs = realloc(aggs, sizeof(*aggs) * size * (metrics->num == 0 ? 1 : metrics->num));
+                if (new_aggs == NULL)
+                    goto error;
+                aggs = new_aggs;
+
+                max_groups = size;
+            }
+
+            group = &groups[num_groups];
+            group->row = row;
+            group->count = 0;
+
+            agg = &aggs[num_groups * metrics->num];
+            for (j = 0; j < metrics->num; ++j)
+            {
+                agg[j].sum = 0.0;
+                agg[j].min = INFINITY;
+                agg[j].max = -INFINITY;
+            }
+
+            table[slot] = (uint32_t)++num_groups;
+        }
+
+        ++group->count;
+        agg = &aggs[(size_t)(group - groups) * metrics->num];
+        for (j = 0; j < metrics->num; ++j)
+        {
+            const double val = resdb_value(db, metrics->col[j], row);
+
+            agg[j].sum += val;
+            if (val < agg[j].min)
+                agg[j].min = val;
+            if (val > agg[j].max)
+                agg[j].max = val;
+        }
+    }
+
+    for (j = 0; j < keys->num; ++j)
+        printf("%s\t", db->columns[keys->col[j]].name);
+    printf("count");
+    for (j = 0; j < metrics->num; ++j)
+        printf("\tmean_%s\tmin_%s\tmax_%s", db->columns[metrics->col[j]].name,
+               db->columns[metrics->col[j]].name, db->columns[metrics->col[j]].name);
+    printf("\n");
+
+    for (i = 0; i < num_groups; ++i)
+    {
+        const Resdb_agg *agg = &aggs[i * metrics->num];
+
+        for (j = 0; j < keys->num; ++j)
+        {
+            resdb_print_value(db, keys->col[j], groups[i].row);
+            printf("\t");
+        }
+
+        printf("%" PRIu64, groups[i].count);
+        for (j = 0; j < metrics->num; ++j)
+            printf("\t%.6g\t%.6g\t%.6g", agg[j].sum / (double)groups[i].count, agg[j].min, agg[j].max);
+        printf("\n");
+    }
+
+    printf("%zu groups\n", num_groups);
+
+    FREE(table);
+    FREE(groups);
+    FREE(aggs);
+
+    return 0;
+
+error:
+    FREE(table);
+    FREE(groups);
+    FREE(aggs);
+
+    ERROR("malloc error\n", 1);
+}
+
+static bool resdb_dominates(const Resdb *db, const Resdb_cols *objectives, uint64_t a, uint64_t b)
+{
+    bool better = false;
+    size_t i;
+
+    for (i = 0; i < objectives->num; ++i)
+    {
+        double x = resdb_value(db, objectives->col[i], a);
+        double y = resdb_value(db, objectives->col[i], b);
+
+        if (objectives->max[i])
+        {
+            x = -x;
+            y = -y;
+        }
+
+        if (x > y)
+            return false;
+
+        if (x < y)
+            better = true;
+    }
+
+    return better;
+}
+
+static int resdb_cmp_objectives(const void *a, const void *b)
+{
+    const uint64_t ra = *(const uint64_t *)a;
+    const uint64_t rb = *(const uint64_t *)b;
+    size_t i;
+
+    for (i = 0; i < resdb_sort_objectives->num; ++i)
+    {
+        double x = resdb_value(resdb_sort_db, resdb_sort_objectives->col[i], ra);
+        double y = resdb_value(resdb_sort_db, resdb_sort_objectives->col[i], rb);
+
+        if (resdb_sort_objectives->max[i])
+        {
+            x = -x;
+            y = -y;
+        }
+
+        if (x != y)
+            return x < y ? -1 : 1;
+    }
+
+    return ra < rb ? -1 : ra > rb;
+}
+
+static int resdb_pareto(const Resdb *db, const uint64_t *sel, const Resdb_cols *objectives, const Resdb_cols *cols)
+{
+    uint64_t *front = NULL;
+    size_t front_size = 0;
+    size_t max_front = 0;
+    uint64_t row;
+    size_t i;
+    size_t j;
+    size_t k;
+
+    TRACE();
+
+    for (row = 0; row < db->num_rows; ++row)
+    {
+        bool dominated = false;
+
+        if (!(sel[row / 64] & (1ULL << (row % 64))))
+            continue;
+
+        /* drop rows dominated by new row, stop iff new row is dominated */
+        for (j = 0, k = 0; j < front_size; ++j)
+        {
+            if (resdb_dominates(db, objectives, front[j], row))
+            {
+                dominated = true;
+                (void)memmove(&front[k], &front[j], sizeof(*front) * (front_size - j));
+                k += front_size - j;
+                break;
+            }
+
+            if (!resdb_dominates(db, objectives, row, front[j]))
+                front[k++] = front[j];
+        }
+
+        front_size = k;
+        if (dominated)
+            continue;
+
+        if (front_size == max_front)
+        {
+            const size_t size = max_front == 0 ? 64 : max_front * 2;
+            uint64_t *new_front = realloc(front, sizeof(*front) * size);
+
+            if (new_front == NULL)
+            {
+                FREE(front);
+                ERROR("malloc error\n", 1);
+            }
+
+            front = new_front;
+            max_front = size;
+        }
+
+        front[front_size++] = row;
+    }
+
+    resdb_sort_db = db;
+    resdb_sort_objectives = objectives;
+    qsort(front, front_size, sizeof(*front), resdb_cmp_objectives);
+
+    for (i = 0; i < cols->num; ++i)
+        printf("%s%s", i == 0 ? "" : "\t", db->columns[cols->col[i]].name);
+    printf("\n");
+
+    for (j = 0; j < front_size; ++j)
+    {
+        for (i = 0; i < cols->num; ++i)
+        {
+            if (i > 0)
+                printf("\t");
+            resdb_print_value(db, cols->col[i], front[j]);
+        }
+        printf("\n");
+    }
+
+    printf("Pareto front %zu rows\n", front_size);
+    FREE(front);
+
+    return 0;
+}
+
+static int resdb_info(const char *path)
+{
+    Resdb db;
+    uint32_t i;
+    static const char *const types[] = { "int", "real", "str" };
+
+    if (resdb_open(&db, path))
+        return 1;
+
+    printf("%s: %" PRIu64 " rows, %u columns, %zu bytes\n", path, db.num_rows, db.num_columns, db.size);
+    for (i = 0; i < db.num_columns; ++i)
+    {
+        const Resdb_column *column = &db.columns[i];
+
+        printf("\t%-24s %-4s ", column->name, types[column->type]);
+        if (column->type == RESDB_STR)
+            printf("%u strings\n", column->num_strings);
+        else if (db.num_rows > 0)
+            printf("%.6g .. %.6g\n", column->min, column->max);
+        else
+            printf("\n");
+    }
+
+    resdb_close(&db);
+
+    return 0;
+}
+
+static int resdb_query(const char *path, const Resdb_query *query)
+{
+    Resdb db;
+    Resdb_filter filter;
+    Resdb_cols cols;
+    Resdb_cols keys;
+    Resdb_cols metrics;
+    uint64_t *sel;
+    size_t i;
+    int ret = 1;
+
+    TRACE();
+
+    if (resdb_open(&db, path))
+        return 1;
+
+    sel = malloc(sizeof(*sel) * ((db.num_rows + 63) / 64 + 1));
+    if (sel == NULL)
+    {
+        resdb_close(&db);
+        ERROR("malloc error\n", 1);
+    }
+
+    /* all rows are selected, filters clear bits */
+    (void)memset(sel, 0xff, sizeof(*sel) * ((db.num_rows + 63) / 64 + 1));
+
+    for (i = 0; i < query->num_filters; ++i)
+    {
+        if (resdb_parse_filter(&db, query->filter[i], &filter))
+            goto out;
+
+        resdb_filter(&db, &filter, sel);
+    }
+
+    if (query->columns != NULL)
+    {
+        if (resdb_parse_cols(&db, query->columns, false, &cols))
+            goto out;
+    }
+    else
+    {
+        for (cols.num = 0; cols.num < db.num_columns; ++cols.num)
+            cols.col[cols.num] = (uint32_t)cols.num;
+    }
+
+    if (query->pareto != NULL)
+    {
+        if (resdb_parse_cols(&db, query->pareto, true, &keys))
+            goto out;
+
+        ret = resdb_pareto(&db, sel, &keys, &cols);
+    }
+    else if (query->group != NULL)
+    {
+        metrics.num = 0;
+        if (resdb_parse_cols(&db, query->group, false, &keys) ||
+            (query->metrics != NULL && resdb_parse_cols(&db, query->metrics, false, &metrics)))
+            goto out;
+
+        ret = resdb_group(&db, sel, &keys, &metrics);
+    }
+    else
+    {
+        resdb_print_rows(&db, sel, &cols, query->limit);
+        ret = 0;
+    }
+
+out:
+    FREE(sel);
+    resdb_close(&db);
+
+    return ret;
+}
+
+static void resdb_usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s pack input.tsv output.res\n"
+            "       %s info file.res\n"
+            "       %s query [options] file.res\n"
+            "\t-w col<op>value  filter, op is = != < <= > >= (many -w are joined by and)\n"
+            "\t-g col,...       group by columns\n"
+            "\t-m col,...       metrics aggregated in groups (mean, min, max)\n"
+            "\t-p min:col,...   pareto front of objectives, prefix min: or max:\n"
+            "\t-c col,...       columns to print (default all)\n"
+            "\t-n rows          max rows to print, 0 means all (default %d)\n",
+            name, name, name, RESDB_DEFAULT_LIMIT);
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    Resdb_query query = {
+        .num_filters = 0,
+        .group = NULL,
+        .metrics = NULL,
+        .pareto = NULL,
+        .columns = NULL,
+        .limit = RESDB_DEFAULT_LIMIT
+    };
+
+    if (argc >= 4 && strcmp(argv[1], "pack") == 0)
+        return resdb_pack(argv[2], argv[3]);
+
+    if (argc == 3 && strcmp(argv[1], "info") == 0)
+        return resdb_info(argv[2]);
+
+    if (argc < 3 || strcmp(argv[1], "query") != 0)
+    {
+        resdb_usage(argv[0]);
+        return 1;
+    }
+
+    while ((opt = getopt(argc - 1, argv + 1, "w:g:m:p:c:n:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'w':
+            {
+                if (query.num_filters == RESDB_MAX_FILTERS)
+                {
+                    fprintf(stderr, "At most %d filters\n", RESDB_MAX_FILTERS);
+                    return 1;
+                }
+
+                query.filter[query.num_filters++] = optarg;
+                break;
+            }
+            case 'g':
+                query.group = optarg;
+                break;
+            case 'm':
+                query.metrics = optarg;
+                break;
+            case 'p':
+                query.pareto = optarg;
+                break;
+            case 'c':
+                query.columns = optarg;
+                break;
+            case 'n':
+                query.limit = strtoull(optarg, NULL, 10);
+                break;
+            default:
+            {
+                resdb_usage(argv[0]);
+                return 1;
+            }
+        }
+    }
+
+    if (optind + 1 != argc - 1)
+    {
+        resdb_usage(argv[0]);
+        return 1;
+    }
+
+    return resdb_query(argv[optind + 1], &query);
+}